@@ -20,9 +20,11 @@ Module:    LassoImageTool.cxx
 #include <vtkImageReslice.h>
 #include <vtkImageData.h>
 #include <vtkPointData.h>
+#include <vtkDataArray.h>
 #include <vtkMatrix4x4.h>
 #include <vtkTransform.h>
 #include <vtkMath.h>
+#include <vtkCallbackCommand.h>
 
 #include <vtkMINCImageReader.h>
 #include <vtkDICOMImageReader.h>
@@ -38,13 +40,12 @@ Module:    LassoImageTool.cxx
 #include <vtkImageProperty.h>
 #include <vtkImageReslice.h>
 #include <vtkImageGaussianSmooth.h>
-#include <vtkPolyDataToImageStencil.h>
 #include <vtkDataSetMapper.h>
 #include <vtkActor.h>
 #include <vtkProperty.h>
 #include <vtkLookupTable.h>
 
-#include "vtkROIContourDataToPolyData.h"
+#include "vtkROIContourMaskUpdater.h"
 #include "vtkImageToROIContourData.h"
 #include "vtkROIContourData.h"
 
@@ -178,6 +179,13 @@ void SetViewFromMatrix(
   istyle->SetImageOrientation(viewRight, viewUp);
 }
 
+// Called before each render to convert the slices of the ROI that have
+// been edited since the last render into the mask.
+void UpdateMask(vtkObject *, unsigned long, void *clientData, void *)
+{
+  static_cast<vtkROIContourMaskUpdater *>(clientData)->Update();
+}
+
 };
 
 int main (int argc, char *argv[])
@@ -345,24 +353,33 @@ int main (int argc, char *argv[])
   lassoTool->SetROIMatrix(sourceMatrix);
   lassoTool->AddViewPropsToRenderer(renderer);
 
-  // convert the ROI into a new mask
-  vtkSmartPointer<vtkROIContourDataToPolyData> roiDataToPolyData =
-    vtkSmartPointer<vtkROIContourDataToPolyData>::New();
-  roiDataToPolyData->SET_INPUT_DATA(roiData);
-  roiDataToPolyData->SubdivisionOn();
-
-  vtkSmartPointer<vtkPolyDataToImageStencil> makeStencil =
-    vtkSmartPointer<vtkPolyDataToImageStencil>::New();
-  makeStencil->SetTolerance(0.0);
-  makeStencil->SetInputConnection(roiDataToPolyData->GetOutputPort());
-  makeStencil->SetInformationInput(sourceImage);
-  makeStencil->Update();
-
-  vtkSmartPointer<vtkImageReslice> applyStencil =
-    vtkSmartPointer<vtkImageReslice>::New();
-  applyStencil->SET_INPUT_DATA(sourceImage);
-  applyStencil->SetInputConnection(1, makeStencil->GetOutputPort());
-  applyStencil->Update();
+  // make a mask image with the same geometry as the source image
+  vtkSmartPointer<vtkImageData> maskImage =
+    vtkSmartPointer<vtkImageData>::New();
+  maskImage->CopyStructure(sourceImage);
+#if VTK_MAJOR_VERSION >= 6
+  maskImage->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+#else
+  maskImage->SetScalarTypeToUnsignedChar();
+  maskImage->SetNumberOfScalarComponents(1);
+  maskImage->AllocateScalars();
+#endif
+  maskImage->GetPointData()->GetScalars()->FillComponent(0, 0.0);
+
+  // convert the ROI into the mask, and keep the mask up to date
+  // while the ROI is edited
+  vtkSmartPointer<vtkROIContourMaskUpdater> maskUpdater =
+    vtkSmartPointer<vtkROIContourMaskUpdater>::New();
+  maskUpdater->SetROIContourData(roiData);
+  maskUpdater->SetImage(maskImage);
+  maskUpdater->SubdivisionOn();
+  maskUpdater->Update();
+
+  vtkSmartPointer<vtkCallbackCommand> maskCallback =
+    vtkSmartPointer<vtkCallbackCommand>::New();
+  maskCallback->SetCallback(UpdateMask);
+  maskCallback->SetClientData(maskUpdater);
+  renderWindow->AddObserver(vtkCommand::StartEvent, maskCallback);
 
   // display the new mask
   vtkSmartPointer<vtkImageResliceMapper> maskMapper =
@@ -370,7 +387,7 @@ int main (int argc, char *argv[])
   maskMapper->SliceFacesCameraOn();
   maskMapper->SliceAtFocalPointOn();
   maskMapper->JumpToNearestSliceOn();
-  maskMapper->SetInputConnection(applyStencil->GetOutputPort());
+  maskMapper->SET_INPUT_DATA(maskImage);
 
   vtkSmartPointer<vtkLookupTable> maskLUT =
     vtkSmartPointer<vtkLookupTable>::New();
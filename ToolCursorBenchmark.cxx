@@ -0,0 +1,1063 @@
+/*=========================================================================
+
+Program:   ToolCursor
+Module:    ToolCursorBenchmark.cxx
+
+   This software is distributed WITHOUT ANY WARRANTY; without even the
+   implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+=========================================================================*/
+
+// This program measures how long the cursor takes to respond to events.
+
+// It builds the same scene as the LassoImageTool example, with either
+// a synthetic volume or an image that is read from a file.  In "record"
+// mode, the session is interactive and the events that are seen by the
+// vtkToolCursorInteractorObserver are written to a trace file.  In
+// "replay" mode, the events from a trace file (or from a built-in trace,
+// if no file is given) are sent to an offscreen render window as fast
+// as possible, and the time taken for each event is reported.  Since
+// no display is needed for replay, it can be run on a machine that only
+// has software rendering.  With "--budget", the replay is paced by the
+// delays in the trace and the observer's FrameBudget is used, so that
+// the merging of motion events is measured as well.
+
+// The trace file is plain text.  The first line is a header that gives
+// the window size, and each following line is one event:
+//   code  milliseconds-since-previous  x  y  modifiers  [keysym]
+// where the modifiers are 1 for shift and 2 for control.
+
+#include <vtkSmartPointer.h>
+#include <vtkObjectFactory.h>
+#include <vtkCallbackCommand.h>
+#include <vtkTimerLog.h>
+#include <vtksys/SystemTools.hxx>
+
+#include <vtkImageReslice.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkMath.h>
+#include <vtkRTAnalyticSource.h>
+
+#include <vtkMINCImageReader.h>
+#include <vtkDICOMImageReader.h>
+
+#include <vtkRenderer.h>
+#include <vtkCamera.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderWindowInteractor.h>
+#include <vtkInteractorStyleImage.h>
+#include <vtkImageSlice.h>
+#include <vtkImageStack.h>
+#include <vtkImageResliceMapper.h>
+#include <vtkImageProperty.h>
+#include <vtkImageGaussianSmooth.h>
+#include <vtkPolyDataToImageStencil.h>
+#include <vtkLookupTable.h>
+
+#include "vtkROIContourDataToPolyData.h"
+#include "vtkImageToROIContourData.h"
+#include "vtkROIContourData.h"
+
+#include "vtkToolCursor.h"
+#include "vtkWindowLevelTool.h"
+#include "vtkSliceImageTool.h"
+#include "vtkPanCameraTool.h"
+#include "vtkZoomCameraTool.h"
+#include "vtkLassoImageTool.h"
+
+#include "vtkToolCursorInteractorObserver.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// A macro to assist VTK 5 backwards compatibility
+#if VTK_MAJOR_VERSION >= 6
+#define SET_INPUT_DATA SetInputData
+#else
+#define SET_INPUT_DATA SetInput
+#endif
+
+namespace {
+
+// The cursor does not make its current action public, so use a
+// subclass to find out which tool is handling each event.
+class BenchmarkToolCursor : public vtkToolCursor
+{
+public:
+  static BenchmarkToolCursor *New();
+  vtkTypeMacro(BenchmarkToolCursor, vtkToolCursor);
+
+  int GetCurrentAction() { return this->GetAction(); }
+
+protected:
+  BenchmarkToolCursor() {}
+  ~BenchmarkToolCursor() {}
+
+private:
+  BenchmarkToolCursor(const BenchmarkToolCursor&);  //Not implemented
+  void operator=(const BenchmarkToolCursor&);  //Not implemented
+};
+
+vtkStandardNewMacro(BenchmarkToolCursor);
+
+// The replay does not run an event loop, so use an interactor that keeps
+// its timers in a list and fires them while the replay waits.
+class ReplayInteractor : public vtkRenderWindowInteractor
+{
+public:
+  static ReplayInteractor *New();
+  vtkTypeMacro(ReplayInteractor, vtkRenderWindowInteractor);
+
+  // Wait until the given time, firing the timers that come due.
+  void WaitUntil(double t);
+
+  // Wait until all of the one-shot timers have fired.
+  void WaitForTimers();
+
+  int InternalCreateTimer(int timerId, int timerType,
+                          unsigned long duration);
+  int InternalDestroyTimer(int platformTimerId);
+
+protected:
+  ReplayInteractor() : LastPlatformTimerId(0) {}
+  ~ReplayInteractor() {}
+
+  struct Timer
+  {
+    double Time;
+    unsigned long Duration;
+  };
+
+  std::map<int, Timer> Timers;
+  int LastPlatformTimerId;
+
+private:
+  ReplayInteractor(const ReplayInteractor&);  //Not implemented
+  void operator=(const ReplayInteractor&);  //Not implemented
+};
+
+vtkStandardNewMacro(ReplayInteractor);
+
+int ReplayInteractor::InternalCreateTimer(
+  int, int, unsigned long duration)
+{
+  Timer timer;
+  timer.Time = vtkTimerLog::GetUniversalTime() + 0.001*duration;
+  timer.Duration = duration;
+  this->Timers[++this->LastPlatformTimerId] = timer;
+  return this->LastPlatformTimerId;
+}
+
+int ReplayInteractor::InternalDestroyTimer(int platformTimerId)
+{
+  return (this->Timers.erase(platformTimerId) != 0);
+}
+
+void ReplayInteractor::WaitUntil(double t)
+{
+  for (;;)
+    {
+    // Find the timer that is due first
+    std::map<int, Timer>::iterator next = this->Timers.end();
+    std::map<int, Timer>::iterator iter;
+    for (iter = this->Timers.begin(); iter != this->Timers.end(); ++iter)
+      {
+      if (next == this->Timers.end() || iter->second.Time < next->second.Time)
+        {
+        next = iter;
+        }
+      }
+
+    bool fire = (next != this->Timers.end() && next->second.Time <= t);
+    double due = (fire ? next->second.Time : t);
+    double wait = due - vtkTimerLog::GetUniversalTime();
+    if (wait > 0)
+      {
+      vtksys::SystemTools::Delay(static_cast<unsigned int>(wait*1000.0));
+      while (vtkTimerLog::GetUniversalTime() < due) {}
+      }
+
+    if (!fire)
+      {
+      break;
+      }
+
+    int timerId = this->GetVTKTimerId(next->first);
+    if (this->IsOneShotTimer(timerId))
+      {
+      this->Timers.erase(next);
+      }
+    else
+      {
+      next->second.Time = due + 0.001*next->second.Duration;
+      }
+    this->InvokeEvent(vtkCommand::TimerEvent, &timerId);
+    }
+}
+
+void ReplayInteractor::WaitForTimers()
+{
+  double last = vtkTimerLog::GetUniversalTime();
+  std::map<int, Timer>::iterator iter;
+  for (iter = this->Timers.begin(); iter != this->Timers.end(); ++iter)
+    {
+    int timerId = this->GetVTKTimerId(iter->first);
+    if (this->IsOneShotTimer(timerId) && iter->second.Time > last)
+      {
+      last = iter->second.Time;
+      }
+    }
+  this->WaitUntil(last);
+}
+
+// The events that are recorded, and their codes in the trace file
+struct TraceEventCode
+{
+  unsigned long Event;
+  char Code;
+};
+
+const TraceEventCode TraceEventCodes[] = {
+  { vtkCommand::MouseMoveEvent, 'M' },
+  { vtkCommand::LeftButtonPressEvent, 'L' },
+  { vtkCommand::LeftButtonReleaseEvent, 'l' },
+  { vtkCommand::MiddleButtonPressEvent, 'C' },
+  { vtkCommand::MiddleButtonReleaseEvent, 'c' },
+  { vtkCommand::RightButtonPressEvent, 'R' },
+  { vtkCommand::RightButtonReleaseEvent, 'r' },
+  { vtkCommand::MouseWheelForwardEvent, 'F' },
+  { vtkCommand::MouseWheelBackwardEvent, 'B' },
+  { vtkCommand::KeyPressEvent, 'K' },
+  { vtkCommand::KeyReleaseEvent, 'k' },
+  { vtkCommand::EnterEvent, 'E' },
+  { vtkCommand::LeaveEvent, 'X' },
+  { vtkCommand::NoEvent, '\0' }
+};
+
+// One event from a trace
+struct TraceEvent
+{
+  char Code;
+  int Delay;
+  int Position[2];
+  int Modifiers;
+  std::string KeySym;
+};
+
+char CodeFromEvent(unsigned long event)
+{
+  for (int i = 0; TraceEventCodes[i].Code != '\0'; i++)
+    {
+    if (TraceEventCodes[i].Event == event)
+      {
+      return TraceEventCodes[i].Code;
+      }
+    }
+  return '\0';
+}
+
+unsigned long EventFromCode(char code)
+{
+  for (int i = 0; TraceEventCodes[i].Code != '\0'; i++)
+    {
+    if (TraceEventCodes[i].Code == code)
+      {
+      return TraceEventCodes[i].Event;
+      }
+    }
+  return vtkCommand::NoEvent;
+}
+
+// Write the events to a trace file
+bool WriteTrace(const char *fileName, const int size[2],
+                const std::vector<TraceEvent> &events)
+{
+  std::ofstream outfile(fileName);
+  if (!outfile.good())
+    {
+    return false;
+    }
+
+  outfile << "ToolCursorTrace 1 " << size[0] << " " << size[1] << "\n";
+  for (size_t i = 0; i < events.size(); i++)
+    {
+    const TraceEvent &e = events[i];
+    outfile << e.Code << " " << e.Delay << " " << e.Position[0] << " "
+            << e.Position[1] << " " << e.Modifiers;
+    if (!e.KeySym.empty())
+      {
+      outfile << " " << e.KeySym;
+      }
+    outfile << "\n";
+    }
+
+  return outfile.good();
+}
+
+// Read the events from a trace file
+bool ReadTrace(const char *fileName, int size[2],
+               std::vector<TraceEvent> &events)
+{
+  std::ifstream infile(fileName);
+  std::string magic;
+  int version = 0;
+  infile >> magic >> version >> size[0] >> size[1];
+  if (!infile.good() || magic != "ToolCursorTrace" || version != 1)
+    {
+    return false;
+    }
+
+  std::string line;
+  std::getline(infile, line);
+  while (std::getline(infile, line))
+    {
+    TraceEvent e;
+    std::istringstream fields(line);
+    fields >> e.Code >> e.Delay >> e.Position[0] >> e.Position[1]
+           >> e.Modifiers;
+    if (fields.fail() || EventFromCode(e.Code) == vtkCommand::NoEvent)
+      {
+      continue;
+      }
+    fields >> e.KeySym;
+    events.push_back(e);
+    }
+
+  return true;
+}
+
+// Add an event to a synthetic trace
+void AddTraceEvent(std::vector<TraceEvent> &events, char code,
+                   int x, int y, int modifiers, const char *keysym = 0)
+{
+  TraceEvent e;
+  e.Code = code;
+  e.Delay = 16;
+  e.Position[0] = x;
+  e.Position[1] = y;
+  e.Modifiers = modifiers;
+  e.KeySym = (keysym ? keysym : "");
+  events.push_back(e);
+}
+
+// Add a drag with the given button and modifiers to a synthetic trace
+void AddTraceDrag(std::vector<TraceEvent> &events, const int size[2],
+                  char button, int modifiers, bool circle)
+{
+  const char *keysym = 0;
+  if (modifiers & 1) { keysym = "Shift_L"; }
+  if (modifiers & 2) { keysym = "Control_L"; }
+
+  double cx = 0.5*size[0];
+  double cy = 0.5*size[1];
+  double r = 0.2*(size[0] < size[1] ? size[0] : size[1]);
+  int x = static_cast<int>(cx + (circle ? r : 0.0));
+  int y = static_cast<int>(cy);
+
+  AddTraceEvent(events, 'M', x, y, 0);
+  if (keysym)
+    {
+    AddTraceEvent(events, 'K', x, y, modifiers, keysym);
+    }
+  AddTraceEvent(events, button, x, y, modifiers);
+
+  const int n = 100;
+  for (int i = 1; i <= n; i++)
+    {
+    if (circle)
+      {
+      double a = 2.0*vtkMath::Pi()*i/n;
+      x = static_cast<int>(cx + r*cos(a));
+      y = static_cast<int>(cy + r*sin(a));
+      }
+    else
+      {
+      x = static_cast<int>(cx + r*i/n);
+      y = static_cast<int>(cy + r*i/n);
+      }
+    AddTraceEvent(events, 'M', x, y, modifiers);
+    }
+
+  button = static_cast<char>(button - 'A' + 'a');
+  AddTraceEvent(events, button, x, y, modifiers);
+  if (keysym)
+    {
+    AddTraceEvent(events, 'k', x, y, 0, keysym);
+    }
+}
+
+// Build a trace that hovers over the image and uses every tool
+void MakeSyntheticTrace(const int size[2], std::vector<TraceEvent> &events)
+{
+  AddTraceEvent(events, 'E', size[0]/2, size[1]/2, 0);
+
+  // hover across the window, to measure picking
+  const int n = 400;
+  for (int i = 0; i <= n; i++)
+    {
+    AddTraceEvent(events, 'M', size[0]*i/n, size[1]*(n - i)/n, 0);
+    }
+
+  // the same bindings as in the LassoImageTool example
+  AddTraceDrag(events, size, 'L', 2, false); // window/level
+  AddTraceDrag(events, size, 'L', 1, false); // slice
+  AddTraceDrag(events, size, 'R', 1, false); // pan
+  AddTraceDrag(events, size, 'R', 0, false); // zoom
+  AddTraceDrag(events, size, 'L', 0, true);  // lasso
+
+  AddTraceEvent(events, 'X', 0, 0, 0);
+}
+
+// The data for recording the events
+struct RecordData
+{
+  std::vector<TraceEvent> Events;
+  double LastTime;
+};
+
+void RecordEvent(vtkObject *object, unsigned long event,
+                 void *clientdata, void *)
+{
+  vtkRenderWindowInteractor *iren =
+    static_cast<vtkRenderWindowInteractor *>(object);
+  RecordData *data = static_cast<RecordData *>(clientdata);
+
+  double t = vtkTimerLog::GetUniversalTime();
+  int delay = 0;
+  if (data->LastTime > 0)
+    {
+    delay = static_cast<int>((t - data->LastTime)*1000.0 + 0.5);
+    }
+  data->LastTime = t;
+
+  TraceEvent e;
+  e.Code = CodeFromEvent(event);
+  e.Delay = delay;
+  iren->GetEventPosition(e.Position);
+  e.Modifiers = ((iren->GetShiftKey() ? 1 : 0) |
+                 (iren->GetControlKey() ? 2 : 0));
+  if (event == vtkCommand::KeyPressEvent ||
+      event == vtkCommand::KeyReleaseEvent)
+    {
+    const char *keysym = iren->GetKeySym();
+    e.KeySym = (keysym ? keysym : "");
+    }
+  data->Events.push_back(e);
+}
+
+// Timing statistics for one kind of event
+struct TimingStats
+{
+  std::vector<double> Times;
+
+  void Report(const char *name)
+    {
+    int n = static_cast<int>(this->Times.size());
+    if (n == 0)
+      {
+      return;
+      }
+
+    std::sort(this->Times.begin(), this->Times.end());
+    double total = 0.0;
+    for (int i = 0; i < n; i++)
+      {
+      total += this->Times[i];
+      }
+
+    cout << "  " << name << ": " << n << " events, "
+         << (total > 0 ? n/total : 0.0) << " events/s, ms mean "
+         << 1000.0*total/n << " p50 " << 1000.0*Percentile(50)
+         << " p95 " << 1000.0*Percentile(95) << " p99 "
+         << 1000.0*Percentile(99) << " max " << 1000.0*this->Times[n-1]
+         << endl;
+    }
+
+  double Percentile(double p)
+    {
+    int n = static_cast<int>(this->Times.size());
+    int k = static_cast<int>(ceil(0.01*p*n)) - 1;
+    k = (k < 0 ? 0 : (k >= n ? n - 1 : k));
+    return this->Times[k];
+    }
+};
+
+// internal methods for reading images, these methods read the image
+// into the specified data object and also provide a matrix for converting
+// the data coordinates into patient coordinates.
+
+void ReadDICOMImage(
+  vtkImageData *data, vtkMatrix4x4 *matrix, const char *directoryName)
+{
+  // read the image
+  vtkSmartPointer<vtkDICOMImageReader> reader =
+    vtkSmartPointer<vtkDICOMImageReader>::New();
+
+  reader->SetDirectoryName(directoryName);
+  reader->Update();
+
+  // the reader flips the image and reverses the ordering, so undo these
+  vtkSmartPointer<vtkImageReslice> flip =
+    vtkSmartPointer<vtkImageReslice>::New();
+
+  flip->SetInputConnection(reader->GetOutputPort());
+  flip->SetResliceAxesDirectionCosines(
+    1,0,0, 0,-1,0, 0,0,-1);
+  flip->Update();
+
+  vtkImageData *image = flip->GetOutput();
+
+  // get the data
+  data->CopyStructure(image);
+  data->GetPointData()->PassData(image->GetPointData());
+  data->SetOrigin(0,0,0);
+
+  // generate the matrix
+  float *position = reader->GetImagePositionPatient();
+  float *orientation = reader->GetImageOrientationPatient();
+  float *xdir = &orientation[0];
+  float *ydir = &orientation[3];
+  float zdir[3];
+  vtkMath::Cross(xdir, ydir, zdir);
+
+  for (int i = 0; i < 3; i++)
+    {
+    matrix->Element[i][0] = xdir[i];
+    matrix->Element[i][1] = ydir[i];
+    matrix->Element[i][2] = zdir[i];
+    matrix->Element[i][3] = position[i];
+    }
+  matrix->Element[3][0] = 0;
+  matrix->Element[3][1] = 0;
+  matrix->Element[3][2] = 0;
+  matrix->Element[3][3] = 1;
+  matrix->Modified();
+}
+
+void ReadMINCImage(
+  vtkImageData *data, vtkMatrix4x4 *matrix, const char *fileName)
+{
+  // read the image
+  vtkSmartPointer<vtkMINCImageReader> reader =
+    vtkSmartPointer<vtkMINCImageReader>::New();
+
+  reader->SetFileName(fileName);
+  reader->Update();
+
+  double spacing[3];
+  reader->GetOutput()->GetSpacing(spacing);
+  spacing[0] = fabs(spacing[0]);
+  spacing[1] = fabs(spacing[1]);
+  spacing[2] = fabs(spacing[2]);
+
+  // flip the image rows into a DICOM-style ordering
+  vtkSmartPointer<vtkImageReslice> flip =
+    vtkSmartPointer<vtkImageReslice>::New();
+
+  flip->SetInputConnection(reader->GetOutputPort());
+  flip->SetResliceAxesDirectionCosines(
+    -1,0,0, 0,-1,0, 0,0,1);
+  flip->SetOutputSpacing(spacing);
+  flip->Update();
+
+  vtkImageData *image = flip->GetOutput();
+
+  // get the data
+  data->CopyStructure(image);
+  data->GetPointData()->PassData(image->GetPointData());
+
+  // generate the matrix, but modify to use DICOM coords
+  static double xyFlipMatrix[16] =
+    { -1, 0, 0, 0,  0, -1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1 };
+  // correct for the flip that was done earlier
+  vtkMatrix4x4::Multiply4x4(*reader->GetDirectionCosines()->Element,
+                            xyFlipMatrix, *matrix->Element);
+  // do the left/right, up/down dicom-to-minc transformation
+  vtkMatrix4x4::Multiply4x4(xyFlipMatrix, *matrix->Element, *matrix->Element);
+  matrix->Modified();
+}
+
+void MakeSyntheticImage(vtkImageData *data, vtkMatrix4x4 *matrix)
+{
+  // a smooth, blob-like volume with 1mm voxels
+  vtkSmartPointer<vtkRTAnalyticSource> source =
+    vtkSmartPointer<vtkRTAnalyticSource>::New();
+  source->SetWholeExtent(0, 191, 0, 191, 0, 127);
+  source->SetCenter(96.0, 96.0, 64.0);
+  source->Update();
+
+  vtkImageData *image = source->GetOutput();
+  data->CopyStructure(image);
+  data->GetPointData()->PassData(image->GetPointData());
+  data->SetOrigin(-96.0, -96.0, -64.0);
+  data->SetSpacing(1.0, 1.0, 1.0);
+
+  matrix->Identity();
+}
+
+void SetViewFromMatrix(
+  vtkRenderer *renderer,
+  vtkInteractorStyleImage *istyle,
+  vtkMatrix4x4 *matrix)
+{
+  istyle->SetCurrentRenderer(renderer);
+
+  // This view assumes the data uses the DICOM Patient Coordinate System.
+  // It provides a right-is-left view of axial and coronal images
+  double viewRight[4] = { 1.0, 0.0, 0.0, 0.0 };
+  double viewUp[4] = { 0.0, -1.0, 0.0, 0.0 };
+
+  matrix->MultiplyPoint(viewRight, viewRight);
+  matrix->MultiplyPoint(viewUp, viewUp);
+
+  istyle->SetImageOrientation(viewRight, viewUp);
+}
+
+void PrintUsage(const char *program)
+{
+  cout << "Usage: " << program << " [options] [image.mnc | dicomdir/]\n"
+       << "  --record file   record an interactive session to a trace\n"
+       << "  --replay file   replay a trace offscreen and report timings\n"
+       << "  --budget secs   pace the replay by the trace and merge motion\n"
+       << "                  events with the given frame budget\n"
+       << "  --synthetic file  write the built-in trace to a file\n"
+       << "With no options, the built-in trace is replayed.  If no image\n"
+       << "is given, then a synthetic volume is used." << endl;
+}
+
+} // end anonymous namespace
+
+int main (int argc, char *argv[])
+{
+  const char *recordFile = 0;
+  const char *replayFile = 0;
+  const char *syntheticFile = 0;
+  const char *imageFile = 0;
+  double frameBudget = 0.0;
+
+  for (int argi = 1; argi < argc; argi++)
+    {
+    std::string arg = argv[argi];
+    if (arg == "--record" && argi + 1 < argc)
+      {
+      recordFile = argv[++argi];
+      }
+    else if (arg == "--replay" && argi + 1 < argc)
+      {
+      replayFile = argv[++argi];
+      }
+    else if (arg == "--budget" && argi + 1 < argc)
+      {
+      frameBudget = atof(argv[++argi]);
+      }
+    else if (arg == "--synthetic" && argi + 1 < argc)
+      {
+      syntheticFile = argv[++argi];
+      }
+    else if (arg[0] != '-' && imageFile == 0)
+      {
+      imageFile = argv[argi];
+      }
+    else
+      {
+      PrintUsage(argv[0]);
+      return EXIT_FAILURE;
+      }
+    }
+
+  // -------------------------------------------------------
+  // get the trace
+
+  int windowSize[2] = { 512, 512 };
+  std::vector<TraceEvent> trace;
+
+  if (replayFile)
+    {
+    if (!ReadTrace(replayFile, windowSize, trace))
+      {
+      cerr << "Unable to read trace file " << replayFile << endl;
+      return EXIT_FAILURE;
+      }
+    }
+  else if (!recordFile)
+    {
+    MakeSyntheticTrace(windowSize, trace);
+    if (syntheticFile)
+      {
+      if (!WriteTrace(syntheticFile, windowSize, trace))
+        {
+        cerr << "Unable to write trace file " << syntheticFile << endl;
+        return EXIT_FAILURE;
+        }
+      return EXIT_SUCCESS;
+      }
+    }
+
+  // -------------------------------------------------------
+  // load the images
+
+  double startTime = vtkTimerLog::GetUniversalTime();
+
+  vtkSmartPointer<vtkImageData> sourceImage =
+    vtkSmartPointer<vtkImageData>::New();
+  vtkSmartPointer<vtkMatrix4x4> sourceMatrix =
+    vtkSmartPointer<vtkMatrix4x4>::New();
+  if (imageFile == 0)
+    {
+    MakeSyntheticImage(sourceImage, sourceMatrix);
+    }
+  else
+    {
+    size_t n = strlen(imageFile);
+    if (n > 4 && strcmp(&imageFile[n-4], ".mnc") == 0)
+      {
+      ReadMINCImage(sourceImage, sourceMatrix, imageFile);
+      }
+    else
+      {
+      ReadDICOMImage(sourceImage, sourceMatrix, imageFile);
+      }
+    }
+
+  // -------------------------------------------------------
+  // display the images
+
+  vtkSmartPointer<vtkRenderWindow> renderWindow =
+    vtkSmartPointer<vtkRenderWindow>::New();
+  vtkSmartPointer<vtkRenderer> renderer =
+    vtkSmartPointer<vtkRenderer>::New();
+  vtkSmartPointer<vtkRenderWindowInteractor> interactor;
+  vtkSmartPointer<ReplayInteractor> replayInteractor;
+  vtkSmartPointer<vtkInteractorStyleImage> istyle =
+    vtkSmartPointer<vtkInteractorStyleImage>::New();
+
+  if (recordFile)
+    {
+    interactor = vtkSmartPointer<vtkRenderWindowInteractor>::New();
+    }
+  else
+    {
+    replayInteractor = vtkSmartPointer<ReplayInteractor>::New();
+    interactor = replayInteractor;
+    renderWindow->OffScreenRenderingOn();
+    }
+
+  istyle->SetInteractionModeToImage3D();
+  interactor->SetInteractorStyle(istyle);
+  renderWindow->SetInteractor(interactor);
+  renderWindow->AddRenderer(renderer);
+
+  vtkSmartPointer<vtkImageSlice> sourceActor =
+    vtkSmartPointer<vtkImageSlice>::New();
+  vtkSmartPointer<vtkImageResliceMapper> sourceMapper =
+    vtkSmartPointer<vtkImageResliceMapper>::New();
+  vtkSmartPointer<vtkImageProperty> sourceProperty =
+    vtkSmartPointer<vtkImageProperty>::New();
+
+  sourceMapper->SET_INPUT_DATA(sourceImage);
+  sourceMapper->SliceAtFocalPointOn();
+  sourceMapper->SliceFacesCameraOn();
+  sourceMapper->JumpToNearestSliceOn();
+  sourceMapper->ResampleToScreenPixelsOff();
+
+  double sourceRange[2];
+  sourceImage->GetScalarRange(sourceRange);
+  sourceProperty->SetInterpolationTypeToLinear();
+  sourceProperty->SetColorWindow((sourceRange[1]-sourceRange[0]));
+  sourceProperty->SetColorLevel(0.5*(sourceRange[0]+sourceRange[1]));
+
+  sourceActor->SetMapper(sourceMapper);
+  sourceActor->SetProperty(sourceProperty);
+  sourceActor->SetUserMatrix(sourceMatrix);
+
+  vtkSmartPointer<vtkImageStack> imageStack =
+    vtkSmartPointer<vtkImageStack>::New();
+  imageStack->AddImage(sourceActor);
+
+  renderer->AddViewProp(imageStack);
+  renderer->SetBackground(0,0,0);
+
+  renderWindow->SetSize(windowSize);
+
+  double bounds[6], center[4];
+  sourceImage->GetBounds(bounds);
+  center[0] = 0.5*(bounds[0] + bounds[1]);
+  center[1] = 0.5*(bounds[2] + bounds[3]);
+  center[2] = 0.5*(bounds[4] + bounds[5]);
+  center[3] = 1.0;
+  sourceMatrix->MultiplyPoint(center, center);
+
+  vtkCamera *camera = renderer->GetActiveCamera();
+  renderer->ResetCamera();
+  camera->SetFocalPoint(center);
+  camera->ParallelProjectionOn();
+  camera->SetParallelScale(0.5*(bounds[3] - bounds[2]));
+  SetViewFromMatrix(renderer, istyle, sourceMatrix);
+  renderer->ResetCameraClippingRange();
+
+  renderWindow->Render();
+
+  // -------------------------------------------------------
+  // ToolCursor items
+
+  vtkSmartPointer<BenchmarkToolCursor> cursor =
+    vtkSmartPointer<BenchmarkToolCursor>::New();
+  cursor->SetRenderer(renderer);
+  cursor->SetScale(1.0);
+  cursor->LatencyTimingOn();
+  cursor->SetLatencyHistorySize(100000);
+
+  // Create all the tools
+  std::map<int, std::string> toolNames;
+
+  vtkSmartPointer<vtkWindowLevelTool> winlevTool =
+    vtkSmartPointer<vtkWindowLevelTool>::New();
+  int winlevId = cursor->AddAction(winlevTool);
+  toolNames[winlevId] = winlevTool->GetClassName();
+
+  vtkSmartPointer<vtkSliceImageTool> sliceTool =
+    vtkSmartPointer<vtkSliceImageTool>::New();
+  int sliceId = cursor->AddAction(sliceTool);
+  toolNames[sliceId] = sliceTool->GetClassName();
+
+  vtkSmartPointer<vtkPanCameraTool> panTool =
+    vtkSmartPointer<vtkPanCameraTool>::New();
+  int panId = cursor->AddAction(panTool);
+  toolNames[panId] = panTool->GetClassName();
+
+  vtkSmartPointer<vtkZoomCameraTool> zoomTool =
+    vtkSmartPointer<vtkZoomCameraTool>::New();
+  int zoomId = cursor->AddAction(zoomTool);
+  toolNames[zoomId] = zoomTool->GetClassName();
+
+  vtkSmartPointer<vtkLassoImageTool> lassoTool =
+    vtkSmartPointer<vtkLassoImageTool>::New();
+  int lassoId = cursor->AddAction(lassoTool);
+  toolNames[lassoId] = std::string(lassoTool->GetClassName()) +
+                       " (ROI editing)";
+
+  // Bind all the tools
+  cursor->BindAction(winlevId, 0, 0, VTK_TOOL_CONTROL | VTK_TOOL_B1);
+  cursor->BindAction(sliceId, 0, 0, VTK_TOOL_SHIFT | VTK_TOOL_B1);
+  cursor->BindAction(panId, 0, 0, VTK_TOOL_SHIFT | VTK_TOOL_B2);
+  cursor->BindAction(zoomId, 0, 0, VTK_TOOL_B2);
+  cursor->BindAction(lassoId, 0, 0, VTK_TOOL_B1);
+
+  // Don't interpolate between slices while slicing the image
+  sliceTool->JumpToNearestSliceOn();
+
+  // -------------------------------------------------------
+  // Region of Interest items
+
+  // blur the image to make a smoother mask
+  vtkSmartPointer<vtkImageGaussianSmooth> imageBlur =
+    vtkSmartPointer<vtkImageGaussianSmooth>::New();
+  imageBlur->SET_INPUT_DATA(sourceImage);
+  imageBlur->SetStandardDeviations(4,4,4);
+
+  // set threshold to the middle of the data range
+  double threshold = 0.5*(sourceRange[0]+sourceRange[1]);
+
+  // generate an ROI from the mask
+  vtkSmartPointer<vtkImageToROIContourData> maskToROI =
+    vtkSmartPointer<vtkImageToROIContourData>::New();
+  maskToROI->SetInputConnection(imageBlur->GetOutputPort());
+  maskToROI->SetValue(threshold);
+  maskToROI->Update();
+
+  // copy the ROI into a new data set so that we can edit it
+  vtkSmartPointer<vtkROIContourData> roiData =
+    vtkSmartPointer<vtkROIContourData>::New();
+  roiData->DeepCopy(maskToROI->GetOutput());
+
+  // add the ROI data to the tool
+  lassoTool->SetROIContourData(roiData);
+  lassoTool->SetROIMatrix(sourceMatrix);
+  lassoTool->AddViewPropsToRenderer(renderer);
+
+  // convert the ROI into a new mask
+  vtkSmartPointer<vtkROIContourDataToPolyData> roiDataToPolyData =
+    vtkSmartPointer<vtkROIContourDataToPolyData>::New();
+  roiDataToPolyData->SET_INPUT_DATA(roiData);
+  roiDataToPolyData->SubdivisionOn();
+
+  vtkSmartPointer<vtkPolyDataToImageStencil> makeStencil =
+    vtkSmartPointer<vtkPolyDataToImageStencil>::New();
+  makeStencil->SetTolerance(0.0);
+  makeStencil->SetInputConnection(roiDataToPolyData->GetOutputPort());
+  makeStencil->SetInformationInput(sourceImage);
+  makeStencil->Update();
+
+  vtkSmartPointer<vtkImageReslice> applyStencil =
+    vtkSmartPointer<vtkImageReslice>::New();
+  applyStencil->SET_INPUT_DATA(sourceImage);
+  applyStencil->SetInputConnection(1, makeStencil->GetOutputPort());
+  applyStencil->Update();
+
+  // display the new mask
+  vtkSmartPointer<vtkImageResliceMapper> maskMapper =
+    vtkSmartPointer<vtkImageResliceMapper>::New();
+  maskMapper->SliceFacesCameraOn();
+  maskMapper->SliceAtFocalPointOn();
+  maskMapper->JumpToNearestSliceOn();
+  maskMapper->SetInputConnection(applyStencil->GetOutputPort());
+
+  vtkSmartPointer<vtkLookupTable> maskLUT =
+    vtkSmartPointer<vtkLookupTable>::New();
+  maskLUT->SetHueRange(0.0, 0.0);
+  maskLUT->SetValueRange(1.0, 1.0);
+  maskLUT->SetSaturationRange(1.0, 1.0);
+  maskLUT->SetAlphaRange(0.0, 1.0);
+  maskLUT->SetRampToLinear();
+  maskLUT->Build();
+
+  vtkSmartPointer<vtkImageProperty> maskProperty =
+    vtkSmartPointer<vtkImageProperty>::New();
+  maskProperty->SetLookupTable(maskLUT);
+  maskProperty->SetColorWindow(1.0);
+  maskProperty->SetColorLevel(0.5);
+  maskProperty->SetInterpolationTypeToNearest();
+  maskProperty->SetLayerNumber(2);
+  maskProperty->SetOpacity(0.2);
+
+  vtkSmartPointer<vtkImageSlice> maskSlice =
+    vtkSmartPointer<vtkImageSlice>::New();
+  maskSlice->SetUserMatrix(sourceMatrix);
+  maskSlice->SetMapper(maskMapper);
+  maskSlice->SetProperty(maskProperty);
+
+  imageStack->AddImage(maskSlice);
+
+  vtkSmartPointer<vtkToolCursorInteractorObserver> observer =
+    vtkSmartPointer<vtkToolCursorInteractorObserver>::New();
+  observer->SetToolCursor(cursor);
+  observer->SetInteractor(interactor);
+
+  cout << "Setup time: " << vtkTimerLog::GetUniversalTime() - startTime
+       << " s" << endl;
+
+  // -------------------------------------------------------
+  // record an interactive session
+
+  if (recordFile)
+    {
+    // Observe the same events as the cursor, but before the cursor
+    RecordData data;
+    data.LastTime = 0.0;
+    vtkSmartPointer<vtkCallbackCommand> recorder =
+      vtkSmartPointer<vtkCallbackCommand>::New();
+    recorder->SetCallback(RecordEvent);
+    recorder->SetClientData(&data);
+    for (int i = 0; TraceEventCodes[i].Code != '\0'; i++)
+      {
+      interactor->AddObserver(TraceEventCodes[i].Event, recorder, 1.0);
+      }
+
+    observer->SetEnabled(1);
+    interactor->Start();
+    observer->SetEnabled(0);
+
+    if (!WriteTrace(recordFile, renderWindow->GetSize(), data.Events))
+      {
+      cerr << "Unable to write trace file " << recordFile << endl;
+      return EXIT_FAILURE;
+      }
+    cout << "Recorded " << data.Events.size() << " events" << endl;
+    return EXIT_SUCCESS;
+    }
+
+  // -------------------------------------------------------
+  // replay the trace
+
+  // Without a budget, render after every event and replay the events
+  // as fast as possible.  With a budget, the events are sent at the
+  // times given by the trace, and the observer merges motion events.
+  observer->SetFrameBudget(frameBudget);
+  interactor->Enable();
+  observer->SetEnabled(1);
+  observer->ResetStatistics();
+  cursor->ResetLatencyStatistics();
+
+  double eventTime = vtkTimerLog::GetUniversalTime();
+
+  std::map<std::string, TimingStats> stats;
+  TimingStats allEvents;
+
+  for (size_t i = 0; i < trace.size(); i++)
+    {
+    const TraceEvent &e = trace[i];
+    if (frameBudget > 0)
+      {
+      eventTime += 0.001*e.Delay;
+      replayInteractor->WaitUntil(eventTime);
+      }
+
+    interactor->SetEventInformation(
+      e.Position[0], e.Position[1], (e.Modifiers & 2), (e.Modifiers & 1),
+      0, 0, (e.KeySym.empty() ? 0 : e.KeySym.c_str()));
+
+    int actionBefore = cursor->GetCurrentAction();
+
+    double t = vtkTimerLog::GetUniversalTime();
+    interactor->InvokeEvent(EventFromCode(e.Code), 0);
+    t = vtkTimerLog::GetUniversalTime() - t;
+
+    // Events with no tool are dominated by picking
+    int action = cursor->GetCurrentAction();
+    action = (action ? action : actionBefore);
+    std::string name = "Picking (no tool)";
+    if (action && toolNames.find(action) != toolNames.end())
+      {
+      name = toolNames[action];
+      }
+
+    stats[name].Times.push_back(t);
+    allEvents.Times.push_back(t);
+    }
+
+  // Render any motion that is still being held back
+  replayInteractor->WaitForTimers();
+  observer->SetEnabled(0);
+
+  // -------------------------------------------------------
+  // report the timings
+
+  cout << "Per-event latency:" << endl;
+  for (std::map<std::string, TimingStats>::iterator iter = stats.begin();
+       iter != stats.end(); ++iter)
+    {
+    iter->second.Report(iter->first.c_str());
+    }
+  allEvents.Report("All events");
+
+  cout << "Cursor stages:" << endl;
+  for (int stage = 0; stage < VTK_TOOL_NUMBER_OF_STAGES; stage++)
+    {
+    int n = cursor->GetNumberOfStageLatencies(stage);
+    if (n > 0)
+      {
+      cout << "  " << vtkToolCursor::GetStageName(stage) << ": " << n
+           << " times, ms p50 " << 1000.0*cursor->GetStageLatencyP50(stage)
+           << " p95 " << 1000.0*cursor->GetStageLatencyP95(stage)
+           << " p99 " << 1000.0*cursor->GetStageLatencyP99(stage) << endl;
+      }
+    }
+  cout << "Pick cache hits " << cursor->GetPickCacheHits() << ", misses "
+       << cursor->GetPickCacheMisses() << endl;
+  if (frameBudget > 0)
+    {
+    cout << "Frame budget " << 1000.0*frameBudget << " ms, merged "
+         << observer->GetNumberOfCoalescedEvents() << " motion events"
+         << endl;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -14,26 +14,64 @@
 #include "vtkImageToROIContourData.h"
 
 #include "vtkROIContourData.h"
+#include "vtkROIContourSimplifier.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkObjectFactory.h"
 #include "vtkImageData.h"
-#include "vtkPolyData.h"
 #include "vtkPointData.h"
 #include "vtkPoints.h"
-#include "vtkCellArray.h"
+#include "vtkIntArray.h"
+#include "vtkIdTypeArray.h"
 #include "vtkMath.h"
-#include "vtkMergePoints.h"
 #include "vtkMarchingSquaresLineCases.h"
+#include "vtkMultiThreader.h"
+#include "vtkSmartPointer.h"
 #include "vtkTemplateAliasMacro.h"
 
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <limits>
+#include <math.h>
+#include <string.h>
+
+// SSE2 is part of every x86-64 processor
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VTK_ROI_CONTOUR_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 vtkStandardNewMacro(vtkImageToROIContourData);
 
 //----------------------------------------------------------------------------
 vtkImageToROIContourData::vtkImageToROIContourData()
 {
   this->Value = 0.5;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->Threader = vtkMultiThreader::New();
+  this->LabelMapMode = 0;
+  this->BackgroundLabel = 0;
+  this->Labels = vtkIntArray::New();
+  this->LabelStatistics = vtkIdTypeArray::New();
+  this->LabelStatistics->SetNumberOfComponents(3);
+  this->StreamedContours = vtkROIContourData::New();
+  this->IncrementalUpdate = 0;
+  this->Simplification = 1;
+  this->SimplificationTolerance = 0.0;
+  this->BoundaryTracing = 0;
+  this->HoleFlags = vtkIntArray::New();
+  this->PreviousContours = vtkROIContourData::New();
+  this->SliceContourCounts = vtkIntArray::New();
+  this->ContourMTime = 0;
+  this->DirtySlices[0] = VTK_INT_MAX;
+  this->DirtySlices[1] = VTK_INT_MIN;
+  for (int k = 0; k < 6; k++)
+    {
+    this->ContourExtent[k] = 0;
+    }
 
   this->SetNumberOfInputPorts(1);
   this->SetNumberOfOutputPorts(1);
@@ -42,6 +80,13 @@ vtkImageToROIContourData::vtkImageToROIContourData()
 //----------------------------------------------------------------------------
 vtkImageToROIContourData::~vtkImageToROIContourData()
 {
+  this->Threader->Delete();
+  this->Labels->Delete();
+  this->LabelStatistics->Delete();
+  this->StreamedContours->Delete();
+  this->PreviousContours->Delete();
+  this->SliceContourCounts->Delete();
+  this->HoleFlags->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -50,6 +95,76 @@ void vtkImageToROIContourData::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os,indent);
 
   os << indent << "Value: " << this->Value << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "LabelMapMode: "
+     << (this->LabelMapMode ? "On\n" : "Off\n");
+  os << indent << "BackgroundLabel: " << this->BackgroundLabel << "\n";
+  os << indent << "NumberOfLabels: " << this->GetNumberOfLabels() << "\n";
+  os << indent << "IncrementalUpdate: "
+     << (this->IncrementalUpdate ? "On\n" : "Off\n");
+  os << indent << "Simplification: "
+     << (this->Simplification ? "On\n" : "Off\n");
+  os << indent << "SimplificationTolerance: "
+     << this->SimplificationTolerance << "\n";
+  os << indent << "BoundaryTracing: "
+     << (this->BoundaryTracing ? "On\n" : "Off\n");
+}
+
+//----------------------------------------------------------------------------
+void vtkImageToROIContourData::AddLabel(int label)
+{
+  this->Labels->InsertNextValue(label);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageToROIContourData::RemoveAllLabels()
+{
+  if (this->Labels->GetNumberOfTuples() > 0)
+    {
+    this->Labels->Initialize();
+    this->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkImageToROIContourData::GetNumberOfLabels()
+{
+  return static_cast<int>(this->Labels->GetNumberOfTuples());
+}
+
+//----------------------------------------------------------------------------
+int vtkImageToROIContourData::GetLabel(int i)
+{
+  return this->Labels->GetValue(i);
+}
+
+//----------------------------------------------------------------------------
+int vtkImageToROIContourData::GetLabelContourCount(int label)
+{
+  vtkIdType n = this->LabelStatistics->GetNumberOfTuples();
+  for (vtkIdType i = 0; i < n; i++)
+    {
+    if (this->LabelStatistics->GetValue(3*i) == label)
+      {
+      return static_cast<int>(this->LabelStatistics->GetValue(3*i + 1));
+      }
+    }
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkImageToROIContourData::GetLabelPointCount(int label)
+{
+  vtkIdType n = this->LabelStatistics->GetNumberOfTuples();
+  for (vtkIdType i = 0; i < n; i++)
+    {
+    if (this->LabelStatistics->GetValue(3*i) == label)
+      {
+      return this->LabelStatistics->GetValue(3*i + 2);
+      }
+    }
+  return 0;
 }
 
 //----------------------------------------------------------------------------
@@ -119,407 +234,1619 @@ int vtkImageToROIContourData::ComputePipelineMTime(
 }
 
 //----------------------------------------------------------------------------
-int vtkImageToROIContourData::ProcessRequest(
-  vtkInformation* request,
-  vtkInformationVector** inputVector,
-  vtkInformationVector* outputVector)
+vtkDataObject *vtkImageToROIContourData::NewOutputData()
 {
-  // create data object
-  if (request->Has(vtkDemandDrivenPipeline::REQUEST_DATA_OBJECT()))
-    {
-    vtkInformation* info = outputVector->GetInformationObject(0);
-    vtkROIContourData *data = vtkROIContourData::SafeDownCast(
-      info->Get(vtkDataObject::DATA_OBJECT()));
-    if (!data)
-      {
-      data = vtkROIContourData::New();
-#if VTK_MAJOR_VERSION >= 6
-      info->Set(vtkDataObject::DATA_OBJECT(), data);
-#else
-      data->SetPipelineInformation(info);
-#endif
-      data->Delete();
-      }
-    return 1;
-    }
+  return vtkROIContourData::New();
+}
 
-  // generate the data
-  if (request->Has(vtkDemandDrivenPipeline::REQUEST_DATA()))
-    {
-    return this->RequestData(request, inputVector, outputVector);
-    }
+//----------------------------------------------------------------------------
+// The information that is shared by the threads.  Each slice has its own
+// list of contours, so that the threads do not have to synchronize, and
+// the lists are merged into the output in slice order.
+class vtkImageToROIContourDataThreadStruct
+{
+public:
+  struct Contour
+  {
+    vtkSmartPointer<vtkPoints> Points;
+    int Label;
+  };
+
+  typedef std::vector<Contour> ContourList;
+
+  vtkImageToROIContourData *Filter;
+  vtkImageData *Input;
+  int Extent[6];
+  double Value;
+  int LabelMapMode;
+  int BackgroundLabel;
+  std::vector<int> Labels;
+  int BoundaryTracing;
+  vtkROIContourSimplifier *Simplifier;
+  std::vector<ContourList> Slices;
+
+  static VTK_THREAD_RETURN_TYPE ThreadMain(void *arg);
+};
+
+//----------------------------------------------------------------------------
+// The line segments for one structure in one slice.  Instead of merging
+// points with a point locator, the points are indexed by the grid edge
+// that they lie on, and two rows of edge ids are kept while the slice is
+// swept.  A point that lands exactly on a grid vertex is indexed by the
+// vertex instead, since it can be shared by several edges.
+class vtkImageToROIContourDataLines
+{
+public:
+  // The label, and the slice that the lines are for
+  int Label;
+  int Slice;
+  // The last row that cells were added for
+  int Row;
+  // The points as x,y,z triples
+  std::vector<double> Points;
+  // The line segments as pairs of point ids
+  std::vector<vtkIdType> Lines;
+  // The first two line segments that use each point
+  std::vector<vtkIdType> Links;
+
+  vtkImageToROIContourDataLines() : Label(0), Slice(VTK_INT_MIN),
+    Row(VTK_INT_MIN), Size(0), HBottom(0), HTop(0), VRow(0),
+    VertBottom(0), VertTop(0) {}
+
+  // Remove all the lines, and make rows for n grid vertices.
+  void Initialize(int n);
+
+  // This must be called before cells are added for row j.
+  void StartRow(int j);
+
+  // This must be called after all cells are added for the row.
+  void FinishRow();
+
+  // Add the lines for the cell at position k in the row, given the
+  // scalars and coords at the corners of the cell.
+  void AddCell(int k, const double s[4], double value,
+               const double pts[4][2], double z);
+
+  // For sorting by label.
+  static bool LabelLess(const vtkImageToROIContourDataLines *a,
+                        const vtkImageToROIContourDataLines *b) {
+    return (a->Label < b->Label); }
+
+private:
+  // The point ids for the grid edges and vertices of two rows:
+  // horizontal edges at the bottom and top of the current row of cells,
+  // vertical edges within the row, and vertices at the bottom and top
+  std::vector<vtkIdType> EdgeIds;
+  int Size;
+  vtkIdType *HBottom;
+  vtkIdType *HTop;
+  vtkIdType *VRow;
+  vtkIdType *VertBottom;
+  vtkIdType *VertTop;
+};
+
+//----------------------------------------------------------------------------
+void vtkImageToROIContourDataLines::Initialize(int n)
+{
+  this->Points.clear();
+  this->Lines.clear();
+  this->Links.clear();
+  this->Row = VTK_INT_MIN;
+
+  this->Size = n;
+  this->EdgeIds.assign(5*n, -1);
+  this->HBottom = &this->EdgeIds[0];
+  this->HTop = this->HBottom + n;
+  this->VRow = this->HTop + n;
+  this->VertBottom = this->VRow + n;
+  this->VertTop = this->VertBottom + n;
+}
 
-  // tell inputs how to update
-  if (request->Has(vtkStreamingDemandDrivenPipeline::REQUEST_UPDATE_EXTENT()))
+//----------------------------------------------------------------------------
+void vtkImageToROIContourDataLines::StartRow(int j)
+{
+  // If the previous row was skipped, the bottom ids are out of date
+  if (this->Row != j - 1)
     {
-    vtkInformation* info = inputVector[0]->GetInformationObject(0);
-    int extent[6];
-    info->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), extent);
-    info->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent, 6);
-    return 1;
+    for (int k = 0; k < this->Size; k++)
+      {
+      this->HBottom[k] = -1;
+      this->VertBottom[k] = -1;
+      }
     }
+  this->Row = j;
+}
 
-  // execute information
-  if (request->Has(vtkDemandDrivenPipeline::REQUEST_INFORMATION()))
+//----------------------------------------------------------------------------
+void vtkImageToROIContourDataLines::FinishRow()
+{
+  vtkIdType *tmp = this->HBottom;
+  this->HBottom = this->HTop;
+  this->HTop = tmp;
+  tmp = this->VertBottom;
+  this->VertBottom = this->VertTop;
+  this->VertTop = tmp;
+  for (int k = 0; k < this->Size; k++)
     {
-    return 1;
+    this->HTop[k] = -1;
+    this->VRow[k] = -1;
+    this->VertTop[k] = -1;
     }
-
-  return this->Superclass::ProcessRequest(request, inputVector, outputVector);
 }
 
 //----------------------------------------------------------------------------
-// This code was taken from vtkMarchingSquares and modified so that it
-// does not break the contours at the edges of the image.
-namespace {
-template <class T>
-void vtkContourImage(
-  T *scalars, vtkDataArray *newScalars, int extent[6], int dir[3],
-  int start[2], int end[2], vtkIdType offset[3], double spacing[3],
-  double origin[3], double *values, int numValues,
-  vtkIncrementalPointLocator *p, vtkCellArray *lines)
-{
-  int i, j;
-  vtkIdType ptIds[2];
-  double t, *x1, *x2, x[3], xp, yp;
-  double pts[4][3];
-  int contNum, jOffset, idx, ii, jj, index, *vert;
-  static int CASE_MASK[4] = {1,2,8,4};
-  vtkMarchingSquaresLineCases *lineCase, *lineCases;
-  static int edges[4][2] = { {0,1}, {1,3}, {2,3}, {0,2} };
-  EDGE_LIST  *edge;  // EDGE_LIST is a typedef for int
-
-  if (numValues < 1)
+// This code was derived from vtkMarchingSquares.
+void vtkImageToROIContourDataLines::AddCell(
+  int k, const double s[4], double value, const double pts[4][2], double z)
+{
+  static const int CASE_MASK[4] = {1,2,8,4};
+  static const int edges[4][2] = { {0,1}, {1,3}, {2,3}, {0,2} };
+
+  // Build the case table
+  int index = 0;
+  for (int ii = 0; ii < 4; ii++)
     {
-    return;
+    if (s[ii] >= value)
+      {
+      index |= CASE_MASK[ii];
+      }
     }
-
-  // Get minval/maxval contour values
-  double minval = values[0];
-  double maxval = values[0];
-  for (i = 1; i < numValues; i++)
+  if (index == 0 || index == 15)
     {
-    if (values[i] < minval) { minval = values[i]; }
-    if (values[i] > maxval) { maxval = values[i]; }
+    return; //no lines
     }
 
-  lineCases = vtkMarchingSquaresLineCases::GetCases();
-
-  // assign coordinate value to non-varying coordinate direction
-  x[dir[2]] = origin[dir[2]] + extent[dir[2]*2]*spacing[dir[2]];
-
-  // Traverse pixel cells, generating line segments using marching squares.
-  for (j = extent[start[1]] - 1; j <= extent[end[1]]; j++)
+  // The id slots for the edges and vertices of this pixel
+  vtkIdType *edgeSlots[4] =
+    { &this->HBottom[k], &this->VRow[k+1], &this->HTop[k], &this->VRow[k] };
+  vtkIdType *vertSlots[4] =
+    { &this->VertBottom[k], &this->VertBottom[k+1],
+      &this->VertTop[k], &this->VertTop[k+1] };
+
+  vtkMarchingSquaresLineCases *lineCases =
+    vtkMarchingSquaresLineCases::GetCases();
+  EDGE_LIST *edge = lineCases[index].edges;
+  for (; edge[0] > -1; edge += 2)
     {
-    jOffset = j*offset[1];
-    pts[0][dir[1]] = origin[dir[1]] + j*spacing[dir[1]];
-    yp = origin[dir[1]] + (j+1)*spacing[dir[1]];
-
-    for (i = extent[start[0]] - 1; i <= extent[end[0]]; i++)
+    // insert line
+    vtkIdType ptIds[2];
+    for (int ii = 0; ii < 2; ii++)
       {
-      // get scalar values
-      idx = i*offset[0] + jOffset + offset[2];
-      double s[4];
-      s[0] = VTK_DOUBLE_MIN;
-      s[1] = VTK_DOUBLE_MIN;
-      s[2] = VTK_DOUBLE_MIN;
-      s[3] = VTK_DOUBLE_MIN;
-      if (i >= extent[start[0]] && j >= extent[start[1]])
-        {
-        s[0] = scalars[idx];
-        }
-      if (i < extent[end[0]] && j >= extent[start[1]])
+      const int *vert = edges[edge[ii]];
+      double t = (value - s[vert[0]])/(s[vert[1]] - s[vert[0]]);
+      const double *x1 = pts[vert[0]];
+      const double *x2 = pts[vert[1]];
+
+      //only need to interpolate two values
+      double x[2];
+      x[0] = x1[0] + t * (x2[0] - x1[0]);
+      x[1] = x1[1] + t * (x2[1] - x1[1]);
+
+      vtkIdType *slot = edgeSlots[edge[ii]];
+      if (x[0] == x1[0] && x[1] == x1[1])
         {
-        s[1] = scalars[idx + offset[0]];
+        slot = vertSlots[vert[0]];
         }
-      if (i >= extent[start[0]] && j < extent[end[1]])
+      else if (x[0] == x2[0] && x[1] == x2[1])
         {
-        s[2] = scalars[idx + offset[1]];
-        }
-      if (i < extent[end[0]] && j < extent[end[1]])
-        {
-        s[3] = scalars[idx + offset[0] + offset[1]];
+        slot = vertSlots[vert[1]];
         }
 
-      if ((s[0] < minval && s[1] < minval &&
-           s[2] < minval && s[3] < minval) ||
-          (s[0] > maxval && s[1] > maxval &&
-           s[2] > maxval && s[3] > maxval))
+      if (*slot < 0)
         {
-        // no contours possible
-        continue;
+        *slot = static_cast<vtkIdType>(this->Points.size()/3);
+        this->Points.push_back(x[0]);
+        this->Points.push_back(x[1]);
+        this->Points.push_back(z);
+        this->Links.push_back(-1);
+        this->Links.push_back(-1);
         }
+      ptIds[ii] = *slot;
+      }
 
-      //create pixel points
-      pts[0][dir[0]] = origin[dir[0]] + i*spacing[dir[0]];
-      xp = origin[dir[0]] + (i+1)*spacing[dir[0]];
-
-      pts[1][dir[0]] = xp;
-      pts[1][dir[1]] = pts[0][dir[1]];
-
-      pts[2][dir[0]] = pts[0][dir[0]];
-      pts[2][dir[1]] = yp;
-
-      pts[3][dir[0]] = xp;
-      pts[3][dir[1]] = yp;
-
-      // Loop over contours in this pixel
-      for (contNum = 0; contNum < numValues; contNum++)
+    if (ptIds[0] != ptIds[1]) //check for degenerate line
+      {
+      vtkIdType lineId = static_cast<vtkIdType>(this->Lines.size()/2);
+      this->Lines.push_back(ptIds[0]);
+      this->Lines.push_back(ptIds[1]);
+      for (int ii = 0; ii < 2; ii++)
         {
-        double value = values[contNum];
-
-        // Build the case table
-        index = 0;
-        for (ii = 0; ii < 4; ii++)
-          {
-          if (s[ii] >= value)
-            {
-            index |= CASE_MASK[ii];
-            }
-          }
-        if (index == 0 || index == 15)
+        vtkIdType *link = &this->Links[2*ptIds[ii]];
+        link += (link[0] >= 0);
+        if (link[0] < 0)
           {
-          continue; //no lines
+          link[0] = lineId;
           }
+        }
+      }
+    }//for each line
+}
 
-        lineCase = lineCases + index;
-        edge = lineCase->edges;
+//----------------------------------------------------------------------------
+// Scratch space for contouring a slice.  Each thread keeps one of these,
+// so that memory is only allocated when a slice needs more than before.
+class vtkImageToROIContourDataScratch
+{
+public:
+  // The lines when contouring at an isovalue
+  vtkImageToROIContourDataLines Lines;
+  // The lines for each label, kept so that their memory can be reused
+  std::map<int, vtkImageToROIContourDataLines> LabelLines;
+  // The labels that were found in the current slice and the current row
+  std::vector<vtkImageToROIContourDataLines *> SliceLines;
+  std::vector<vtkImageToROIContourDataLines *> RowLines;
+  // The classification of the pixels in two rows, and the active cells
+  std::vector<unsigned char> Flags;
+  std::vector<int> LabelRows;
+  std::vector<int> ActiveCells;
+  // The points of the contour that is being chained
+  std::vector<double> Chain;
+  // The cracks that have been visited when tracing boundaries
+  std::vector<unsigned char> Visited;
+};
 
-        for (; edge[0] > -1; edge += 2)
-          {
-          // insert line
-          for (ii = 0; ii < 2; ii++)
-            {
-            vert = edges[edge[ii]];
-            t = (value - s[vert[0]])/(s[vert[1]] - s[vert[0]]);
-            x1 = pts[vert[0]];
-            x2 = pts[vert[1]];
-
-            //only need to interpolate two values
-            for (jj = 0; jj < 2; jj++)
-              {
-              x[dir[jj]] = x1[dir[jj]] + t * (x2[dir[jj]] - x1[dir[jj]]);
-              }
-
-            if (p->InsertUniquePoint(x, ptIds[ii]) && newScalars)
-              {
-              newScalars->InsertComponent(ptIds[ii], 0, value);
-              }
-            }
-
-          if (ptIds[0] != ptIds[1]) //check for degenerate line
-            {
-            lines->InsertNextCell(2, ptIds);
-            }
-
-          }//for each line
-        }//for all contours
-      }//for i
-    }//for j
-}
-} // end anonymous namespace
+//----------------------------------------------------------------------------
+// The contouring is done row by row.  Before each row of cells is
+// contoured, the pixels are classified, and only the cells that might
+// contain lines (the "active" cells) are visited.  The classification
+// loops have no branches, so that the compiler can vectorize them, and
+// the contiguous cases also have SSE2 versions that classify sixteen
+// pixels at a time.  The SSE2 functions return the number of pixels
+// that they did, and the scalar loops do the rest.
+namespace {
 
+#ifdef VTK_ROI_CONTOUR_USE_SSE2
 //----------------------------------------------------------------------------
-void vtkImageToROIContourData::MarchingSquares(
-  vtkImageData *input, vtkPolyData *output, int extent[6], double value)
+// Pack four vectors of 32-bit masks into sixteen 8-bit masks.
+inline __m128i vtkPackMasks32(__m128i a, __m128i b, __m128i c, __m128i d)
 {
-  void *inPtr = input->GetScalarPointerForExtent(extent);
-  double *spacing = input->GetSpacing();
-  double *origin = input->GetOrigin();
-  int *inExt = input->GetExtent();
+  return _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+}
 
-  vtkIdType offset[3];
-  offset[0] = input->GetNumberOfScalarComponents();
-  offset[1] = offset[0]*(inExt[1] - inExt[0] + 1);
-  offset[2] = -(offset[0]*extent[0] + offset[1]*extent[2]);
+//----------------------------------------------------------------------------
+// Compare four doubles against a value, giving four 32-bit masks.
+inline __m128i vtkCompareGE(__m128d lo, __m128d hi, __m128d v)
+{
+  return _mm_castps_si128(_mm_shuffle_ps(
+    _mm_castpd_ps(_mm_cmpge_pd(lo, v)), _mm_castpd_ps(_mm_cmpge_pd(hi, v)),
+    _MM_SHUFFLE(2, 0, 2, 0)));
+}
 
-  double bounds[6];
-  bounds[0] = extent[0]*spacing[0] + origin[0];
-  bounds[1] = extent[1]*spacing[0] + origin[0];
-  bounds[2] = extent[2]*spacing[1] + origin[1];
-  bounds[3] = extent[3]*spacing[1] + origin[1];
-  bounds[4] = extent[4]*spacing[2] + origin[2];
-  bounds[5] = extent[5]*spacing[2] + origin[2];
+//----------------------------------------------------------------------------
+// Compare four floats against a value, after conversion to double so
+// that the result is the same as for the scalar loop.
+inline __m128i vtkCompareGE(const float *p, __m128d v)
+{
+  __m128 f = _mm_loadu_ps(p);
+  return vtkCompareGE(_mm_cvtps_pd(f), _mm_cvtps_pd(_mm_movehl_ps(f, f)), v);
+}
 
-  double values[1] = { value };
-  int numValues = 1;
-  int dir[3] = { 0, 1, 2 };
-  int start[2] = { 0, 2 };
-  int end[2] = { 1, 3 };
+//----------------------------------------------------------------------------
+inline __m128i vtkCompareGE(const double *p, __m128d v)
+{
+  return vtkCompareGE(_mm_loadu_pd(p), _mm_loadu_pd(p + 2), v);
+}
 
-  vtkPoints *points = vtkPoints::New(VTK_DOUBLE);
-  vtkMergePoints *locator = vtkMergePoints::New();
-  locator->InitPointInsertion(points, bounds);
-  vtkCellArray *lines = vtkCellArray::New();
+//----------------------------------------------------------------------------
+inline __m128i vtkLoad(const void *p)
+{
+  return _mm_loadu_si128(static_cast<const __m128i *>(p));
+}
 
-  vtkDataArray *newScalars = NULL;
+//----------------------------------------------------------------------------
+// Store sixteen flags, given masks that are set where the flag is zero.
+inline void vtkStoreInvertedFlags(unsigned char *flags, __m128i m)
+{
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(flags),
+                   _mm_andnot_si128(m, _mm_set1_epi8(1)));
+}
 
-  switch (input->GetScalarType())
+//----------------------------------------------------------------------------
+// Set flags for the integer pixels that are at or above the threshold.
+inline int vtkClassifyRowSSE2(
+  const unsigned char *row, int n, unsigned char t, unsigned char *flags)
+{
+  __m128i tv = _mm_set1_epi8(static_cast<char>(t));
+  int i = 0;
+  for (; i + 16 <= n; i += 16)
     {
-    vtkTemplateAliasMacro(
-      vtkContourImage(static_cast<VTK_TT*>(inPtr), newScalars,
-                      extent, dir, start, end, offset, spacing, origin,
-                      values, numValues, locator, lines);
-      );
+    __m128i v = vtkLoad(row + i);
+    // The pixel is below the threshold if max(v,t) is not v
+    vtkStoreInvertedFlags(flags + i, _mm_xor_si128(
+      _mm_cmpeq_epi8(_mm_max_epu8(v, tv), v), _mm_set1_epi8(-1)));
     }
+  return i;
+}
 
-  output->SetPoints(points);
-  output->SetLines(lines);
-
-  locator->Delete();
-  points->Delete();
-  lines->Delete();
+inline int vtkClassifyRowSSE2(
+  const signed char *row, int n, signed char t, unsigned char *flags)
+{
+  __m128i tv = _mm_set1_epi8(t);
+  int i = 0;
+  for (; i + 16 <= n; i += 16)
+    {
+    vtkStoreInvertedFlags(flags + i, _mm_cmpgt_epi8(tv, vtkLoad(row + i)));
+    }
+  return i;
 }
 
-//----------------------------------------------------------------------------
-namespace {
-void vtkReducePoints(vtkPoints *contourPoints)
+inline int vtkClassifyRowSSE2(
+  const char *row, int n, char t, unsigned char *flags)
 {
-  vtkPoints *points = vtkPoints::New(VTK_DOUBLE);
-  vtkIdType m = contourPoints->GetNumberOfPoints();
+  if (std::numeric_limits<char>::is_signed)
+    {
+    return vtkClassifyRowSSE2(reinterpret_cast<const signed char *>(row),
+                              n, static_cast<signed char>(t), flags);
+    }
+  return vtkClassifyRowSSE2(reinterpret_cast<const unsigned char *>(row),
+                            n, static_cast<unsigned char>(t), flags);
+}
 
-  if (m <= 4)
+// Unsigned values are compared as signed values after flipping the sign
+// bit, since SSE2 only has signed comparisons for 16 and 32 bits
+inline int vtkClassifyRowSSE2(
+  const short *row, int n, short t, unsigned char *flags, int bias = 0)
+{
+  __m128i bv = _mm_set1_epi16(static_cast<short>(bias));
+  __m128i tv = _mm_xor_si128(_mm_set1_epi16(t), bv);
+  int i = 0;
+  for (; i + 16 <= n; i += 16)
     {
-    return;
+    __m128i a = _mm_xor_si128(vtkLoad(row + i), bv);
+    __m128i b = _mm_xor_si128(vtkLoad(row + i + 8), bv);
+    vtkStoreInvertedFlags(flags + i, _mm_packs_epi16(
+      _mm_cmpgt_epi16(tv, a), _mm_cmpgt_epi16(tv, b)));
     }
+  return i;
+}
 
-  // Compute the curvature at each point
-  double p0[3], p1[3];
-  contourPoints->GetPoint(m-1, p1);
-  contourPoints->GetPoint(0, p0);
+inline int vtkClassifyRowSSE2(
+  const unsigned short *row, int n, unsigned short t, unsigned char *flags)
+{
+  return vtkClassifyRowSSE2(reinterpret_cast<const short *>(row), n,
+                            static_cast<short>(t), flags, 0x8000);
+}
 
-  double dx0 = (p0[0] - p1[0]);
-  double dy0 = (p0[1] - p1[1]);
-  double dz0 = (p0[2] - p1[2]);
-  double d0 = sqrt(dx0*dx0 + dy0*dy0 + dz0*dz0);
+inline int vtkClassifyRowSSE2(
+  const int *row, int n, int t, unsigned char *flags, int bias = 0)
+{
+  __m128i bv = _mm_set1_epi32(bias);
+  __m128i tv = _mm_xor_si128(_mm_set1_epi32(t), bv);
+  int i = 0;
+  for (; i + 16 <= n; i += 16)
+    {
+    __m128i m[4];
+    for (int l = 0; l < 4; l++)
+      {
+      m[l] = _mm_cmpgt_epi32(tv, _mm_xor_si128(vtkLoad(row + i + 4*l), bv));
+      }
+    vtkStoreInvertedFlags(flags + i, vtkPackMasks32(m[0], m[1], m[2], m[3]));
+    }
+  return i;
+}
 
-  double dskip = d0;
+inline int vtkClassifyRowSSE2(
+  const unsigned int *row, int n, unsigned int t, unsigned char *flags)
+{
+  return vtkClassifyRowSSE2(reinterpret_cast<const int *>(row), n,
+                            static_cast<int>(t), flags, VTK_INT_MIN);
+}
 
-  vtkIdType n = 0;
-  for (vtkIdType j = 0; j < m; j++)
+//----------------------------------------------------------------------------
+// Set flags for the real pixels that are at or above the value.
+template <class T>
+inline int vtkClassifyRealRowSSE2(
+  const T *row, int n, double value, unsigned char *flags)
+{
+  __m128d v = _mm_set1_pd(value);
+  int i = 0;
+  for (; i + 16 <= n; i += 16)
     {
-    int jp1 = (j + 1) % m;
-    contourPoints->GetPoint(jp1, p1);
-
-    double dx1 = (p1[0] - p0[0]);
-    double dy1 = (p1[1] - p0[1]);
-    double dz1 = (p1[2] - p0[2]);
-    double d1 = sqrt(dx1*dx1 + dy1*dy1 + dz1*dz1);
+    __m128i m = vtkPackMasks32(
+      vtkCompareGE(row + i, v), vtkCompareGE(row + i + 4, v),
+      vtkCompareGE(row + i + 8, v), vtkCompareGE(row + i + 12, v));
+    vtkStoreInvertedFlags(flags + i, _mm_xor_si128(m, _mm_set1_epi8(-1)));
+    }
+  return i;
+}
 
-    double f = 2.0/(d0 + d1);
-    double f0 = f/d0;
-    double f1 = f/d1;
-    double ddx = dx1*f1 - dx0*f0;
-    double ddy = dy1*f1 - dy0*f0;
-    double ddz = dz1*f1 - dz0*f0;
+inline int vtkClassifyRowSSE2(
+  const float *row, int n, double value, unsigned char *flags)
+{
+  return vtkClassifyRealRowSSE2(row, n, value, flags);
+}
 
-    double curvature = sqrt(ddx*ddx + ddy*ddy + ddz*ddz);
+inline int vtkClassifyRowSSE2(
+  const double *row, int n, double value, unsigned char *flags)
+{
+  return vtkClassifyRealRowSSE2(row, n, value, flags);
+}
 
-    dskip += d1;
-    if (dskip*curvature > 15 || (n + m - j - 1) <= 4)
+//----------------------------------------------------------------------------
+// Mark the cells whose four labels are not all the same.
+inline int vtkCompareLabelRowsSSE2(
+  const int *bottom, const int *top, int k, int end, unsigned char *work)
+{
+  for (; k + 16 <= end; k += 16)
+    {
+    __m128i m[4];
+    for (int l = 0; l < 4; l++)
       {
-      points->InsertNextPoint(p0);
-      n++;
-      dskip = d1;
+      int c = k + 4*l;
+      __m128i b0 = vtkLoad(bottom + c);
+      __m128i t0 = vtkLoad(top + c);
+      m[l] = _mm_and_si128(
+        _mm_and_si128(_mm_cmpeq_epi32(b0, vtkLoad(bottom + c + 1)),
+                      _mm_cmpeq_epi32(b0, t0)),
+        _mm_cmpeq_epi32(t0, vtkLoad(top + c + 1)));
       }
-
-    p0[0] = p1[0];
-    p0[1] = p1[1];
-    p0[2] = p1[2];
-
-    dx0 = dx1;
-    d0 = d1;
+    vtkStoreInvertedFlags(work + k, vtkPackMasks32(m[0], m[1], m[2], m[3]));
     }
-
-  contourPoints->DeepCopy(points);
-  points->Delete();
+  return k;
 }
+#else
+inline int vtkCompareLabelRowsSSE2(
+  const int *, const int *, int k, int, unsigned char *)
+{
+  return k;
 }
+#endif
 
 //----------------------------------------------------------------------------
-int vtkImageToROIContourData::RequestData(
-  vtkInformation *vtkNotUsed(request),
-  vtkInformationVector **inputVector,
-  vtkInformationVector *outputVector)
+// The types that do not have an SSE2 version.
+template <class T, class U>
+inline int vtkClassifyRowSSE2(const T *, int, U, unsigned char *)
 {
-  // Get the info objects
-  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
-  vtkInformation *outInfo = outputVector->GetInformationObject(0);
-
-  // Get the input and output
-  vtkImageData *input = vtkImageData::SafeDownCast(
-    inInfo->Get(vtkDataObject::DATA_OBJECT()));
-  vtkROIContourData *output = vtkROIContourData::SafeDownCast(
-    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+  return 0;
+}
 
-  // Create filters to do the work
-  vtkPolyData *sliceContours = vtkPolyData::New();
+//----------------------------------------------------------------------------
+// Set flags to 1 for pixels that are at or above the isovalue.
+template <class T>
+void vtkClassifyRow(
+  const T *row, vtkIdType inc, int n, double value, unsigned char *flags)
+{
+  if (std::numeric_limits<T>::is_integer && sizeof(T) <= 4)
+    {
+    // Use an integer threshold, to avoid conversion to double
+    double c = ceil(value);
+    if (!(c <= static_cast<double>(std::numeric_limits<T>::max())))
+      {
+      memset(flags, 0, n);
+      }
+    else if (c <= static_cast<double>(std::numeric_limits<T>::min()))
+      {
+      memset(flags, 1, n);
+      }
+    else
+      {
+      T t = static_cast<T>(c);
+      if (inc == 1)
+        {
+        for (int i = vtkClassifyRowSSE2(row, n, t, flags); i < n; i++)
+          {
+          flags[i] = (row[i] >= t);
+          }
+        }
+      else
+        {
+        for (int i = 0; i < n; i++)
+          {
+          flags[i] = (row[i*inc] >= t);
+          }
+        }
+      }
+    }
+  else
+    {
+    int i = (inc == 1 ? vtkClassifyRowSSE2(row, n, value, flags) : 0);
+    for (; i < n; i++)
+      {
+      flags[i] = (row[i*inc] >= value);
+      }
+    }
+}
 
-  // Go through the input slice by slice
-  int extent[6];
-  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), extent);
-  int zMin = extent[4];
-  int zMax = extent[5];
+//----------------------------------------------------------------------------
+// Get the labels for a row of pixels.
+template <class T>
+void vtkLabelRow(const T *row, vtkIdType inc, int n, int *labels)
+{
+  for (int i = 0; i < n; i++)
+    {
+    labels[i] = static_cast<int>(row[i*inc]);
+    }
+}
 
-  // The isovalue for the contour
-  double value = this->Value;
-  vtkIdList *cellIds = vtkIdList::New();
-  cellIds->Allocate(2);
+//----------------------------------------------------------------------------
+// Make a list of the nonzero entries of the work array, which must be
+// padded with zeros to a multiple of eight.
+void vtkCollectActiveCells(
+  const unsigned char *work, int n, std::vector<int> *activeCells)
+{
+  activeCells->clear();
 
-  for (int zIdx = zMin; zIdx <= zMax; zIdx++)
+  // Skip over the uniform regions a word at a time
+  for (int k = 0; k < n; k += 8)
     {
-    // Process and get output
-    extent[4] = zIdx;
-    extent[5] = zIdx;
-    this->MarchingSquares(input, sliceContours, extent, value);
-    sliceContours->BuildCells();
-    sliceContours->BuildLinks();
-    vtkPoints *slicePoints = sliceContours->GetPoints();
-    vtkCellArray *sliceLines = sliceContours->GetLines();
-
-    // Add contours to output
-    vtkIdType numCells = sliceLines->GetNumberOfCells();
-    int contourId = output->GetNumberOfContours();
-    output->SetNumberOfContours(contourId + numCells);
-    for (vtkIdType j = 0; j < numCells; j++)
-      {
-      vtkIdType currentId = j;
-      vtkIdType numPts, *ptIds;
-      sliceLines->GetCell(3*currentId, numPts, ptIds);
-      if (ptIds[0] >= 0)
+    vtkTypeUInt64 word;
+    memcpy(&word, &work[k], 8);
+    if (word != 0)
+      {
+      for (int l = k; l < k + 8; l++)
         {
-        vtkPoints *points = vtkPoints::New();
-        do
+        if (work[l])
           {
-          // Add the current point and mark it as visited
-          double p[3];
-          slicePoints->GetPoint(ptIds[0], p);
-          points->InsertNextPoint(p);
-          ptIds[0] = -1;
-          // Find next line segment and continue
-          sliceContours->GetPointCells(ptIds[1], cellIds);
-          vtkIdType n1 = cellIds->GetId(0);
-          vtkIdType n2 = cellIds->GetId(1);
-          n1 = ((n2 == currentId) ? n1 : n2);
-          currentId = n1;
-          sliceLines->GetCell(3*currentId, numPts, ptIds);
+          activeCells->push_back(l);
           }
-        while (ptIds[0] >= 0);
-
-        vtkReducePoints(points);
-
-        output->SetNumberOfContours(contourId + 1);
-        output->SetContourPoints(contourId, points);
-        output->SetContourType(contourId, vtkROIContourData::CLOSED_PLANAR);
-        points->Delete();
-        contourId++;
         }
       }
     }
+}
+
+//----------------------------------------------------------------------------
+// Get the scalars at the corners of cell (i,j), where corners outside of
+// the extent are given the lowest possible value so that the contours are
+// closed at the edges of the image.
+template <class T>
+inline void vtkCellScalars(
+  const T *scalars, const int extent[6], const vtkIdType offset[3],
+  int i, int j, double s[4])
+{
+  vtkIdType idx = i*offset[0] + j*offset[1] + offset[2];
+  s[0] = VTK_DOUBLE_MIN;
+  s[1] = VTK_DOUBLE_MIN;
+  s[2] = VTK_DOUBLE_MIN;
+  s[3] = VTK_DOUBLE_MIN;
+  if (i >= extent[0] && j >= extent[2])
+    {
+    s[0] = scalars[idx];
+    }
+  if (i < extent[1] && j >= extent[2])
+    {
+    s[1] = scalars[idx + offset[0]];
+    }
+  if (i >= extent[0] && j < extent[3])
+    {
+    s[2] = scalars[idx + offset[1]];
+    }
+  if (i < extent[1] && j < extent[3])
+    {
+    s[3] = scalars[idx + offset[0] + offset[1]];
+    }
+}
 
-  // Free temporary objects
-  sliceContours->Delete();
-  cellIds->Delete();
+//----------------------------------------------------------------------------
+// Get the coords of the corners of cell (i,j).
+inline void vtkCellCoords(
+  const double spacing[3], const double origin[3], int i, int j,
+  double pts[4][2])
+{
+  pts[0][0] = origin[0] + i*spacing[0];
+  pts[0][1] = origin[1] + j*spacing[1];
+  double xp = origin[0] + (i+1)*spacing[0];
+  double yp = origin[1] + (j+1)*spacing[1];
 
-  return 1;
+  pts[1][0] = xp;
+  pts[1][1] = pts[0][1];
+
+  pts[2][0] = pts[0][0];
+  pts[2][1] = yp;
+
+  pts[3][0] = xp;
+  pts[3][1] = yp;
+}
+
+//----------------------------------------------------------------------------
+// Contour a slice at the given isovalue.  The contours are not broken at
+// the edges of the image.
+template <class T>
+void vtkContourSlice(
+  const T *scalars, const int extent[6], const vtkIdType offset[3],
+  const double spacing[3], const double origin[3], double value,
+  vtkImageToROIContourDataScratch *scratch)
+{
+  // The number of grid vertices across, including the padding
+  int nx = extent[1] - extent[0] + 3;
+  vtkImageToROIContourDataLines *lines = &scratch->Lines;
+  lines->Initialize(nx);
+
+  // The pixel classification, with an unset flag at each end of the rows
+  // for the padding outside of the image, and a work row
+  int mx = ((nx + 7) & ~7);
+  scratch->Flags.assign(3*mx, 0);
+  unsigned char *flagsBottom = &scratch->Flags[0];
+  unsigned char *flagsTop = flagsBottom + mx;
+  unsigned char *work = flagsTop + mx;
+
+  // assign coordinate value to non-varying coordinate direction
+  double z = origin[2] + extent[4]*spacing[2];
+
+  // Traverse pixel cells, generating line segments using marching squares.
+  for (int j = extent[2] - 1; j <= extent[3]; j++)
+    {
+    // Classify the row at the top of these cells
+    if (j < extent[3])
+      {
+      const T *row = scalars + (extent[0]*offset[0] + (j+1)*offset[1] +
+                                offset[2]);
+      vtkClassifyRow(row, offset[0], nx - 2, value, &flagsTop[1]);
+      }
+    else
+      {
+      memset(flagsTop, 0, nx);
+      }
+
+    // The cells are active if their corners are not all the same
+    for (int k = 0; k < nx - 1; k++)
+      {
+      work[k] = ((flagsBottom[k] ^ flagsBottom[k+1]) |
+                 (flagsBottom[k] ^ flagsTop[k]) |
+                 (flagsTop[k] ^ flagsTop[k+1]));
+      }
+    vtkCollectActiveCells(work, mx, &scratch->ActiveCells);
+
+    lines->StartRow(j);
+    std::vector<int>::iterator iter = scratch->ActiveCells.begin();
+    for (; iter != scratch->ActiveCells.end(); ++iter)
+      {
+      int k = *iter;
+      int i = k + extent[0] - 1;
+      double s[4];
+      double pts[4][2];
+      vtkCellScalars(scalars, extent, offset, i, j, s);
+      vtkCellCoords(spacing, origin, i, j, pts);
+      lines->AddCell(k, s, value, pts, z);
+      }
+    lines->FinishRow();
+
+    // Move to the next row
+    unsigned char *tmp = flagsBottom;
+    flagsBottom = flagsTop;
+    flagsTop = tmp;
+    }
+
+  scratch->SliceLines.clear();
+  scratch->SliceLines.push_back(lines);
+}
+
+//----------------------------------------------------------------------------
+// Contour each label in a slice of a label map.  Each cell is checked
+// for the labels at its corners, and the lines for each label are made
+// by contouring a 0/1 mask of the label at 0.5, so the contours for a
+// label are the same as those from a mask image of that label.
+template <class T>
+void vtkContourLabelSlice(
+  const T *scalars, const int extent[6], const vtkIdType offset[3],
+  const double spacing[3], const double origin[3],
+  const std::vector<int> *selectedLabels, int backgroundLabel,
+  vtkImageToROIContourDataScratch *scratch)
+{
+  // The number of grid vertices across, including the padding
+  int nx = extent[1] - extent[0] + 3;
+  int slice = extent[4];
+  scratch->SliceLines.clear();
+  scratch->RowLines.clear();
+
+  // Mark the lines from any previous slice as unused
+  std::map<int, vtkImageToROIContourDataLines>::iterator liter;
+  for (liter = scratch->LabelLines.begin();
+       liter != scratch->LabelLines.end(); ++liter)
+    {
+    liter->second.Slice = VTK_INT_MIN;
+    }
+
+  // Two rows of labels, and a work row
+  int mx = ((nx + 7) & ~7);
+  scratch->LabelRows.assign(2*mx, 0);
+  int *labelsBottom = &scratch->LabelRows[0];
+  int *labelsTop = labelsBottom + mx;
+  scratch->Flags.assign(mx, 0);
+  unsigned char *work = &scratch->Flags[0];
+
+  // The most recently used label
+  int lastLabel = 0;
+  vtkImageToROIContourDataLines *lastLines = 0;
+
+  // assign coordinate value to non-varying coordinate direction
+  double z = origin[2] + extent[4]*spacing[2];
+
+  for (int j = extent[2] - 1; j <= extent[3]; j++)
+    {
+    // Get the labels for the row at the top of these cells
+    if (j < extent[3])
+      {
+      const T *row = scalars + (extent[0]*offset[0] + (j+1)*offset[1] +
+                                offset[2]);
+      vtkLabelRow(row, offset[0], nx - 2, &labelsTop[1]);
+      }
+
+    // The cells are active if their labels are not all the same, and
+    // the cells that touch the padding are always active
+    if (j < extent[2] || j >= extent[3])
+      {
+      memset(work, 1, nx - 1);
+      }
+    else
+      {
+      int k = vtkCompareLabelRowsSSE2(labelsBottom, labelsTop, 1, nx - 2,
+                                      work);
+      for (; k < nx - 2; k++)
+        {
+        work[k] = ((labelsBottom[k] != labelsBottom[k+1]) |
+                   (labelsBottom[k] != labelsTop[k]) |
+                   (labelsTop[k] != labelsTop[k+1]));
+        }
+      work[0] = 1;
+      work[nx - 2] = 1;
+      }
+    vtkCollectActiveCells(work, mx, &scratch->ActiveCells);
+
+    std::vector<int>::iterator iter = scratch->ActiveCells.begin();
+    for (; iter != scratch->ActiveCells.end(); ++iter)
+      {
+      int k = *iter;
+      int i = k + extent[0] - 1;
+      int labels[4] = { labelsBottom[k], labelsBottom[k+1],
+                        labelsTop[k], labelsTop[k+1] };
+      bool inside[4];
+      inside[0] = (i >= extent[0] && j >= extent[2]);
+      inside[1] = (i < extent[1] && j >= extent[2]);
+      inside[2] = (i >= extent[0] && j < extent[3]);
+      inside[3] = (i < extent[1] && j < extent[3]);
+
+      double pts[4][2];
+      vtkCellCoords(spacing, origin, i, j, pts);
+
+      // Add lines for each label at the corners of the cell
+      for (int c = 0; c < 4; c++)
+        {
+        int label = labels[c];
+        bool seen = !inside[c];
+        for (int cc = 0; cc < c && !seen; cc++)
+          {
+          seen = (inside[cc] && labels[cc] == label);
+          }
+        if (seen ||
+            (selectedLabels->empty() ? (label == backgroundLabel) :
+             !std::binary_search(selectedLabels->begin(),
+                                 selectedLabels->end(), label)))
+          {
+          continue;
+          }
+
+        if (!lastLines || label != lastLabel)
+          {
+          lastLabel = label;
+          lastLines = &scratch->LabelLines[label];
+          }
+        vtkImageToROIContourDataLines *lines = lastLines;
+        if (lines->Slice != slice)
+          {
+          lines->Initialize(nx);
+          lines->Slice = slice;
+          lines->Label = label;
+          scratch->SliceLines.push_back(lines);
+          }
+        if (lines->Row != j)
+          {
+          lines->StartRow(j);
+          scratch->RowLines.push_back(lines);
+          }
+
+        double s[4];
+        for (int cc = 0; cc < 4; cc++)
+          {
+          s[cc] = (inside[cc] ? (labels[cc] == label) : VTK_DOUBLE_MIN);
+          }
+        lines->AddCell(k, s, 0.5, pts, z);
+        }
+      }
+
+    // Move to the next row
+    for (size_t l = 0; l < scratch->RowLines.size(); l++)
+      {
+      scratch->RowLines[l]->FinishRow();
+      }
+    scratch->RowLines.clear();
+    int *tmp = labelsBottom;
+    labelsBottom = labelsTop;
+    labelsTop = tmp;
+    }
+
+  // Sort by label, so that the output does not depend on the order
+  // in which the labels were found
+  std::sort(scratch->SliceLines.begin(), scratch->SliceLines.end(),
+            vtkImageToROIContourDataLines::LabelLess);
+}
+
+} // end anonymous namespace
+
+//----------------------------------------------------------------------------
+void vtkImageToROIContourData::MarchingSquares(
+  vtkImageToROIContourDataThreadStruct *ts, int extent[6],
+  vtkImageToROIContourDataScratch *scratch)
+{
+  vtkImageData *input = ts->Input;
+  void *inPtr = input->GetScalarPointerForExtent(extent);
+  double *spacing = input->GetSpacing();
+  double *origin = input->GetOrigin();
+  int *inExt = input->GetExtent();
+
+  vtkIdType offset[3];
+  offset[0] = input->GetNumberOfScalarComponents();
+  offset[1] = offset[0]*(inExt[1] - inExt[0] + 1);
+  offset[2] = -(offset[0]*extent[0] + offset[1]*extent[2]);
+
+  if (ts->LabelMapMode)
+    {
+    switch (input->GetScalarType())
+      {
+      vtkTemplateAliasMacro(
+        vtkContourLabelSlice(static_cast<VTK_TT*>(inPtr), extent, offset,
+                             spacing, origin, &ts->Labels,
+                             ts->BackgroundLabel, scratch);
+        );
+      }
+    }
+  else
+    {
+    switch (input->GetScalarType())
+      {
+      vtkTemplateAliasMacro(
+        vtkContourSlice(static_cast<VTK_TT*>(inPtr), extent, offset,
+                        spacing, origin, ts->Value, scratch);
+        );
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Chain the line segments into contours, and simplify them.
+namespace {
+void vtkAddContour(
+  std::vector<double> *chain, vtkROIContourSimplifier *simplifier,
+  int label, vtkImageToROIContourDataThreadStruct::ContourList *contours)
+{
+  // Simplify the chain before it is copied into the points
+  vtkIdType n = static_cast<vtkIdType>(chain->size()/3);
+  if (simplifier && n > 0)
+    {
+    n = simplifier->SimplifyCoordinates(&(*chain)[0], n, 1);
+    }
+
+  vtkPoints *points = vtkPoints::New(VTK_DOUBLE);
+  points->SetNumberOfPoints(n);
+  if (n > 0)
+    {
+    memcpy(points->GetVoidPointer(0), &(*chain)[0], 3*n*sizeof(double));
+    }
+
+  vtkImageToROIContourDataThreadStruct::Contour contour;
+  contour.Points = points;
+  contour.Label = label;
+  contours->push_back(contour);
+  points->Delete();
+}
+
+//----------------------------------------------------------------------------
+void vtkChainLines(
+  vtkImageToROIContourDataLines *lines, vtkROIContourSimplifier *simplifier,
+  std::vector<double> *chain,
+  vtkImageToROIContourDataThreadStruct::ContourList *contours)
+{
+  const double *slicePoints =
+    (lines->Points.empty() ? 0 : &lines->Points[0]);
+  vtkIdType *sliceLines = (lines->Lines.empty() ? 0 : &lines->Lines[0]);
+  const vtkIdType *links = (lines->Links.empty() ? 0 : &lines->Links[0]);
+
+  vtkIdType numCells = static_cast<vtkIdType>(lines->Lines.size()/2);
+  for (vtkIdType j = 0; j < numCells; j++)
+    {
+    vtkIdType currentId = j;
+    vtkIdType *ptIds = &sliceLines[2*currentId];
+    if (ptIds[0] >= 0)
+      {
+      chain->clear();
+      do
+        {
+        // Add the current point and mark it as visited
+        const double *p = &slicePoints[3*ptIds[0]];
+        chain->push_back(p[0]);
+        chain->push_back(p[1]);
+        chain->push_back(p[2]);
+        ptIds[0] = -1;
+        // Find next line segment and continue
+        vtkIdType n1 = links[2*ptIds[1]];
+        vtkIdType n2 = links[2*ptIds[1] + 1];
+        n1 = ((n2 == currentId) ? n1 : n2);
+        currentId = n1;
+        if (currentId < 0)
+          {
+          // Only possible for degenerate contours
+          break;
+          }
+        ptIds = &sliceLines[2*currentId];
+        }
+      while (ptIds[0] >= 0);
+
+      vtkAddContour(chain, simplifier, lines->Label, contours);
+      }
+    }
+}
+}
+
+//----------------------------------------------------------------------------
+// Trace the boundaries of the pixels that are at or above the isovalue.
+// The boundaries are followed along the cracks between the pixels, with
+// the inside pixels always on the left, so that outer boundaries go
+// counterclockwise and holes go clockwise.  One point is placed on each
+// crack, where the isovalue is crossed between the two pixel centers,
+// which is the same place that marching squares would put it.
+namespace {
+template <class T>
+void vtkTraceSlice(
+  const T *scalars, const int extent[6], const vtkIdType offset[3],
+  const double spacing[3], const double origin[3], double value,
+  vtkROIContourSimplifier *simplifier,
+  vtkImageToROIContourDataScratch *scratch,
+  vtkImageToROIContourDataThreadStruct::ContourList *contours)
+{
+  // The corner directions: +x, +y, -x, -y
+  static const int dirs[4][2] = { {1,0}, {0,1}, {-1,0}, {0,-1} };
+
+  int nx = extent[1] - extent[0] + 1;
+  int ny = extent[3] - extent[2] + 1;
+
+  // Classify the pixels, with a border of unset pixels
+  int mx = nx + 2;
+  scratch->Flags.assign(static_cast<size_t>(mx)*(ny + 2), 0);
+  unsigned char *mask = &scratch->Flags[mx + 1];
+  for (int j = 0; j < ny; j++)
+    {
+    const T *row = scalars + (extent[0]*offset[0] +
+                              (extent[2] + j)*offset[1] + offset[2]);
+    vtkClassifyRow(row, offset[0], nx, value, &mask[j*mx]);
+    }
+
+  // Mark the horizontal cracks that have been visited
+  scratch->Visited.assign(static_cast<size_t>(nx)*(ny + 1), 0);
+  unsigned char *visited = &scratch->Visited[0];
+
+  // assign coordinate value to non-varying coordinate direction
+  double z = origin[2] + extent[4]*spacing[2];
+
+  for (int j = 0; j <= ny; j++)
+    {
+    // Rows that are the same as the previous row have no cracks
+    const unsigned char *below = &mask[(j - 1)*mx];
+    const unsigned char *above = &mask[j*mx];
+    if (memcmp(below, above, nx) == 0)
+      {
+      continue;
+      }
+
+    for (int i = 0; i < nx; i++)
+      {
+      if (below[i] == above[i] || visited[j*nx + i])
+        {
+        continue;
+        }
+
+      // Start at the corner to the left or the right of the crack, so
+      // that the inside pixel will be on the left
+      int ci = i + below[i];
+      int cj = j;
+      int d = (below[i] ? 2 : 0);
+      int startI = ci;
+      int startJ = cj;
+      int startD = d;
+
+      std::vector<double> *chain = &scratch->Chain;
+      chain->clear();
+      do
+        {
+        // Get the pixels on either side of this crack, "a" is the one
+        // with the lower index
+        int ai, aj, bi, bj;
+        if ((d & 1) == 0)
+          {
+          ai = ci - (d >> 1);
+          bi = ai;
+          aj = cj - 1;
+          bj = cj;
+          visited[cj*nx + ai] = 1;
+          }
+        else
+          {
+          ai = ci - 1;
+          bi = ci;
+          aj = cj - (d >> 1);
+          bj = aj;
+          }
+
+        // Interpolate the position of the isovalue along the crack
+        double sa = VTK_DOUBLE_MIN;
+        double sb = VTK_DOUBLE_MIN;
+        vtkIdType idx = ((extent[0] + ai)*offset[0] +
+                         (extent[2] + aj)*offset[1] + offset[2]);
+        if (ai >= 0 && aj >= 0)
+          {
+          sa = scalars[idx];
+          }
+        if (bi < nx && bj < ny)
+          {
+          sb = scalars[idx + (bi - ai)*offset[0] + (bj - aj)*offset[1]];
+          }
+        double t = (value - sa)/(sb - sa);
+        double x1[2], x2[2], x[2];
+        x1[0] = origin[0] + (extent[0] + ai)*spacing[0];
+        x1[1] = origin[1] + (extent[2] + aj)*spacing[1];
+        x2[0] = origin[0] + (extent[0] + bi)*spacing[0];
+        x2[1] = origin[1] + (extent[2] + bj)*spacing[1];
+        x[0] = x1[0] + t*(x2[0] - x1[0]);
+        x[1] = x1[1] + t*(x2[1] - x1[1]);
+
+        // Skip the point if it falls on a corner where the last did
+        size_t m = chain->size();
+        if (m == 0 || x[0] != (*chain)[m-3] || x[1] != (*chain)[m-2])
+          {
+          chain->push_back(x[0]);
+          chain->push_back(x[1]);
+          chain->push_back(z);
+          }
+
+        // Move to the next corner, and look at the two pixels ahead
+        ci += dirs[d][0];
+        cj += dirs[d][1];
+        const unsigned char *ne = &mask[cj*mx + ci];
+        int leftAhead = 0;
+        int rightAhead = 0;
+        switch (d)
+          {
+          case 0:
+            leftAhead = ne[0];
+            rightAhead = ne[-mx];
+            break;
+          case 1:
+            leftAhead = ne[-1];
+            rightAhead = ne[0];
+            break;
+          case 2:
+            leftAhead = ne[-mx-1];
+            rightAhead = ne[-1];
+            break;
+          case 3:
+            leftAhead = ne[-mx];
+            rightAhead = ne[-mx-1];
+            break;
+          }
+
+        // Turn right only if both pixels ahead are inside, so that inside
+        // pixels that touch at a corner are not connected, which is also
+        // how marching squares treats them
+        if (rightAhead && leftAhead)
+          {
+          d = (d + 3) & 3;
+          }
+        else if (!leftAhead)
+          {
+          d = (d + 1) & 3;
+          }
+        }
+      while (ci != startI || cj != startJ || d != startD);
+
+      // The first and last points might be the same
+      size_t m = chain->size();
+      if (m > 3 && (*chain)[0] == (*chain)[m-3] &&
+          (*chain)[1] == (*chain)[m-2])
+        {
+        chain->resize(m - 3);
+        }
+
+      vtkAddContour(chain, simplifier, 0, contours);
+      }
+    }
+}
+}
+
+//----------------------------------------------------------------------------
+void vtkImageToROIContourData::TraceBoundaries(
+  vtkImageToROIContourDataThreadStruct *ts, int extent[6],
+  vtkImageToROIContourDataScratch *scratch)
+{
+  vtkImageData *input = ts->Input;
+  void *inPtr = input->GetScalarPointerForExtent(extent);
+  double *spacing = input->GetSpacing();
+  double *origin = input->GetOrigin();
+  int *inExt = input->GetExtent();
+  vtkIdType offset[3];
+  offset[0] = input->GetNumberOfScalarComponents();
+  offset[1] = offset[0]*(inExt[1] - inExt[0] + 1);
+  offset[2] = -(offset[0]*extent[0] + offset[1]*extent[2]);
+
+  vtkImageToROIContourDataThreadStruct::ContourList *contours =
+    &ts->Slices[extent[4] - ts->Extent[4]];
+
+  switch (input->GetScalarType())
+    {
+    vtkTemplateAliasMacro(
+      vtkTraceSlice(static_cast<VTK_TT*>(inPtr), extent, offset,
+                    spacing, origin, ts->Value, ts->Simplifier, scratch,
+                    contours);
+      );
+    }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkImageToROIContourDataThreadStruct::ThreadMain(
+  void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkImageToROIContourDataThreadStruct *ts =
+    static_cast<vtkImageToROIContourDataThreadStruct *>(info->UserData);
+
+  ts->Filter->ThreadedExecute(ts, info->ThreadID, info->NumberOfThreads);
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageToROIContourData::ThreadedExecute(
+  vtkImageToROIContourDataThreadStruct *ts, int threadId, int numThreads)
+{
+  // Scratch space for this thread
+  vtkImageToROIContourDataScratch scratch;
+
+  // The slices are interleaved between threads, to balance the load
+  // if the structure only occupies part of the volume
+  int extent[6];
+  for (int k = 0; k < 6; k++)
+    {
+    extent[k] = ts->Extent[k];
+    }
+  int zMin = ts->Extent[4];
+  int zMax = ts->Extent[5];
+
+  for (int zIdx = zMin + threadId; zIdx <= zMax; zIdx += numThreads)
+    {
+    // Generate the line segments
+    extent[4] = zIdx;
+    extent[5] = zIdx;
+    if (ts->BoundaryTracing)
+      {
+      // The tracer produces the contours directly
+      this->TraceBoundaries(ts, extent, &scratch);
+      continue;
+      }
+    this->MarchingSquares(ts, extent, &scratch);
+
+    // Chain the line segments into contours
+    for (size_t l = 0; l < scratch.SliceLines.size(); l++)
+      {
+      vtkChainLines(scratch.SliceLines[l], ts->Simplifier, &scratch.Chain,
+                    &ts->Slices[zIdx - zMin]);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkImageToROIContourData::RequestUpdateExtent(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **inputVector,
+  vtkInformationVector *vtkNotUsed(outputVector))
+{
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  int wholeExtent[6];
+  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExtent);
+
+  // Ask for the current slab, or for everything if not streaming
+  int extent[6];
+  this->ComputeNextSlabExtent(wholeExtent, extent);
+  if (this->CanUpdateIncrementally(wholeExtent))
+    {
+    // Only ask for the slices that have changed
+    this->ComputeDirtyExtent(wholeExtent, extent);
+    }
+  inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent, 6);
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageToROIContourData::RequestData(
+  vtkInformation *request,
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  // Get the info objects
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+
+  // Get the input and output
+  vtkImageData *input = vtkImageData::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkROIContourData *output = vtkROIContourData::SafeDownCast(
+    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+
+  int wholeExtent[6];
+  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExtent);
+  int numSlabs = this->GetNumberOfSlabs(wholeExtent);
+  if (numSlabs <= 0)
+    {
+    this->StopStreaming(request);
+    this->SliceContourCounts->Initialize();
+    this->FinishContours(input, wholeExtent, output);
+    return 1;
+    }
+
+  if (this->CanUpdateIncrementally(wholeExtent))
+    {
+    this->UpdateSlices(input, wholeExtent, output);
+    this->FinishContours(input, wholeExtent, output);
+    return 1;
+    }
+
+  if (!this->Streaming)
+    {
+    this->SliceContourCounts->Initialize();
+    this->ContourSlices(input, wholeExtent, output,
+                        this->SliceContourCounts);
+    this->FinishContours(input, wholeExtent, output);
+    return 1;
+    }
+
+  // When streaming, the pipeline is asked to keep executing until all
+  // of the slabs are done, and the contours are collected as we go
+  if (this->StartSlab(request, numSlabs))
+    {
+    this->StreamedContours->Initialize();
+    this->SliceContourCounts->Initialize();
+    }
+
+  int extent[6];
+  this->ComputeSlabExtent(wholeExtent, this->SlabIndex, extent);
+  this->ContourSlices(input, extent, this->StreamedContours,
+                      this->SliceContourCounts);
+
+  if (this->FinishSlab(request, numSlabs))
+    {
+    output->ShallowCopy(this->StreamedContours);
+    this->StreamedContours->Initialize();
+    this->FinishContours(input, wholeExtent, output);
+    }
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageToROIContourData::SlicesModified(int zmin, int zmax)
+{
+  if (zmin > zmax)
+    {
+    return;
+    }
+
+  // If nothing else has changed since the contours were generated, then
+  // only the given slices have to be contoured again
+  int clean = (this->GetMTime() == this->ContourMTime);
+  this->Modified();
+  if (clean)
+    {
+    if (this->DirtySlices[0] > this->DirtySlices[1])
+      {
+      this->DirtySlices[0] = zmin;
+      this->DirtySlices[1] = zmax;
+      }
+    else
+      {
+      this->DirtySlices[0] = (zmin < this->DirtySlices[0] ?
+                              zmin : this->DirtySlices[0]);
+      this->DirtySlices[1] = (zmax > this->DirtySlices[1] ?
+                              zmax : this->DirtySlices[1]);
+      }
+    this->ContourMTime = this->GetMTime();
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkImageToROIContourData::CanUpdateIncrementally(
+  const int wholeExtent[6])
+{
+  if (!this->IncrementalUpdate || this->SlabIndex != 0 ||
+      this->DirtySlices[0] > this->DirtySlices[1] ||
+      this->GetMTime() != this->ContourMTime)
+    {
+    return 0;
+    }
+
+  // The previous contours must be for the same extent
+  for (int k = 0; k < 6; k++)
+    {
+    if (wholeExtent[k] != this->ContourExtent[k])
+      {
+      return 0;
+      }
+    }
+
+  return (this->SliceContourCounts->GetNumberOfTuples() ==
+          wholeExtent[5] - wholeExtent[4] + 1);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageToROIContourData::ComputeDirtyExtent(
+  const int wholeExtent[6], int extent[6])
+{
+  for (int k = 0; k < 6; k++)
+    {
+    extent[k] = wholeExtent[k];
+    }
+  extent[4] = (this->DirtySlices[0] > wholeExtent[4] ?
+               this->DirtySlices[0] : wholeExtent[4]);
+  extent[5] = (this->DirtySlices[1] < wholeExtent[5] ?
+               this->DirtySlices[1] : wholeExtent[5]);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageToROIContourData::UpdateSlices(
+  vtkImageData *input, const int wholeExtent[6], vtkROIContourData *output)
+{
+  vtkROIContourData *previous = this->PreviousContours;
+
+  // The slices to contour again, which might be none at all if the
+  // dirty slices are outside of the extent
+  int extent[6];
+  this->ComputeDirtyExtent(wholeExtent, extent);
+  int firstSlice = extent[4] - wholeExtent[4];
+  int lastSlice = extent[5] - wholeExtent[4];
+  int numSlices = wholeExtent[5] - wholeExtent[4] + 1;
+
+  // Find the contours that came from the dirty slices
+  int startId = 0;
+  int endId = 0;
+  for (int k = 0; k < numSlices; k++)
+    {
+    int n = this->SliceContourCounts->GetValue(k);
+    startId += (k < firstSlice ? n : 0);
+    endId += (k <= lastSlice ? n : 0);
+    }
+  int numPrevious = previous->GetNumberOfContours();
+  if (endId > numPrevious)
+    {
+    vtkErrorMacro("UpdateSlices: the previous contours are not consistent"
+                  " with the slices, contouring all slices.");
+    this->SliceContourCounts->Initialize();
+    this->ContourSlices(input, wholeExtent, output,
+                        this->SliceContourCounts);
+    return;
+    }
+
+  // Contour the dirty slices
+  vtkROIContourData *newContours = vtkROIContourData::New();
+  vtkIntArray *newCounts = vtkIntArray::New();
+  if (extent[4] <= extent[5])
+    {
+    this->ContourSlices(input, extent, newContours, newCounts);
+    }
+  for (int k = firstSlice; k <= lastSlice; k++)
+    {
+    this->SliceContourCounts->SetValue(k, newCounts->GetValue(k - firstSlice));
+    }
+
+  // Splice the new contours in between the unchanged contours
+  int numNew = newContours->GetNumberOfContours();
+  int n = numPrevious - (endId - startId) + numNew;
+  output->SetNumberOfContours(n);
+  for (int i = 0; i < n; i++)
+    {
+    vtkROIContourData *source = previous;
+    int j = i;
+    if (i >= startId + numNew)
+      {
+      j = i - numNew + (endId - startId);
+      }
+    else if (i >= startId)
+      {
+      source = newContours;
+      j = i - startId;
+      }
+    output->SetContourPoints(i, source->GetContourPoints(j));
+    output->SetContourType(i, source->GetContourType(j));
+    output->SetContourLabel(i, source->GetContourLabel(j));
+    }
+
+  newContours->Delete();
+  newCounts->Delete();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageToROIContourData::FinishContours(
+  vtkImageData *input, const int wholeExtent[6], vtkROIContourData *output)
+{
+  // Remember the contours, and the slices that they came from, so that
+  // the slices can be contoured again without redoing the whole image
+  if (this->IncrementalUpdate)
+    {
+    this->PreviousContours->ShallowCopy(output);
+    }
+  else
+    {
+    this->PreviousContours->Initialize();
+    }
+  for (int k = 0; k < 6; k++)
+    {
+    this->ContourExtent[k] = wholeExtent[k];
+    }
+  this->DirtySlices[0] = VTK_INT_MAX;
+  this->DirtySlices[1] = VTK_INT_MIN;
+  this->ContourMTime = this->GetMTime();
+
+  this->ComputeLabelStatistics(output);
+  this->ComputeHoleFlags(input, output);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageToROIContourData::ContourSlices(
+  vtkImageData *input, const int extent[6], vtkROIContourData *output,
+  vtkIntArray *sliceCounts)
+{
+  vtkImageToROIContourDataThreadStruct ts;
+  ts.Filter = this;
+  ts.Input = input;
+  ts.Value = this->Value;
+  ts.LabelMapMode = this->LabelMapMode;
+  ts.BackgroundLabel = this->BackgroundLabel;
+  ts.BoundaryTracing = (this->BoundaryTracing && !this->LabelMapMode);
+  for (vtkIdType l = 0; l < this->Labels->GetNumberOfTuples(); l++)
+    {
+    ts.Labels.push_back(this->Labels->GetValue(l));
+    }
+  std::sort(ts.Labels.begin(), ts.Labels.end());
+
+  for (int k = 0; k < 6; k++)
+    {
+    ts.Extent[k] = extent[k];
+    }
+  int numSlices = extent[5] - extent[4] + 1;
+  if (numSlices <= 0)
+    {
+    return;
+    }
+
+  // The default tolerance is half of the smallest in-plane pixel size
+  ts.Simplifier = 0;
+  if (this->Simplification)
+    {
+    double tol = this->SimplificationTolerance;
+    if (tol <= 0)
+      {
+      double *spacing = input->GetSpacing();
+      tol = 0.5*(fabs(spacing[0]) < fabs(spacing[1]) ?
+                 fabs(spacing[0]) : fabs(spacing[1]));
+      }
+    ts.Simplifier = vtkROIContourSimplifier::New();
+    ts.Simplifier->SetTolerance(tol);
+    }
+  ts.Slices.resize(static_cast<size_t>(numSlices));
+
+  // Never use more threads than there are slices
+  int numThreads = this->NumberOfThreads;
+  numThreads = (numThreads > numSlices ? numSlices : numThreads);
+
+  if (numThreads > 1)
+    {
+    this->Threader->SetNumberOfThreads(numThreads);
+    this->Threader->SetSingleMethod(
+      &vtkImageToROIContourDataThreadStruct::ThreadMain, &ts);
+    this->Threader->SingleMethodExecute();
+    }
+  else
+    {
+    this->ThreadedExecute(&ts, 0, 1);
+    }
+
+  // Add contours to output, in slice order
+  int numContours = 0;
+  for (int k = 0; k < numSlices; k++)
+    {
+    numContours += static_cast<int>(ts.Slices[k].size());
+    }
+
+  int contourId = output->GetNumberOfContours();
+  output->SetNumberOfContours(contourId + numContours);
+  for (int k = 0; k < numSlices; k++)
+    {
+    vtkImageToROIContourDataThreadStruct::ContourList *contours =
+      &ts.Slices[k];
+    sliceCounts->InsertNextValue(static_cast<int>(contours->size()));
+    for (size_t j = 0; j < contours->size(); j++)
+      {
+      vtkImageToROIContourDataThreadStruct::Contour *contour =
+        &(*contours)[j];
+      output->SetContourPoints(contourId, contour->Points);
+      output->SetContourType(contourId, vtkROIContourData::CLOSED_PLANAR);
+      if (ts.LabelMapMode)
+        {
+        output->SetContourLabel(contourId, contour->Label);
+        }
+      contourId++;
+      }
+    // Release the points as soon as they are in the output
+    contours->clear();
+    }
+
+  if (ts.Simplifier)
+    {
+    ts.Simplifier->Delete();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkImageToROIContourData::ComputeHoleFlags(
+  vtkImageData *input, vtkROIContourData *output)
+{
+  this->HoleFlags->Initialize();
+  if (!this->BoundaryTracing || this->LabelMapMode)
+    {
+    return;
+    }
+
+  // The traced contours go counterclockwise around the structured x,y
+  // axes of the image, which are flipped if the spacing is negative
+  double *spacing = input->GetSpacing();
+  double direction = spacing[0]*spacing[1];
+
+  int numContours = output->GetNumberOfContours();
+  this->HoleFlags->SetNumberOfValues(numContours);
+  for (int i = 0; i < numContours; i++)
+    {
+    vtkPoints *points = output->GetContourPoints(i);
+    vtkIdType n = (points ? points->GetNumberOfPoints() : 0);
+    double area = 0.0;
+    double p[3], q[3];
+    if (n > 0)
+      {
+      points->GetPoint(n - 1, p);
+      }
+    for (vtkIdType j = 0; j < n; j++)
+      {
+      points->GetPoint(j, q);
+      area += p[0]*q[1] - q[0]*p[1];
+      p[0] = q[0];
+      p[1] = q[1];
+      }
+    this->HoleFlags->SetValue(i, (area*direction < 0));
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkImageToROIContourData::ComputeLabelStatistics(
+  vtkROIContourData *output)
+{
+  this->LabelStatistics->Initialize();
+  if (!this->LabelMapMode)
+    {
+    return;
+    }
+
+  // The number of contours and points for each label
+  std::map<int, std::pair<vtkIdType, vtkIdType> > labelCounts;
+  int numContours = output->GetNumberOfContours();
+  for (int i = 0; i < numContours; i++)
+    {
+    std::pair<vtkIdType, vtkIdType> *counts =
+      &labelCounts[output->GetContourLabel(i)];
+    counts->first++;
+    counts->second += output->GetNumberOfContourPoints(i);
+    }
+
+  // Store the statistics as (label, contours, points) tuples
+  std::map<int, std::pair<vtkIdType, vtkIdType> >::iterator iter;
+  for (iter = labelCounts.begin(); iter != labelCounts.end(); ++iter)
+    {
+    this->LabelStatistics->InsertNextValue(iter->first);
+    this->LabelStatistics->InsertNextValue(iter->second.first);
+    this->LabelStatistics->InsertNextValue(iter->second.second);
+    }
 }
@@ -15,21 +15,28 @@
 // .SECTION Description
 // This filter will contour an image at a specified isovalue to generate
 // slice-by-slice ROI contours that will be stored in a vtkROIContourData.
+// When Streaming is on, each slab is contoured before the next slab is
+// requested, and the contours are collected until the last slab is done.
 
 #ifndef __vtkImageToROIContourData_h
 #define __vtkImageToROIContourData_h
 
-#include "vtkAlgorithm.h"
+#include "vtkSlabStreamingAlgorithm.h"
+#include "vtkMultiThreader.h" // for VTK_MAX_THREADS
 
 class vtkROIContourData;
 class vtkImageData;
-class vtkPolyData;
+class vtkIntArray;
+class vtkIdTypeArray;
+class vtkImageToROIContourDataThreadStruct;
+class vtkImageToROIContourDataScratch;
 
-class VTK_EXPORT vtkImageToROIContourData : public vtkAlgorithm
+class VTK_EXPORT vtkImageToROIContourData :
+  public vtkSlabStreamingAlgorithm
 {
 public:
   static vtkImageToROIContourData *New();
-  vtkTypeMacro(vtkImageToROIContourData,vtkAlgorithm);
+  vtkTypeMacro(vtkImageToROIContourData,vtkSlabStreamingAlgorithm);
   void PrintSelf(ostream& os, vtkIndent indent);
 
   // Description:
@@ -37,6 +44,99 @@ public:
   vtkSetMacro(Value, double);
   vtkGetMacro(Value, double);
 
+  // Description:
+  // Contour a label map.  Instead of contouring at an isovalue, contours
+  // will be generated around the pixels of each label, and the label will
+  // be stored with each contour in the output.  All of the labels are
+  // done in a single pass through the image.  The default is Off.
+  vtkSetMacro(LabelMapMode, int);
+  vtkBooleanMacro(LabelMapMode, int);
+  vtkGetMacro(LabelMapMode, int);
+
+  // Description:
+  // The label for the background in LabelMapMode.  This label will not
+  // be contoured unless it is given to AddLabel().  The default is zero.
+  vtkSetMacro(BackgroundLabel, int);
+  vtkGetMacro(BackgroundLabel, int);
+
+  // Description:
+  // Choose which labels to contour in LabelMapMode.  If no labels are
+  // added, then every label except the background label is contoured.
+  void AddLabel(int label);
+  void RemoveAllLabels();
+  int GetNumberOfLabels();
+  int GetLabel(int i);
+
+  // Description:
+  // After execution in LabelMapMode, get the number of contours and the
+  // number of points that were generated for each label.  The statistics
+  // array holds one (label, contours, points) tuple for each label that
+  // was found, in order of increasing label.
+  vtkIdTypeArray *GetLabelStatistics() { return this->LabelStatistics; }
+  int GetLabelContourCount(int label);
+  vtkIdType GetLabelPointCount(int label);
+
+  // Description:
+  // Trace the pixel boundaries of a binary mask directly, instead of
+  // doing marching squares and then joining the line segments.  The
+  // contours follow the cracks between the pixels that are inside and
+  // outside, and are placed where the Value is crossed, just as with
+  // marching squares.  Pixels that only touch at a corner are not
+  // connected.  This is much faster for masks, and it also provides
+  // the hole flags for the contours.  It is ignored in LabelMapMode.
+  // The default is Off.
+  vtkSetMacro(BoundaryTracing, int);
+  vtkBooleanMacro(BoundaryTracing, int);
+  vtkGetMacro(BoundaryTracing, int);
+
+  // Description:
+  // After execution with BoundaryTracing, get one flag per contour that
+  // says whether the contour is the boundary of a hole.  When viewed in
+  // the structured x,y coordinates of the image, outer boundaries go
+  // counterclockwise and holes go clockwise.  The array is empty if
+  // BoundaryTracing was not used.
+  vtkIntArray *GetContourHoleFlags() { return this->HoleFlags; }
+
+  // Description:
+  // Simplify the contours with vtkROIContourSimplifier, so that they have
+  // fewer points.  The default is On.
+  vtkSetMacro(Simplification, int);
+  vtkBooleanMacro(Simplification, int);
+  vtkGetMacro(Simplification, int);
+
+  // Description:
+  // The maximum distance between the simplified contours and the original
+  // contours, in world units.  If this is zero, then half of the smallest
+  // in-plane pixel spacing is used.  The default is zero.
+  vtkSetMacro(SimplificationTolerance, double);
+  vtkGetMacro(SimplificationTolerance, double);
+
+  // Description:
+  // The number of threads to use.  The slices are divided between the
+  // threads, and the contours are always added to the output in slice
+  // order, so the output does not depend on the number of threads.
+  // The default is the number of processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
+  // Description:
+  // Keep track of which contours came from which slice, so that when
+  // SlicesModified() is called, only the modified slices have to be
+  // contoured again.  The new contours are spliced into the previous
+  // output in place of the old ones.  Changing any other parameter of
+  // the filter, or the extent of the input, causes all slices to be
+  // contoured again.  The default is Off.
+  vtkSetMacro(IncrementalUpdate, int);
+  vtkBooleanMacro(IncrementalUpdate, int);
+  vtkGetMacro(IncrementalUpdate, int);
+
+  // Description:
+  // Tell the filter that the input has changed within the given range
+  // of slices, for example after the user has drawn on a mask.  The
+  // slices are given as structured z coordinates.  This calls Modified().
+  void SlicesModified(int zmin, int zmax);
+  void SliceModified(int z) { this->SlicesModified(z, z); }
+
   // Description:
   // The input to this filter must be a vtkImageData.
   void SetInput(vtkDataObject *d);
@@ -47,12 +147,6 @@ public:
   vtkROIContourData* GetOutput();
   virtual void SetOutput(vtkDataObject* d);
 
-  // Description:
-  // see vtkAlgorithm for details
-  virtual int ProcessRequest(vtkInformation*,
-                             vtkInformationVector**,
-                             vtkInformationVector*);
-
 protected:
   vtkImageToROIContourData();
   ~vtkImageToROIContourData();
@@ -62,6 +156,12 @@ protected:
     vtkInformationVector* outputVector, int requestFromOutputPort,
     unsigned long* mtime);
 
+  virtual vtkDataObject *NewOutputData();
+
+  virtual int RequestUpdateExtent(
+    vtkInformation* request, vtkInformationVector** inputVector,
+    vtkInformationVector* outputVector);
+
   virtual int RequestData(
     vtkInformation* request, vtkInformationVector** inputVector,
     vtkInformationVector* outputVector);
@@ -70,14 +170,74 @@ protected:
   virtual int FillInputPortInformation(int port, vtkInformation *info);
 
   double Value;
+  int NumberOfThreads;
+  vtkMultiThreader *Threader;
+  int LabelMapMode;
+  int BackgroundLabel;
+  vtkIntArray *Labels;
+  vtkIdTypeArray *LabelStatistics;
+  vtkROIContourData *StreamedContours;
+  int IncrementalUpdate;
+  int Simplification;
+  double SimplificationTolerance;
+  int BoundaryTracing;
+  vtkIntArray *HoleFlags;
+  vtkROIContourData *PreviousContours;
+  vtkIntArray *SliceContourCounts;
+  int ContourExtent[6];
+  int DirtySlices[2];
+  unsigned long ContourMTime;
+
+  // Description:
+  // Check whether only the modified slices have to be contoured, and get
+  // the extent of these slices.
+  int CanUpdateIncrementally(const int wholeExtent[6]);
+  void ComputeDirtyExtent(const int wholeExtent[6], int extent[6]);
+
+  // Description:
+  // Contour the modified slices, and splice the new contours together
+  // with the previous contours for the other slices.
+  void UpdateSlices(vtkImageData *input, const int wholeExtent[6],
+                    vtkROIContourData *output);
+
+  // Description:
+  // Record the state of the output after it has been generated.
+  void FinishContours(vtkImageData *input, const int wholeExtent[6],
+                      vtkROIContourData *output);
+
+  // Description:
+  // Contour the slices in the given extent and append the contours to
+  // the output.  The number of contours for each slice is appended to
+  // the sliceCounts array.
+  void ContourSlices(vtkImageData *input, const int extent[6],
+                     vtkROIContourData *output, vtkIntArray *sliceCounts);
+
+  // Description:
+  // Count the contours and points for each label in the output.
+  void ComputeLabelStatistics(vtkROIContourData *output);
+
+  // Description:
+  // Flag the traced contours that are holes, by checking their direction.
+  void ComputeHoleFlags(vtkImageData *input, vtkROIContourData *output);
+
+  // Description:
+  // Generate contours for the slices that belong to the given thread.
+  void ThreadedExecute(vtkImageToROIContourDataThreadStruct *ts,
+                       int threadId, int numThreads);
+
+  friend class vtkImageToROIContourDataThreadStruct;
 
 private:
   vtkImageToROIContourData(const vtkImageToROIContourData&);  // Not implemented.
   void operator=(const vtkImageToROIContourData&);  // Not implemented.
 
   void MarchingSquares(
-    vtkImageData *input, vtkPolyData *output, int extent[6], double value);
+    vtkImageToROIContourDataThreadStruct *ts, int extent[6],
+    vtkImageToROIContourDataScratch *scratch);
 
+  void TraceBoundaries(
+    vtkImageToROIContourDataThreadStruct *ts, int extent[6],
+    vtkImageToROIContourDataScratch *scratch);
 };
 
 #endif
@@ -18,6 +18,7 @@
 #include "vtkFollowerPlane.h"
 #include "vtkROIContourData.h"
 #include "vtkROIContourDataToPolyData.h"
+#include "vtkROIContourSimplifier.h"
 #include "vtkGeometricCursorShapes.h"
 #include "vtkToolCursor.h"
 #include "vtkCamera.h"
@@ -31,6 +32,7 @@
 #include "vtkCellLocator.h"
 #include "vtkImageData.h"
 #include "vtkPoints.h"
+#include "vtkIdList.h"
 #include "vtkCellArray.h"
 #include "vtkPointData.h"
 #include "vtkCellData.h"
@@ -121,6 +123,7 @@ vtkLassoImageTool::vtkLassoImageTool()
   this->InitialPointPosition[0] = 0;
   this->InitialPointPosition[1] = 1;
   this->InitialPointPosition[2] = 2;
+  this->SimplificationTolerance = 0.0;
 }
 
 //----------------------------------------------------------------------------
@@ -149,6 +152,9 @@ vtkLassoImageTool::~vtkLassoImageTool()
 void vtkLassoImageTool::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "SimplificationTolerance: "
+     << this->SimplificationTolerance << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -262,29 +268,22 @@ void vtkLassoImageTool::StartAction()
     cellLocator->BuildLocator();
     }
 
-  // Get the contour data
+  // Get the contour data, and the contours in the current slice
   vtkROIContourData *data = this->ROIData;
   int numContours = data->GetNumberOfContours();
+  vtkIdList *sliceContours = vtkIdList::New();
+  data->FindContoursNearPlane(
+    this->ROISelectionPlane, sliceTol, sliceContours);
+  vtkIdType numSliceContours = sliceContours->GetNumberOfIds();
   this->CurrentPointId = -1;
   this->CurrentContourId = -1;
   double tol2 = tol*tol;
-  for (int ic = 0; ic < numContours; ic++)
+  for (vtkIdType k = 0; k < numSliceContours; k++)
     {
+    int ic = static_cast<int>(sliceContours->GetId(k));
     vtkPoints *points = data->GetContourPoints(ic);
     vtkIdType n = points->GetNumberOfPoints();
 
-    // Check if the contour is in the current slice
-    if (n > 0)
-      {
-      double p[3];
-      points->GetPoint(0, p);
-      double d = fabs(this->ROISelectionPlane->EvaluateFunction(p));
-      if (d >= sliceTol)
-        {
-        continue;
-        }
-      }
-
     // Check if mouse is over a point
     for (vtkIdType i = 0; i < n; i++)
       {
@@ -355,24 +354,10 @@ void vtkLassoImageTool::StartAction()
 
     if (this->CurrentContourId < 0)
       {
-      // Check if there is an open contour
-      for (int i = 0; i < numContours; i++)
+      // Check if there is an open contour in the current slice
+      for (vtkIdType k = 0; k < numSliceContours; k++)
         {
-        vtkPoints *points = data->GetContourPoints(i);
-        vtkIdType n = points->GetNumberOfPoints();
-
-        // Check if the contour is in the current slice
-        if (n > 0)
-          {
-          double q[3];
-          points->GetPoint(0, q);
-          double d = fabs(this->ROISelectionPlane->EvaluateFunction(q));
-          if (d >= sliceTol)
-            {
-            continue;
-            }
-          }
-
+        int i = static_cast<int>(sliceContours->GetId(k));
         if (data->GetContourType(i) == vtkROIContourData::OPEN_PLANAR)
           {
           this->CurrentContourId = i;
@@ -399,9 +384,16 @@ void vtkLassoImageTool::StartAction()
       this->InitialPointPosition[2] = position[2];
       }
 
-    this->ROIData->Modified();
+    // The points of an existing contour were changed in place, while a
+    // new contour was already marked by SetContourPoints()
+    if (this->CurrentContourId >= 0)
+      {
+      this->ROIData->ContourModified(this->CurrentContourId);
+      }
     }
 
+  sliceContours->Delete();
+
   // Generate an offset to avoid Z buffer problems
   this->OffsetTransform->Identity();
   this->OffsetTransform->Translate(this->ROISelectionPlane->GetNormal());
@@ -474,6 +466,9 @@ void vtkLassoImageTool::AddViewPropsToRenderer(vtkRenderer *renderer)
   this->OffsetTransform->Identity();
   this->OffsetTransform->Translate(this->ROISelectionPlane->GetNormal());
 
+  // Subdivide the contours according to the zoom
+  this->ROIDataToPolyData->SetRenderer(renderer);
+
   renderer->AddViewProp(this->GlyphActor);
   renderer->AddViewProp(this->ContourActor);
 }
@@ -483,12 +478,38 @@ void vtkLassoImageTool::RemoveViewPropsFromRenderer(vtkRenderer *renderer)
 {
   renderer->RemoveViewProp(this->GlyphActor);
   renderer->RemoveViewProp(this->ContourActor);
+
+  if (this->ROIDataToPolyData->GetRenderer() == renderer)
+    {
+    this->ROIDataToPolyData->SetRenderer(0);
+    }
 }
 
 //----------------------------------------------------------------------------
 void vtkLassoImageTool::StopAction()
 {
   this->Superclass::StopAction();
+
+  // Remove redundant points from the contour that was drawn, but only
+  // once it has been closed, since an open contour is still being drawn
+  // and its points are referred to by CurrentPointId
+  int contourId = this->CurrentContourId;
+  if (this->SimplificationTolerance > 0 && contourId >= 0 &&
+      contourId < this->ROIData->GetNumberOfContours() &&
+      this->ROIData->GetContourType(contourId) ==
+        vtkROIContourData::CLOSED_PLANAR)
+    {
+    vtkPoints *points = this->ROIData->GetContourPoints(contourId);
+    if (points)
+      {
+      vtkROIContourSimplifier *simplifier = vtkROIContourSimplifier::New();
+      simplifier->SetTolerance(this->SimplificationTolerance);
+      simplifier->SimplifyPoints(points, 1);
+      simplifier->Delete();
+      this->ROIData->ContourModified(contourId);
+      this->CurrentPointId = -1;
+      }
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -537,6 +558,6 @@ void vtkLassoImageTool::DoAction()
     p[2] = this->InitialPointPosition[2] + dz;
     points->SetPoint(this->CurrentPointId, p);
 
-    this->ROIData->Modified();
+    this->ROIData->ContourModified(this->CurrentContourId);
     }
 }
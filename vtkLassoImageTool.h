@@ -64,6 +64,14 @@ public:
   virtual void SetMarker(vtkPolyData *data);
   virtual vtkPolyData *GetMarker();
 
+  // Description:
+  // If this is set, then when the user finishes drawing or editing a
+  // contour, any points that lie within this distance of the line
+  // between their neighbors will be removed.  The default is zero,
+  // which means that the contours are not simplified.
+  vtkSetMacro(SimplificationTolerance, double);
+  vtkGetMacro(SimplificationTolerance, double);
+
   // Description:
   // These are the methods that are called when the action takes place.
   virtual void StartAction();
@@ -95,6 +103,7 @@ protected:
   vtkIdType CurrentPointId;
   int CurrentContourId;
   double InitialPointPosition[3];
+  double SimplificationTolerance;
 
 private:
   vtkLassoImageTool(const vtkLassoImageTool&);  //Not implemented
@@ -14,83 +14,906 @@
 
 #include "vtkROIContourData.h"
 #include "vtkPoints.h"
+#include "vtkDoubleArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkIdList.h"
+#include "vtkPlane.h"
 #include "vtkSmartPointer.h"
 #include "vtkObjectFactory.h"
 
 #include <stddef.h>
+#include <string.h>
+#include <math.h>
 #include <vector>
+#include <map>
+#include <algorithm>
 
 vtkStandardNewMacro(vtkROIContourData);
 
 //----------------------------------------------------------------------------
-struct vtkROIContourElement
+// The points, the type, and the label of each contour.  With packed
+// storage, the points are views of the packed array, and they are only
+// created when they are asked for.
+class vtkROIContourVector
 {
-  vtkROIContourElement() {
-    this->GeometricType = vtkROIContourData::CLOSED_PLANAR; }
+public:
+  std::vector<vtkSmartPointer<vtkPoints> > Points;
+  std::vector<int> Types;
+  std::vector<int> Labels;
+  std::vector<unsigned long> MTimes;
 
-  vtkSmartPointer<vtkPoints> Points;
-  int GeometricType;
+  void resize(size_t n) {
+    this->Points.resize(n);
+    this->Types.resize(n, vtkROIContourData::CLOSED_PLANAR);
+    this->Labels.resize(n, 0);
+    this->MTimes.resize(n, 0); }
+
+  void clear() {
+    this->Points.clear();
+    this->Types.clear();
+    this->Labels.clear();
+    this->MTimes.clear(); }
+
+  // Mark a contour as modified
+  void Modified(int i) {
+    vtkTimeStamp stamp;
+    stamp.Modified();
+    this->MTimes[static_cast<size_t>(i)] = stamp.GetMTime(); }
+};
+
+//----------------------------------------------------------------------------
+// Check whether points are stored as double triples.
+inline bool vtkROIContourIsDouble(vtkPoints *points)
+{
+  vtkDataArray *data = points->GetData();
+  return (data->GetDataType() == VTK_DOUBLE &&
+          data->GetNumberOfComponents() == 3);
+}
+
+//----------------------------------------------------------------------------
+// Give a view its own copy of its points.
+static void vtkROIContourDetachPoints(vtkPoints *points)
+{
+  vtkDoubleArray *data = vtkDoubleArray::New();
+  data->DeepCopy(points->GetData());
+  points->SetData(data);
+  data->Delete();
+}
+
+//----------------------------------------------------------------------------
+// An index of the contours according to the planes that they lie in.
+// Contours with similar normals are put into the same group, and each
+// group keeps its contours sorted by their offset along the normal.
+// Contours that do not define a plane are kept in a separate list.
+class vtkROIContourIndex
+{
+public:
+  struct Entry
+  {
+    bool Valid;
+    vtkPoints *Points;
+    unsigned long MTime;
+    vtkIdType NumberOfPoints;
+    double Bounds[6];
+    int Group;
+    double Offset[2];
+  };
+
+  struct Group
+  {
+    double Normal[3];
+    double Radius;
+    std::multimap<double, int> Offsets;
+  };
+
+  std::vector<Entry> Entries;
+  std::vector<Group> Groups;
+  std::vector<int> Unplanar;
+
+  // The contours that are not valid, i.e. that must be built
+  std::vector<int> Dirty;
+
+  // Normals that differ by less than this are considered to be equal
+  static const double NormalTolerance;
+
+  void Clear();
+  void Resize(int n);
+  void Invalidate(int i);
+  void Remove(int i);
+  void Build(int i, vtkPoints *points, const double *coords, vtkIdType n);
+
+  // Find contours that might be within tol of plane n.x = d, where n is
+  // a unit vector.  Contours that are certainly within the tolerance are
+  // put in "accepted", others are put in "candidates".
+  void FindCandidates(const double n[3], double d, double tol,
+                      std::vector<int> *accepted,
+                      std::vector<int> *candidates);
+
+private:
+  int CheckBounds(int i, const double n[3], double d, double tol);
 };
 
+const double vtkROIContourIndex::NormalTolerance = 1e-6;
+
+//----------------------------------------------------------------------------
+void vtkROIContourIndex::Clear()
+{
+  this->Entries.clear();
+  this->Groups.clear();
+  this->Unplanar.clear();
+  this->Dirty.clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourIndex::Resize(int n)
+{
+  size_t m = this->Entries.size();
+  for (size_t i = static_cast<size_t>(n); i < m; i++)
+    {
+    this->Invalidate(static_cast<int>(i));
+    }
+  if (static_cast<size_t>(n) < m)
+    {
+    size_t k = 0;
+    for (size_t j = 0; j < this->Dirty.size(); j++)
+      {
+      if (this->Dirty[j] < n)
+        {
+        this->Dirty[k++] = this->Dirty[j];
+        }
+      }
+    this->Dirty.resize(k);
+    }
+  for (int i = static_cast<int>(m); i < n; i++)
+    {
+    this->Dirty.push_back(i);
+    }
+
+  Entry e;
+  e.Valid = false;
+  e.Points = 0;
+  e.MTime = 0;
+  e.NumberOfPoints = 0;
+  e.Group = -1;
+  this->Entries.resize(static_cast<size_t>(n), e);
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourIndex::Invalidate(int i)
+{
+  if (static_cast<size_t>(i) >= this->Entries.size())
+    {
+    return;
+    }
+
+  Entry *e = &this->Entries[static_cast<size_t>(i)];
+  if (e->Valid)
+    {
+    if (e->Group >= 0)
+      {
+      std::multimap<double, int> *offsets =
+        &this->Groups[static_cast<size_t>(e->Group)].Offsets;
+      std::multimap<double, int>::iterator iter =
+        offsets->lower_bound(e->Offset[0]);
+      while (iter != offsets->end() && iter->second != i)
+        {
+        ++iter;
+        }
+      if (iter != offsets->end())
+        {
+        offsets->erase(iter);
+        }
+      }
+    else
+      {
+      this->Unplanar.erase(std::find(
+        this->Unplanar.begin(), this->Unplanar.end(), i));
+      }
+    this->Dirty.push_back(i);
+    }
+
+  e->Valid = false;
+  e->Points = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourIndex::Remove(int i)
+{
+  if (static_cast<size_t>(i) >= this->Entries.size())
+    {
+    return;
+    }
+
+  this->Invalidate(i);
+  this->Entries.erase(this->Entries.begin() + i);
+  std::vector<int>::iterator dirty =
+    std::find(this->Dirty.begin(), this->Dirty.end(), i);
+  if (dirty != this->Dirty.end())
+    {
+    this->Dirty.erase(dirty);
+    }
+
+  // Renumber the contours that follow the removed contour
+  for (size_t j = 0; j < this->Groups.size(); j++)
+    {
+    std::multimap<double, int> *offsets = &this->Groups[j].Offsets;
+    std::multimap<double, int>::iterator iter;
+    for (iter = offsets->begin(); iter != offsets->end(); ++iter)
+      {
+      iter->second -= (iter->second > i);
+      }
+    }
+  for (size_t k = 0; k < this->Unplanar.size(); k++)
+    {
+    this->Unplanar[k] -= (this->Unplanar[k] > i);
+    }
+  for (size_t k = 0; k < this->Dirty.size(); k++)
+    {
+    this->Dirty[k] -= (this->Dirty[k] > i);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourIndex::Build(
+  int i, vtkPoints *points, const double *coords, vtkIdType n)
+{
+  this->Invalidate(i);
+
+  Entry *e = &this->Entries[static_cast<size_t>(i)];
+  e->Valid = true;
+  e->Points = points;
+  e->MTime = (points ? points->GetMTime() : 0);
+  e->NumberOfPoints = n;
+  e->Group = -1;
+  e->Offset[0] = 0.0;
+  e->Offset[1] = 0.0;
+
+  double *bounds = e->Bounds;
+  bounds[0] = bounds[2] = bounds[4] = 1.0;
+  bounds[1] = bounds[3] = bounds[5] = -1.0;
+
+  // Compute the bounds and the normal (with Newell's method)
+  double normal[3] = { 0.0, 0.0, 0.0 };
+  double p[3], q[3];
+  for (vtkIdType j = 0; j < n; j++)
+    {
+    vtkIdType k = (j + 1 < n ? j + 1 : 0);
+    if (coords)
+      {
+      p[0] = coords[3*j]; p[1] = coords[3*j+1]; p[2] = coords[3*j+2];
+      q[0] = coords[3*k]; q[1] = coords[3*k+1]; q[2] = coords[3*k+2];
+      }
+    else
+      {
+      points->GetPoint(j, p);
+      points->GetPoint(k, q);
+      }
+    for (int l = 0; l < 3; l++)
+      {
+      if (j == 0 || p[l] < bounds[2*l]) { bounds[2*l] = p[l]; }
+      if (j == 0 || p[l] > bounds[2*l+1]) { bounds[2*l+1] = p[l]; }
+      }
+    normal[0] += (p[1] - q[1])*(p[2] + q[2]);
+    normal[1] += (p[2] - q[2])*(p[0] + q[0]);
+    normal[2] += (p[0] - q[0])*(p[1] + q[1]);
+    }
+
+  // The normal is unreliable for contours with a tiny area
+  double size2 = 0.0;
+  double radius2 = 0.0;
+  for (int l = 0; l < 3; l++)
+    {
+    double b = bounds[2*l+1] - bounds[2*l];
+    double c = (fabs(bounds[2*l]) > fabs(bounds[2*l+1]) ?
+                bounds[2*l] : bounds[2*l+1]);
+    size2 += b*b;
+    radius2 += c*c;
+    }
+  double norm = sqrt(normal[0]*normal[0] + normal[1]*normal[1] +
+                     normal[2]*normal[2]);
+  if (n < 3 || norm <= 1e-6*size2)
+    {
+    this->Unplanar.push_back(i);
+    return;
+    }
+
+  // Make the largest component positive, so that the normal is unique
+  int maxl = 0;
+  for (int l = 1; l < 3; l++)
+    {
+    if (fabs(normal[l]) > fabs(normal[maxl])) { maxl = l; }
+    }
+  if (normal[maxl] < 0) { norm = -norm; }
+  normal[0] /= norm;
+  normal[1] /= norm;
+  normal[2] /= norm;
+
+  // Find the group for this normal
+  size_t g = 0;
+  for (; g < this->Groups.size(); g++)
+    {
+    double *v = this->Groups[g].Normal;
+    if (fabs(v[0] - normal[0]) < NormalTolerance &&
+        fabs(v[1] - normal[1]) < NormalTolerance &&
+        fabs(v[2] - normal[2]) < NormalTolerance)
+      {
+      break;
+      }
+    }
+  if (g == this->Groups.size())
+    {
+    Group group;
+    group.Normal[0] = normal[0];
+    group.Normal[1] = normal[1];
+    group.Normal[2] = normal[2];
+    group.Radius = 0.0;
+    this->Groups.push_back(group);
+    }
+  Group *group = &this->Groups[g];
+
+  // Get the range of offsets along the group normal
+  const double *v = group->Normal;
+  for (vtkIdType j = 0; j < n; j++)
+    {
+    if (coords)
+      {
+      p[0] = coords[3*j]; p[1] = coords[3*j+1]; p[2] = coords[3*j+2];
+      }
+    else
+      {
+      points->GetPoint(j, p);
+      }
+    double d = v[0]*p[0] + v[1]*p[1] + v[2]*p[2];
+    if (j == 0 || d < e->Offset[0]) { e->Offset[0] = d; }
+    if (j == 0 || d > e->Offset[1]) { e->Offset[1] = d; }
+    }
+
+  double radius = sqrt(radius2);
+  if (radius > group->Radius) { group->Radius = radius; }
+
+  e->Group = static_cast<int>(g);
+  group->Offsets.insert(std::pair<const double, int>(e->Offset[0], i));
+}
+
+//----------------------------------------------------------------------------
+// Check the bounds of a contour against the plane: returns 1 if the
+// contour is within tolerance, 0 if it is not, and -1 if the points
+// must be checked.
+int vtkROIContourIndex::CheckBounds(
+  int i, const double n[3], double d, double tol)
+{
+  const Entry *e = &this->Entries[static_cast<size_t>(i)];
+  const double *bounds = e->Bounds;
+
+  if (e->NumberOfPoints == 0)
+    {
+    return 1;
+    }
+
+  double c = 0.0;
+  double r = 0.0;
+  for (int l = 0; l < 3; l++)
+    {
+    c += 0.5*n[l]*(bounds[2*l] + bounds[2*l+1]);
+    r += 0.5*fabs(n[l])*(bounds[2*l+1] - bounds[2*l]);
+    }
+
+  if (c - r >= d - tol && c + r <= d + tol)
+    {
+    return 1;
+    }
+  if (c + r < d - tol || c - r > d + tol)
+    {
+    return 0;
+    }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourIndex::FindCandidates(
+  const double normal[3], double offset, double tol,
+  std::vector<int> *accepted, std::vector<int> *candidates)
+{
+  std::vector<int>::iterator uiter;
+  for (uiter = this->Unplanar.begin(); uiter != this->Unplanar.end(); ++uiter)
+    {
+    int result = this->CheckBounds(*uiter, normal, offset, tol);
+    if (result > 0) { accepted->push_back(*uiter); }
+    else if (result < 0) { candidates->push_back(*uiter); }
+    }
+
+  for (size_t g = 0; g < this->Groups.size(); g++)
+    {
+    Group *group = &this->Groups[g];
+    const double *v = group->Normal;
+
+    // Flip the plane, if necessary, to match the group normal
+    double n[3] = { normal[0], normal[1], normal[2] };
+    double d = offset;
+    if (n[0]*v[0] + n[1]*v[1] + n[2]*v[2] < 0)
+      {
+      n[0] = -n[0]; n[1] = -n[1]; n[2] = -n[2];
+      d = -d;
+      }
+
+    // The largest difference between the offset along the plane normal
+    // and the offset along the group normal, for any point in the group
+    double e[3] = { n[0] - v[0], n[1] - v[1], n[2] - v[2] };
+    double slack = sqrt(e[0]*e[0] + e[1]*e[1] + e[2]*e[2])*group->Radius;
+
+    std::multimap<double, int>::iterator iter;
+    std::multimap<double, int>::iterator endIter;
+    if (slack > tol)
+      {
+      // The plane is oblique to these contours, check all of them
+      iter = group->Offsets.begin();
+      endIter = group->Offsets.end();
+      }
+    else
+      {
+      // Any contour with its lowest point below this range has a point
+      // that is outside of the tolerance
+      iter = group->Offsets.lower_bound(d - tol - slack);
+      endIter = group->Offsets.upper_bound(d + tol + slack);
+      }
+
+    for (; iter != endIter; ++iter)
+      {
+      int i = iter->second;
+      const Entry *entry = &this->Entries[static_cast<size_t>(i)];
+      int result = -1;
+      if (entry->Offset[0] - slack >= d - tol &&
+          entry->Offset[1] + slack <= d + tol)
+        {
+        result = 1;
+        }
+      else if (entry->Offset[0] + slack < d - tol ||
+               entry->Offset[1] - slack > d + tol)
+        {
+        result = 0;
+        }
+      else
+        {
+        result = this->CheckBounds(i, n, d, tol);
+        }
+      if (result > 0) { accepted->push_back(i); }
+      else if (result < 0) { candidates->push_back(i); }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkROIContourData::vtkROIContourData()
+{
+  this->Contours = new vtkROIContourVector;
+  this->NumberOfContours = 0;
+
+  this->PackedStorage = 0;
+  this->PackedPoints = 0;
+  this->PackedOffsets = 0;
+
+  this->Index = new vtkROIContourIndex;
+  this->TrackedMTime = 0;
+  this->UntrackedMTime = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkROIContourData::~vtkROIContourData()
+{
+  this->Initialize();
+  delete this->Contours;
+  delete this->Index;
+
+  if (this->PackedPoints) { this->PackedPoints->Delete(); }
+  if (this->PackedOffsets) { this->PackedOffsets->Delete(); }
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourData::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "NumberOfContours: " << this->NumberOfContours << "\n";
+  os << indent << "PackedStorage: "
+     << (this->PackedStorage ? "On\n" : "Off\n");
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourData::SetNumberOfContours(int n)
+{
+  if (n != this->NumberOfContours && n >= 0)
+    {
+    if (this->PackedStorage)
+      {
+      this->PreparePackedEdit();
+      for (int i = n; i < this->NumberOfContours; i++)
+        {
+        this->ReleaseView(i);
+        }
+      // New contours are empty, removed contours are truncated
+      vtkIdType m = this->PackedOffsets->GetValue(
+        n < this->NumberOfContours ? n : this->NumberOfContours);
+      if (n < this->NumberOfContours)
+        {
+        this->PackedOffsets->SetNumberOfTuples(n + 1);
+        this->PackedPoints->SetNumberOfTuples(m);
+        }
+      for (int j = this->NumberOfContours + 1; j <= n; j++)
+        {
+        this->PackedOffsets->InsertNextValue(m);
+        }
+      }
+
+    this->NumberOfContours = n;
+    this->Contours->resize(static_cast<size_t>(n));
+    this->Index->Resize(n);
+    this->TrackedModified();
+    this->PackTime.Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourData::SetContourPoints(int i, vtkPoints *points)
+{
+  if (i < 0 || i >= this->NumberOfContours)
+    {
+    vtkErrorMacro("index " << i << " is too large");
+    }
+  else
+    {
+    vtkPoints *oldPoints = this->Contours->Points[static_cast<size_t>(i)];
+    if (oldPoints != points || (this->PackedStorage && !points))
+      {
+      if (this->PackedStorage)
+        {
+        // The packed array will be rebuilt with the new points
+        this->ReleaseView(i);
+        }
+      this->Contours->Points[static_cast<size_t>(i)] = points;
+      if (this->PackedStorage && !points)
+        {
+        // With packed storage, a NULL contour is an empty contour
+        vtkPoints *empty = vtkPoints::New(VTK_DOUBLE);
+        this->Contours->Points[static_cast<size_t>(i)] = empty;
+        empty->Delete();
+        }
+      this->Contours->Modified(i);
+      this->Index->Invalidate(i);
+      this->TrackedModified();
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkPoints *vtkROIContourData::GetContourPoints(int i)
+{
+  vtkPoints *points = 0;
+
+  if (i < 0 || i >= this->NumberOfContours)
+    {
+    vtkErrorMacro("index " << i << " is too large");
+    }
+  else
+    {
+    if (this->PackedStorage)
+      {
+      this->UpdatePacking();
+      if (!this->Contours->Points[static_cast<size_t>(i)])
+        {
+        // Make a view of the packed points
+        vtkIdType *offsets = this->PackedOffsets->GetPointer(0);
+        vtkIdType m = offsets[i+1] - offsets[i];
+        vtkDoubleArray *data = vtkDoubleArray::New();
+        data->SetNumberOfComponents(3);
+        data->SetArray(this->PackedPoints->GetPointer(3*offsets[i]),
+                       3*m, 1);
+        points = vtkPoints::New();
+        points->SetData(data);
+        data->Delete();
+        this->Contours->Points[static_cast<size_t>(i)] = points;
+        points->Delete();
+        }
+      }
+    points = this->Contours->Points[static_cast<size_t>(i)];
+    }
+
+  return points;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkROIContourData::GetNumberOfContourPoints(int i)
+{
+  vtkIdType m = 0;
+
+  if (i < 0 || i >= this->NumberOfContours)
+    {
+    vtkErrorMacro("index " << i << " is too large");
+    }
+  else if (this->PackedStorage)
+    {
+    this->UpdatePacking();
+    vtkIdType *offsets = this->PackedOffsets->GetPointer(0);
+    m = offsets[i+1] - offsets[i];
+    }
+  else
+    {
+    vtkPoints *points = this->Contours->Points[static_cast<size_t>(i)];
+    m = (points ? points->GetNumberOfPoints() : 0);
+    }
+
+  return m;
+}
+
+//----------------------------------------------------------------------------
+double *vtkROIContourData::GetContourCoordinates(int i)
+{
+  double *coords = 0;
+
+  if (i < 0 || i >= this->NumberOfContours)
+    {
+    vtkErrorMacro("index " << i << " is too large");
+    }
+  else if (this->PackedStorage)
+    {
+    this->UpdatePacking();
+    vtkIdType *offsets = this->PackedOffsets->GetPointer(0);
+    coords = this->PackedPoints->GetPointer(3*offsets[i]);
+    }
+  else
+    {
+    vtkPoints *points = this->Contours->Points[static_cast<size_t>(i)];
+    if (points && vtkROIContourIsDouble(points))
+      {
+      coords = static_cast<double *>(points->GetVoidPointer(0));
+      }
+    }
+
+  return coords;
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourData::PrepareForEdit()
+{
+  if (this->PackedStorage)
+    {
+    this->PreparePackedEdit();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourData::TruncateContours(vtkIdTypeArray *numPoints)
+{
+  if (numPoints->GetNumberOfTuples() < this->NumberOfContours)
+    {
+    vtkErrorMacro("TruncateContours: need a size for each contour");
+    return;
+    }
+
+  const vtkIdType *sizes = numPoints->GetPointer(0);
+
+  if (this->PackedStorage)
+    {
+    // Slide the points of each contour down to fill the gaps
+    this->PreparePackedEdit();
+    double *coords = this->PackedPoints->GetPointer(0);
+    vtkIdType *offsets = this->PackedOffsets->GetPointer(0);
+    vtkIdType m = 0;
+    for (int i = 0; i < this->NumberOfContours; i++)
+      {
+      vtkIdType n = offsets[i+1] - offsets[i];
+      n = (sizes[i] < n ? (sizes[i] > 0 ? sizes[i] : 0) : n);
+      if (m != offsets[i] && n > 0)
+        {
+        memmove(coords + 3*m, coords + 3*offsets[i], 3*n*sizeof(double));
+        }
+      offsets[i] = m;
+      m += n;
+      }
+    offsets[this->NumberOfContours] = m;
+    this->PackedPoints->SetNumberOfTuples(m);
+    this->UpdateViews();
+    }
+  else
+    {
+    for (int i = 0; i < this->NumberOfContours; i++)
+      {
+      vtkPoints *points = this->Contours->Points[static_cast<size_t>(i)];
+      if (points && sizes[i] < points->GetNumberOfPoints())
+        {
+        points->SetNumberOfPoints(sizes[i] > 0 ? sizes[i] : 0);
+        points->Modified();
+        }
+      }
+    }
+
+  for (int i = 0; i < this->NumberOfContours; i++)
+    {
+    this->Contours->Modified(i);
+    this->Index->Invalidate(i);
+    }
+  this->TrackedModified();
+  if (this->PackedStorage)
+    {
+    this->PackTime.Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourData::GetContourBounds(int i, double bounds[6])
+{
+  if (i < 0 || i >= this->NumberOfContours)
+    {
+    vtkErrorMacro("index " << i << " is too large");
+    bounds[0] = bounds[2] = bounds[4] = 1.0;
+    bounds[1] = bounds[3] = bounds[5] = -1.0;
+    }
+  else
+    {
+    this->UpdateIndex();
+    const double *b = this->Index->Entries[static_cast<size_t>(i)].Bounds;
+    for (int j = 0; j < 6; j++)
+      {
+      bounds[j] = b[j];
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
-class vtkROIContourVector : public std::vector<vtkROIContourElement>
+void vtkROIContourData::ContourModified(int i)
 {
-};
+  if (i < 0 || i >= this->NumberOfContours)
+    {
+    vtkErrorMacro("index " << i << " is too large");
+    }
+  else
+    {
+    this->Contours->Modified(i);
+    this->Index->Invalidate(i);
+    this->TrackedModified();
+    }
+}
 
 //----------------------------------------------------------------------------
-vtkROIContourData::vtkROIContourData()
+unsigned long vtkROIContourData::GetContourMTime(int i)
 {
-  this->Contours = new vtkROIContourVector;
-  this->NumberOfContours = 0;
+  unsigned long mtime = 0;
+
+  if (i < 0 || i >= this->NumberOfContours)
+    {
+    vtkErrorMacro("index " << i << " is too large");
+    }
+  else
+    {
+    mtime = this->Contours->MTimes[static_cast<size_t>(i)];
+    vtkPoints *points = this->Contours->Points[static_cast<size_t>(i)];
+    if (points && points->GetMTime() > mtime)
+      {
+      mtime = points->GetMTime();
+      }
+    // If Modified() was called directly, then any contour might have
+    // been changed
+    unsigned long untracked = this->UntrackedMTime;
+    if (this->GetMTime() > this->TrackedMTime)
+      {
+      untracked = this->GetMTime();
+      }
+    if (untracked > mtime)
+      {
+      mtime = untracked;
+      }
+    }
+
+  return mtime;
 }
 
 //----------------------------------------------------------------------------
-vtkROIContourData::~vtkROIContourData()
+void vtkROIContourData::FindContoursNearPlane(
+  vtkPlane *plane, double tol, vtkIdList *contourIds)
 {
-  delete this->Contours;
+  double origin[3], normal[3];
+  plane->GetOrigin(origin);
+  plane->GetNormal(normal);
+  this->FindContoursNearPlane(origin, normal, tol, contourIds);
 }
 
 //----------------------------------------------------------------------------
-void vtkROIContourData::PrintSelf(ostream& os, vtkIndent indent)
+void vtkROIContourData::FindContoursNearPlane(
+  const double origin[3], const double normal[3], double tol,
+  vtkIdList *contourIds)
 {
-  this->Superclass::PrintSelf(os,indent);
+  contourIds->Reset();
 
-  os << indent << "NumberOfContours: " << this->NumberOfContours << "\n";
-}
+  double n[3] = { normal[0], normal[1], normal[2] };
+  double norm = sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+  if (norm == 0)
+    {
+    // Every point is on a degenerate plane
+    for (int i = 0; i < this->NumberOfContours; i++)
+      {
+      contourIds->InsertNextId(i);
+      }
+    return;
+    }
 
-//----------------------------------------------------------------------------
-void vtkROIContourData::SetNumberOfContours(int n)
-{
-  if (n != this->NumberOfContours && n >= 0)
+  // Use a unit normal, and scale the tolerance to match
+  n[0] /= norm;
+  n[1] /= norm;
+  n[2] /= norm;
+  tol /= norm;
+  double d = n[0]*origin[0] + n[1]*origin[1] + n[2]*origin[2];
+
+  this->UpdateIndex();
+
+  std::vector<int> accepted;
+  std::vector<int> candidates;
+  this->Index->FindCandidates(n, d, tol, &accepted, &candidates);
+
+  // Check all the points of contours that straddle the tolerance
+  std::vector<int>::iterator iter;
+  for (iter = candidates.begin(); iter != candidates.end(); ++iter)
     {
-    this->NumberOfContours = n;
-    this->Contours->resize(static_cast<size_t>(n));
-    this->Modified();
+    int i = *iter;
+    vtkPoints *points = this->Contours->Points[static_cast<size_t>(i)];
+    const double *coords = this->GetContourCoordinates(i);
+    vtkIdType m = this->GetNumberOfContourPoints(i);
+    vtkIdType j = 0;
+    for (; j < m; j++)
+      {
+      double p[3];
+      if (coords)
+        {
+        p[0] = coords[3*j]; p[1] = coords[3*j+1]; p[2] = coords[3*j+2];
+        }
+      else
+        {
+        points->GetPoint(j, p);
+        }
+      double dist = n[0]*p[0] + n[1]*p[1] + n[2]*p[2] - d;
+      if (dist < -tol || dist > tol)
+        {
+        break;
+        }
+      }
+    if (j == m)
+      {
+      accepted.push_back(i);
+      }
+    }
+
+  std::sort(accepted.begin(), accepted.end());
+  for (iter = accepted.begin(); iter != accepted.end(); ++iter)
+    {
+    contourIds->InsertNextId(*iter);
     }
 }
 
 //----------------------------------------------------------------------------
-void vtkROIContourData::SetContourPoints(int i, vtkPoints *points)
+void vtkROIContourData::SetContourType(int i, int t)
 {
   if (i < 0 || i >= this->NumberOfContours)
     {
     vtkErrorMacro("index " << i << " is too large");
     }
+  else if (t < vtkROIContourData::POINT || t > vtkROIContourData::CLOSED_PLANAR)
+    {
+    vtkErrorMacro("unrecognized contour type " << t);
+    }
   else
     {
-    vtkROIContourElement *contour = &(*this->Contours)[static_cast<size_t>(i)];
-    if (contour->Points != points)
+    int *type = &this->Contours->Types[static_cast<size_t>(i)];
+    if (*type != t)
       {
-      contour->Points = points;
-      this->Modified();
+      *type = t;
+      this->Contours->Modified(i);
+      this->TrackedModified();
       }
     }
 }
 
 //----------------------------------------------------------------------------
-vtkPoints *vtkROIContourData::GetContourPoints(int i)
+int vtkROIContourData::GetContourType(int i)
 {
-  vtkPoints *points = 0;
+  int t = 0;
 
   if (i < 0 || i >= this->NumberOfContours)
     {
@@ -98,39 +921,34 @@ vtkPoints *vtkROIContourData::GetContourPoints(int i)
     }
   else
     {
-    vtkROIContourElement *contour = &(*this->Contours)[static_cast<size_t>(i)];
-    points = contour->Points;
+    t = this->Contours->Types[static_cast<size_t>(i)];
     }
 
-  return points;
+  return t;
 }
 
 //----------------------------------------------------------------------------
-void vtkROIContourData::SetContourType(int i, int t)
+void vtkROIContourData::SetContourLabel(int i, int label)
 {
   if (i < 0 || i >= this->NumberOfContours)
     {
     vtkErrorMacro("index " << i << " is too large");
     }
-  else if (t < vtkROIContourData::POINT || t > vtkROIContourData::CLOSED_PLANAR)
-    {
-    vtkErrorMacro("unrecognized contour type " << t);
-    }
   else
     {
-    vtkROIContourElement *contour = &(*this->Contours)[static_cast<size_t>(i)];
-    if (contour->GeometricType != t)
+    int *l = &this->Contours->Labels[static_cast<size_t>(i)];
+    if (*l != label)
       {
-      contour->GeometricType = t;
-      this->Modified();
+      *l = label;
+      this->TrackedModified();
       }
     }
 }
 
 //----------------------------------------------------------------------------
-int vtkROIContourData::GetContourType(int i)
+int vtkROIContourData::GetContourLabel(int i)
 {
-  int t = 0;
+  int label = 0;
 
   if (i < 0 || i >= this->NumberOfContours)
     {
@@ -138,11 +956,10 @@ int vtkROIContourData::GetContourType(int i)
     }
   else
     {
-    vtkROIContourElement *contour = &(*this->Contours)[static_cast<size_t>(i)];
-    t = contour->GeometricType;
+    label = this->Contours->Labels[static_cast<size_t>(i)];
     }
 
-  return t;
+  return label;
 }
 
 //----------------------------------------------------------------------------
@@ -154,15 +971,407 @@ void vtkROIContourData::RemoveContour(int i)
     }
   else
     {
-    this->Contours->erase(this->Contours->begin() + i);
+    if (this->PackedStorage)
+      {
+      // Shift the following points down over the removed points
+      this->PreparePackedEdit();
+      this->ReleaseView(i);
+      vtkIdType *offsets = this->PackedOffsets->GetPointer(0);
+      vtkIdType m = offsets[i+1] - offsets[i];
+      vtkIdType numPoints = offsets[this->NumberOfContours];
+      double *coords = this->PackedPoints->GetPointer(0);
+      memmove(coords + 3*offsets[i], coords + 3*offsets[i+1],
+              3*(numPoints - offsets[i+1])*sizeof(double));
+      for (int j = i + 1; j < this->NumberOfContours; j++)
+        {
+        offsets[j] = offsets[j+1] - m;
+        }
+      this->PackedOffsets->SetNumberOfTuples(this->NumberOfContours);
+      this->PackedPoints->SetNumberOfTuples(numPoints - m);
+      }
+
+    this->Contours->Points.erase(this->Contours->Points.begin() + i);
+    this->Contours->Types.erase(this->Contours->Types.begin() + i);
+    this->Contours->Labels.erase(this->Contours->Labels.begin() + i);
+    this->Contours->MTimes.erase(this->Contours->MTimes.begin() + i);
+    this->NumberOfContours--;
+    this->Index->Remove(i);
+
+    if (this->PackedStorage)
+      {
+      this->UpdateViews();
+      }
+
+    this->TrackedModified();
+    this->PackTime.Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkROIContourData::InsertNextContour(
+  int t, vtkIdType numPoints, const double *points)
+{
+  int i = this->NumberOfContours;
+
+  if (this->PackedStorage)
+    {
+    this->PreparePackedEdit();
+    double *oldCoords = this->PackedPoints->GetPointer(0);
+    vtkIdType m = this->PackedOffsets->GetValue(i);
+    if (numPoints > 0)
+      {
+      // WritePointer() grows the array by doubling its size
+      double *coords = this->PackedPoints->WritePointer(3*m, 3*numPoints);
+      memcpy(coords, points, 3*numPoints*sizeof(double));
+      }
+    this->PackedOffsets->InsertNextValue(m + numPoints);
+    this->Contours->Points.push_back(0);
+    this->Contours->Types.push_back(t);
+    this->Contours->Labels.push_back(0);
+    this->Contours->MTimes.push_back(0);
+    this->Contours->Modified(i);
+    this->NumberOfContours++;
+    this->Index->Resize(this->NumberOfContours);
+    if (this->PackedPoints->GetPointer(0) != oldCoords)
+      {
+      this->UpdateViews();
+      }
+    this->TrackedModified();
+    this->PackTime.Modified();
+    }
+  else
+    {
+    vtkPoints *newPoints = vtkPoints::New(VTK_DOUBLE);
+    newPoints->SetNumberOfPoints(numPoints);
+    if (numPoints > 0)
+      {
+      memcpy(newPoints->GetVoidPointer(0), points,
+             3*numPoints*sizeof(double));
+      }
+    this->SetNumberOfContours(i + 1);
+    this->SetContourPoints(i, newPoints);
+    this->SetContourType(i, t);
+    newPoints->Delete();
+    }
+
+  return i;
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourData::SetPackedStorage(int val)
+{
+  val = (val != 0);
+  if (val == this->PackedStorage)
+    {
+    return;
+    }
+
+  if (val)
+    {
+    // Copy all of the points into a packed array
+    this->PackedStorage = 1;
+    this->PackedPoints = vtkDoubleArray::New();
+    this->PackedPoints->SetNumberOfComponents(3);
+    this->PackedOffsets = vtkIdTypeArray::New();
+    this->PackedOffsets->SetNumberOfTuples(this->NumberOfContours + 1);
+    for (int i = 0; i <= this->NumberOfContours; i++)
+      {
+      this->PackedOffsets->SetValue(i, 0);
+      }
+    this->Repack();
+    }
+  else
+    {
+    // Give every contour its own points
+    this->UpdatePacking();
+    vtkIdType *offsets = this->PackedOffsets->GetPointer(0);
+    for (int i = 0; i < this->NumberOfContours; i++)
+      {
+      vtkPoints *points = this->Contours->Points[static_cast<size_t>(i)];
+      if (points)
+        {
+        vtkROIContourDetachPoints(points);
+        }
+      else if (offsets[i+1] > offsets[i])
+        {
+        this->GetContourPoints(i);
+        vtkROIContourDetachPoints(
+          this->Contours->Points[static_cast<size_t>(i)]);
+        }
+      }
+    this->PackedStorage = 0;
+    this->PackedPoints->Delete();
+    this->PackedPoints = 0;
+    this->PackedOffsets->Delete();
+    this->PackedOffsets = 0;
+    }
+
+  this->Modified();
+  this->PackTime.Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkDoubleArray *vtkROIContourData::GetPackedPoints()
+{
+  if (this->PackedStorage)
+    {
+    this->UpdatePacking();
+    }
+  return this->PackedPoints;
+}
+
+//----------------------------------------------------------------------------
+vtkIdTypeArray *vtkROIContourData::GetPackedOffsets()
+{
+  if (this->PackedStorage)
+    {
+    this->UpdatePacking();
+    }
+  return this->PackedOffsets;
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourData::UpdatePacking()
+{
+  if (this->GetMTime() <= this->PackTime.GetMTime())
+    {
+    return;
+    }
+
+  // Check whether any views were resized or given different data
+  const double *coords = this->PackedPoints->GetPointer(0);
+  const vtkIdType *offsets = this->PackedOffsets->GetPointer(0);
+  bool needsRepack = false;
+  for (int i = 0; i < this->NumberOfContours && !needsRepack; i++)
+    {
+    vtkPoints *points = this->Contours->Points[static_cast<size_t>(i)];
+    if (points)
+      {
+      vtkIdType m = offsets[i+1] - offsets[i];
+      needsRepack = (!vtkROIContourIsDouble(points) ||
+                     points->GetNumberOfPoints() != m ||
+                     (m > 0 && points->GetVoidPointer(0) !=
+                      coords + 3*offsets[i]));
+      }
+    }
+
+  if (needsRepack)
+    {
+    this->Repack();
+    }
+
+  this->PackTime.Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourData::Repack()
+{
+  // The views are authoritative, other contours are in the packed array
+  const double *oldCoords = this->PackedPoints->GetPointer(0);
+  vtkIdTypeArray *newOffsets = vtkIdTypeArray::New();
+  newOffsets->SetNumberOfTuples(this->NumberOfContours + 1);
+  vtkIdType *offsets = this->PackedOffsets->GetPointer(0);
+  vtkIdType *noffsets = newOffsets->GetPointer(0);
+
+  vtkIdType numPoints = 0;
+  for (int i = 0; i < this->NumberOfContours; i++)
+    {
+    vtkPoints *points = this->Contours->Points[static_cast<size_t>(i)];
+    noffsets[i] = numPoints;
+    numPoints += (points ? points->GetNumberOfPoints() :
+                  offsets[i+1] - offsets[i]);
+    }
+  noffsets[this->NumberOfContours] = numPoints;
+
+  vtkDoubleArray *newPoints = vtkDoubleArray::New();
+  newPoints->SetNumberOfComponents(3);
+  newPoints->SetNumberOfTuples(numPoints);
+  double *coords = newPoints->GetPointer(0);
+
+  for (int i = 0; i < this->NumberOfContours; i++)
+    {
+    vtkPoints *points = this->Contours->Points[static_cast<size_t>(i)];
+    double *dest = coords + 3*noffsets[i];
+    vtkIdType m = noffsets[i+1] - noffsets[i];
+    if (!points)
+      {
+      memcpy(dest, oldCoords + 3*offsets[i], 3*m*sizeof(double));
+      }
+    else if (vtkROIContourIsDouble(points))
+      {
+      if (m > 0)
+        {
+        memcpy(dest, points->GetVoidPointer(0), 3*m*sizeof(double));
+        }
+      }
+    else
+      {
+      for (vtkIdType j = 0; j < m; j++)
+        {
+        points->GetPoint(j, &dest[3*j]);
+        }
+      // Convert the points to double in place, so that the caller still
+      // has the same vtkPoints object, and make them into a view
+      vtkDoubleArray *data = vtkDoubleArray::New();
+      data->SetNumberOfComponents(3);
+      points->SetData(data);
+      data->Delete();
+      }
+    }
+
+  this->PackedPoints->Delete();
+  this->PackedPoints = newPoints;
+  this->PackedOffsets->Delete();
+  this->PackedOffsets = newOffsets;
+
+  this->UpdateViews();
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourData::UpdateViews()
+{
+  double *coords = this->PackedPoints->GetPointer(0);
+  vtkIdType *offsets = this->PackedOffsets->GetPointer(0);
+  for (int i = 0; i < this->NumberOfContours; i++)
+    {
+    vtkPoints *points = this->Contours->Points[static_cast<size_t>(i)];
+    if (points)
+      {
+      vtkDoubleArray *data = static_cast<vtkDoubleArray *>(points->GetData());
+      data->SetArray(coords + 3*offsets[i], 3*(offsets[i+1] - offsets[i]), 1);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourData::PreparePackedEdit()
+{
+  this->UpdatePacking();
+
+  // Copy on write, if the arrays are shared with another object
+  if (this->PackedPoints->GetReferenceCount() > 1)
+    {
+    vtkDoubleArray *newPoints = vtkDoubleArray::New();
+    newPoints->DeepCopy(this->PackedPoints);
+    this->PackedPoints->Delete();
+    this->PackedPoints = newPoints;
+    this->UpdateViews();
+    }
+  if (this->PackedOffsets->GetReferenceCount() > 1)
+    {
+    vtkIdTypeArray *newOffsets = vtkIdTypeArray::New();
+    newOffsets->DeepCopy(this->PackedOffsets);
+    this->PackedOffsets->Delete();
+    this->PackedOffsets = newOffsets;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourData::ReleaseView(int i)
+{
+  vtkPoints *points = this->Contours->Points[static_cast<size_t>(i)];
+
+  // If someone else is holding the view, then it must be given its
+  // own copy of the points before the packed array goes away
+  if (points && points->GetReferenceCount() > 1 &&
+      vtkROIContourIsDouble(points))
+    {
+    double *coords = this->PackedPoints->GetPointer(0);
+    vtkIdType numPoints = this->PackedPoints->GetNumberOfTuples();
+    double *ptr = static_cast<double *>(points->GetVoidPointer(0));
+    if (ptr >= coords && ptr < coords + 3*numPoints)
+      {
+      vtkROIContourDetachPoints(points);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourData::TrackedModified()
+{
+  if (this->GetMTime() > this->TrackedMTime)
+    {
+    this->UntrackedMTime = this->GetMTime();
+    }
+  this->Modified();
+  this->TrackedMTime = this->GetMTime();
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourData::UpdateIndex()
+{
+  if (this->GetMTime() <= this->IndexTime.GetMTime())
+    {
+    return;
+    }
+
+  if (this->PackedStorage)
+    {
+    this->UpdatePacking();
+    }
+
+  vtkROIContourIndex *index = this->Index;
+  index->Resize(this->NumberOfContours);
+
+  if (this->GetMTime() > this->TrackedMTime ||
+      this->UntrackedMTime > this->IndexTime.GetMTime())
+    {
+    // Modified() was called directly, so the points might have been
+    // changed without the contours being marked, check all of them
+    for (int i = 0; i < this->NumberOfContours; i++)
+      {
+      vtkROIContourIndex::Entry *e = &index->Entries[static_cast<size_t>(i)];
+      vtkPoints *points = this->Contours->Points[static_cast<size_t>(i)];
+      vtkIdType m = this->GetNumberOfContourPoints(i);
+      if (!e->Valid || e->Points != points || e->NumberOfPoints != m ||
+          (points && e->MTime != points->GetMTime()))
+        {
+        index->Build(i, points, this->GetContourCoordinates(i), m);
+        }
+      }
+    }
+  else
+    {
+    // Only the contours that were marked have to be re-indexed
+    for (size_t k = 0; k < index->Dirty.size(); k++)
+      {
+      int i = index->Dirty[k];
+      index->Build(i, this->Contours->Points[static_cast<size_t>(i)],
+                   this->GetContourCoordinates(i),
+                   this->GetNumberOfContourPoints(i));
+      }
     }
+  index->Dirty.clear();
+
+  this->IndexTime.Modified();
 }
 
 //----------------------------------------------------------------------------
 void vtkROIContourData::Initialize()
 {
+  if (this->PackedStorage)
+    {
+    // The arrays might be shared, so replace them instead of clearing
+    for (int i = 0; i < this->NumberOfContours; i++)
+      {
+      this->ReleaseView(i);
+      }
+    this->PackedPoints->Delete();
+    this->PackedPoints = vtkDoubleArray::New();
+    this->PackedPoints->SetNumberOfComponents(3);
+    this->PackedOffsets->Delete();
+    this->PackedOffsets = vtkIdTypeArray::New();
+    this->PackedOffsets->InsertNextValue(0);
+    }
+
   this->Contours->clear();
   this->NumberOfContours = 0;
+  this->Index->Clear();
+
+  if (this->PackedStorage)
+    {
+    this->PackTime.Modified();
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -172,25 +1381,43 @@ void vtkROIContourData::DeepCopy(vtkDataObject *o)
 
   if (src && src != this)
     {
+    this->Initialize();
+    this->SetPackedStorage(src->GetPackedStorage());
+
     int n = src->GetNumberOfContours();
     this->NumberOfContours = n;
     this->Contours->resize(static_cast<size_t>(n));
-    vtkROIContourElement *contour = 0;
-    for (int i = 0; i < n; i++)
+    this->Contours->Types = src->Contours->Types;
+    this->Contours->Labels = src->Contours->Labels;
+    this->Contours->MTimes = src->Contours->MTimes;
+    this->Index->Resize(n);
+
+    if (this->PackedStorage)
       {
-      contour = &(*this->Contours)[static_cast<size_t>(i)];
-      vtkPoints *points = src->GetContourPoints(i);
-      if (points)
+      // Copy the packed arrays, views will be made when needed
+      this->PackedPoints->DeepCopy(src->GetPackedPoints());
+      this->PackedOffsets->DeepCopy(src->GetPackedOffsets());
+      }
+    else
+      {
+      for (int i = 0; i < n; i++)
         {
-        vtkPoints *newpoints = vtkPoints::New();
-        newpoints->DeepCopy(points);
-        points = newpoints;
+        vtkPoints *points = src->GetContourPoints(i);
+        if (points)
+          {
+          vtkPoints *newpoints = vtkPoints::New();
+          newpoints->DeepCopy(points);
+          this->Contours->Points[static_cast<size_t>(i)] = newpoints;
+          newpoints->Delete();
+          }
         }
-      contour->Points = points;
-      contour->GeometricType = src->GetContourType(i);
       }
 
-    this->Modified();
+    this->TrackedModified();
+    if (this->PackedStorage)
+      {
+      this->PackTime.Modified();
+      }
     }
 
   this->Superclass::DeepCopy(o);
@@ -203,19 +1430,43 @@ void vtkROIContourData::ShallowCopy(vtkDataObject *o)
 
   if (src && src != this)
     {
+    this->Initialize();
+    this->SetPackedStorage(src->GetPackedStorage());
+
     int n = src->GetNumberOfContours();
     this->NumberOfContours = n;
     this->Contours->resize(static_cast<size_t>(n));
-    vtkROIContourElement *contour = 0;
-    for (int i = 0; i < n; i++)
+    this->Contours->Types = src->Contours->Types;
+    this->Contours->Labels = src->Contours->Labels;
+    this->Contours->MTimes = src->Contours->MTimes;
+    this->Index->Resize(n);
+
+    if (this->PackedStorage)
+      {
+      // Share the packed arrays, they are copied before any changes
+      // are made that would resize them
+      this->PackedPoints->Delete();
+      this->PackedPoints = src->GetPackedPoints();
+      this->PackedPoints->Register(this);
+      this->PackedOffsets->Delete();
+      this->PackedOffsets = src->GetPackedOffsets();
+      this->PackedOffsets->Register(this);
+      }
+    else
       {
-      contour = &(*this->Contours)[static_cast<size_t>(i)];
-      contour->Points = src->GetContourPoints(i);
-      contour->GeometricType = src->GetContourType(i);
+      for (int i = 0; i < n; i++)
+        {
+        this->Contours->Points[static_cast<size_t>(i)] =
+          src->GetContourPoints(i);
+        }
       }
 
-    this->Modified();
+    this->TrackedModified();
+    if (this->PackedStorage)
+      {
+      this->PackTime.Modified();
+      }
     }
 
-  this->Superclass::DeepCopy(o);
+  this->Superclass::ShallowCopy(o);
 }
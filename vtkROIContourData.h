@@ -26,7 +26,11 @@
 
 class vtkPoints;
 class vtkIdList;
+class vtkDoubleArray;
+class vtkIdTypeArray;
+class vtkPlane;
 class vtkROIContourVector;
+class vtkROIContourIndex;
 
 class VTK_EXPORT vtkROIContourData : public vtkDataObject
 {
@@ -83,11 +87,103 @@ public:
   void SetContourType(int contour, int t);
   int GetContourType(int contour);
 
+  // Description:
+  // The label of the structure that a contour belongs to.  This allows
+  // one vtkROIContourData to hold the contours for several structures.
+  // The default label is zero.
+  void SetContourLabel(int contour, int label);
+  int GetContourLabel(int contour);
+
   // Description:
   // Remove a contour.  This will cause the numbering of the contours to change,
   // if the removed contour is not the last contour.
   void RemoveContour(int contour);
 
+  // Description:
+  // Add a contour with the given type and points, where the points are
+  // given as x,y,z triples.  The id of the new contour is returned.  With
+  // packed storage, the points are appended to the packed array and no
+  // vtkPoints object is created.
+  int InsertNextContour(int t, vtkIdType numPoints, const double *points);
+
+  // Description:
+  // Store the points of all contours in one contiguous array.  When this
+  // is On, the coordinates for contour i are the tuples of PackedPoints
+  // from PackedOffsets[i] up to PackedOffsets[i+1], and GetContourPoints()
+  // returns a vtkPoints object that is a view of these coordinates.
+  // Changes to the view (and the addition of points to the view) will be
+  // seen in the packed array after Modified() is called on this object.
+  // Points that were set with SetContourPoints() become views, and if
+  // they are not double they are converted to double.  The default is Off.
+  void SetPackedStorage(int val);
+  void PackedStorageOn() { this->SetPackedStorage(1); }
+  void PackedStorageOff() { this->SetPackedStorage(0); }
+  int GetPackedStorage() { return this->PackedStorage; }
+
+  // Description:
+  // Get the packed arrays.  These are NULL unless PackedStorage is On.
+  vtkDoubleArray *GetPackedPoints();
+  vtkIdTypeArray *GetPackedOffsets();
+
+  // Description:
+  // Get the number of points in a contour.
+  vtkIdType GetNumberOfContourPoints(int contour);
+
+  // Description:
+  // Get a pointer to the coordinates of a contour, as x,y,z triples,
+  // without copying them.  If PackedStorage is Off, then NULL will be
+  // returned if the contour's points are not of type double.  The
+  // pointer is only valid until the contour data is changed.
+  double *GetContourCoordinates(int contour);
+
+  // Description:
+  // Call this before editing contour coordinates in place if the edits
+  // must not be seen by other objects.  With packed storage, the packed
+  // arrays are copied if they are shared via ShallowCopy().
+  void PrepareForEdit();
+
+  // Description:
+  // Remove points from the ends of the contours after their coordinates
+  // have been rewritten in place, e.g. by vtkROIContourSimplifier.  The
+  // array gives the new number of points for each contour, which must
+  // not be larger than the current number.  With packed storage, the
+  // packed array is compacted in place.
+  void TruncateContours(vtkIdTypeArray *numPoints);
+
+  // Description:
+  // Get the bounding box of a contour.  The bounds are cached, and are
+  // only recomputed when the contour changes.  If the contour is empty,
+  // the bounds will be uninitialized (i.e. min > max).
+  void GetContourBounds(int contour, double bounds[6]);
+
+  // Description:
+  // Call this after the vtkPoints of a contour have been changed in
+  // place, for example via vtkPoints::SetPoint(), InsertNextPoint(), or
+  // Modified().  The MTime of this data object does not include the MTimes
+  // of the points, so neither the pipeline nor the plane index will see
+  // the change until this is called.  This also calls Modified().
+  void ContourModified(int contour);
+
+  // Description:
+  // Get the last time that a contour was changed.  This is the newest of
+  // the MTime of its points and the last time that its points or type
+  // were set or ContourModified() was called for it.  Filters can use
+  // this to avoid redoing work for contours that have not changed.  If
+  // Modified() is called directly on the data, then the MTime of every
+  // contour advances, since any of them might have changed.
+  unsigned long GetContourMTime(int contour);
+
+  // Description:
+  // Find all contours that lie within the given distance of a plane,
+  // i.e. contours for which every point is within the tolerance.  Empty
+  // contours are always included.  The contours are kept in an index
+  // according to their plane normal and offset, so the search does not
+  // have to visit every contour.  The ids are returned in order.
+  void FindContoursNearPlane(const double origin[3], const double normal[3],
+                             double tol, vtkIdList *contourIds);
+  void FindContoursNearPlane(vtkPlane *plane, double tol,
+                             vtkIdList *contourIds);
+
 protected:
   vtkROIContourData();
   ~vtkROIContourData();
@@ -95,6 +191,48 @@ protected:
   int NumberOfContours;
   vtkROIContourVector *Contours;
 
+  int PackedStorage;
+  vtkDoubleArray *PackedPoints;
+  vtkIdTypeArray *PackedOffsets;
+  vtkTimeStamp PackTime;
+
+  vtkROIContourIndex *Index;
+  vtkTimeStamp IndexTime;
+  unsigned long TrackedMTime;
+  unsigned long UntrackedMTime;
+
+  // Description:
+  // Check the views of the packed points, and repack if any views
+  // have been resized or replaced.
+  void UpdatePacking();
+
+  // Description:
+  // Copy all of the contours into a new packed array.
+  void Repack();
+
+  // Description:
+  // Make the views point to the current packed array.
+  void UpdateViews();
+
+  // Description:
+  // Make sure that the packed array is not shared before changing it.
+  void PreparePackedEdit();
+
+  // Description:
+  // Stop using the packed array for a contour's view.
+  void ReleaseView(int contour);
+
+  // Description:
+  // Call Modified(), and record that the contours that were changed
+  // have been marked.  If Modified() is called directly instead, then
+  // any of the contours might have changed, and UntrackedMTime keeps
+  // the time of the last such call.
+  void TrackedModified();
+
+  // Description:
+  // Re-index any contours that have changed since the last update.
+  void UpdateIndex();
+
 private:
   vtkROIContourData(const vtkROIContourData&);  //Not implemented
   void operator=(const vtkROIContourData&);  //Not implemented
@@ -0,0 +1,893 @@
+/*=========================================================================
+
+  Program:   ToolCursor
+  Module:    vtkROIContourDataStatistics.cxx
+
+  Copyright (c) 2010 David Gobbi
+  All rights reserved.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkROIContourDataStatistics.h"
+
+#include "vtkROIContourData.h"
+#include "vtkROIContourDataToPolyData.h"
+#include "vtkROIContourScanConverter.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+#include "vtkObjectFactory.h"
+#include "vtkImageData.h"
+#include "vtkTable.h"
+#include "vtkPoints.h"
+#include "vtkIntArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkMatrix4x4.h"
+#include "vtkMath.h"
+#include "vtkMultiThreader.h"
+#include "vtkTemplateAliasMacro.h"
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <math.h>
+
+vtkStandardNewMacro(vtkROIContourDataStatistics);
+vtkCxxSetObjectMacro(vtkROIContourDataStatistics,ROIMatrix,vtkMatrix4x4);
+vtkCxxSetObjectMacro(vtkROIContourDataStatistics,ImageMatrix,vtkMatrix4x4);
+
+//----------------------------------------------------------------------------
+// The information that is shared by the threads.  This is kept from the
+// first slab to the last, since the contours only have to be sorted once
+// and the sums are carried from one slab to the next.  Each thread has
+// its own sums for every structure, so the threads do not synchronize.
+class vtkROIContourDataStatisticsThreadStruct
+{
+public:
+  // A closed contour in structured x,y coordinates
+  struct Polygon
+  {
+    int LabelIndex;
+    std::vector<double> Coords;
+  };
+
+  // The sums for one structure.  The values are shifted by the first
+  // value that was seen, to reduce roundoff in the sum of squares.
+  struct Accumulator
+  {
+    double Shift;
+    double Weight;
+    double Sum;
+    double SumOfSquares;
+    double Minimum;
+    double Maximum;
+    std::vector<double> Histogram;
+  };
+
+  typedef std::vector<Polygon> PolygonList;
+  typedef std::vector<Accumulator> AccumulatorList;
+
+  vtkROIContourDataStatistics *Filter;
+  void *InputPointer;
+  int ScalarType;
+  vtkIdType Increments[3];
+  int Extent[6];
+  int WholeExtent[6];
+  double Spacing[3];
+  int PartialVoxelWeighting;
+  int NumberOfBins;
+  double BinOrigin;
+  double BinSpacing;
+  int NumberOfThreads;
+  std::vector<int> Labels;
+  std::vector<PolygonList> Slices;
+  std::vector<AccumulatorList> Accumulators;
+
+  static VTK_THREAD_RETURN_TYPE ThreadMain(void *arg);
+};
+
+//----------------------------------------------------------------------------
+vtkROIContourDataStatistics::vtkROIContourDataStatistics()
+{
+  this->ROIMatrix = 0;
+  this->ImageMatrix = 0;
+  this->PartialVoxelWeighting = 1;
+  this->Subdivision = 0;
+  this->SubdivisionTarget = 1.0;
+  this->NumberOfBins = 256;
+  this->BinOrigin = 0.0;
+  this->BinSpacing = 1.0;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->Threader = vtkMultiThreader::New();
+  this->ThreadData = 0;
+
+  this->SetNumberOfInputPorts(2);
+  this->SetNumberOfOutputPorts(1);
+}
+
+//----------------------------------------------------------------------------
+vtkROIContourDataStatistics::~vtkROIContourDataStatistics()
+{
+  if (this->ROIMatrix)
+    {
+    this->ROIMatrix->Delete();
+    }
+  if (this->ImageMatrix)
+    {
+    this->ImageMatrix->Delete();
+    }
+  this->Threader->Delete();
+  delete this->ThreadData;
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourDataStatistics::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "ROIMatrix: " << this->ROIMatrix << "\n";
+  os << indent << "ImageMatrix: " << this->ImageMatrix << "\n";
+  os << indent << "PartialVoxelWeighting: "
+     << (this->PartialVoxelWeighting ? "On\n" : "Off\n");
+  os << indent << "Subdivision: " << (this->Subdivision ? "On\n" : "Off\n");
+  os << indent << "SubdivisionTarget: " << this->SubdivisionTarget << "\n";
+  os << indent << "NumberOfBins: " << this->NumberOfBins << "\n";
+  os << indent << "BinOrigin: " << this->BinOrigin << "\n";
+  os << indent << "BinSpacing: " << this->BinSpacing << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkROIContourDataStatistics::GetMTime()
+{
+  unsigned long mtime = this->Superclass::GetMTime();
+  if (this->ROIMatrix)
+    {
+    unsigned long mtime2 = this->ROIMatrix->GetMTime();
+    mtime = (mtime > mtime2 ? mtime : mtime2);
+    }
+  if (this->ImageMatrix)
+    {
+    unsigned long mtime2 = this->ImageMatrix->GetMTime();
+    mtime = (mtime > mtime2 ? mtime : mtime2);
+    }
+  return mtime;
+}
+
+//----------------------------------------------------------------------------
+vtkTable* vtkROIContourDataStatistics::GetOutput()
+{
+  return vtkTable::SafeDownCast(this->GetOutputDataObject(0));
+}
+
+//----------------------------------------------------------------------------
+vtkDataObject* vtkROIContourDataStatistics::GetInput()
+{
+  return this->GetExecutive()->GetInputData(0, 0);
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourDataStatistics::SetInput(vtkDataObject* input)
+{
+#if VTK_MAJOR_VERSION >= 6
+  this->SetInputDataInternal(0, input);
+#else
+  vtkAlgorithmOutput *producerPort = 0;
+
+  if (input)
+    {
+    producerPort = input->GetProducerPort();
+    }
+
+  this->SetInputConnection(0, producerPort);
+#endif
+}
+
+//----------------------------------------------------------------------------
+vtkROIContourData* vtkROIContourDataStatistics::GetROIContourData()
+{
+  if (this->GetNumberOfInputConnections(1) < 1)
+    {
+    return 0;
+    }
+  return vtkROIContourData::SafeDownCast(
+    this->GetExecutive()->GetInputData(1, 0));
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourDataStatistics::SetROIContourData(vtkROIContourData* data)
+{
+#if VTK_MAJOR_VERSION >= 6
+  this->SetInputDataInternal(1, data);
+#else
+  vtkAlgorithmOutput *producerPort = 0;
+
+  if (data)
+    {
+    producerPort = data->GetProducerPort();
+    }
+
+  this->SetInputConnection(1, producerPort);
+#endif
+}
+
+//----------------------------------------------------------------------------
+int vtkROIContourDataStatistics::FillOutputPortInformation(
+  int, vtkInformation *info)
+{
+  info->Set(vtkDataObject::DATA_TYPE_NAME(), "vtkTable");
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkROIContourDataStatistics::FillInputPortInformation(
+  int port, vtkInformation *info)
+{
+  if (port == 1)
+    {
+    info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkROIContourData");
+    }
+  else
+    {
+    info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageData");
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+vtkDataObject *vtkROIContourDataStatistics::NewOutputData()
+{
+  return vtkTable::New();
+}
+
+//----------------------------------------------------------------------------
+int vtkROIContourDataStatistics::RequestData(
+  vtkInformation *request,
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  // Get the info objects
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation *roiInfo = inputVector[1]->GetInformationObject(0);
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+
+  // Get the inputs and output
+  vtkImageData *input = vtkImageData::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkROIContourData *data = vtkROIContourData::SafeDownCast(
+    roiInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkTable *output = vtkTable::SafeDownCast(
+    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+
+  int wholeExtent[6];
+  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExtent);
+  int numSlabs = this->GetNumberOfSlabs(wholeExtent);
+  if (numSlabs <= 0)
+    {
+    this->StopStreaming(request);
+    output->Initialize();
+    return 1;
+    }
+
+  // The contours are sorted and the sums are cleared at the first slab
+  if (!this->ThreadData)
+    {
+    this->SlabIndex = 0;
+    }
+  if (this->StartSlab(request, numSlabs))
+    {
+    this->PrepareContours(input, data, wholeExtent);
+    }
+
+  int extent[6];
+  this->ComputeSlabExtent(wholeExtent, this->SlabIndex, extent);
+  this->AccumulateSlab(input, extent);
+
+  if (this->FinishSlab(request, numSlabs))
+    {
+    this->GenerateTable(output);
+    delete this->ThreadData;
+    this->ThreadData = 0;
+    }
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+namespace {
+
+// Sort the polygons on a slice by structure
+bool vtkPolygonLabelLess(
+  const vtkROIContourDataStatisticsThreadStruct::Polygon& a,
+  const vtkROIContourDataStatisticsThreadStruct::Polygon& b)
+{
+  return (a.LabelIndex < b.LabelIndex);
+}
+
+} // end anonymous namespace
+
+//----------------------------------------------------------------------------
+void vtkROIContourDataStatistics::PrepareContours(
+  vtkImageData *input, vtkROIContourData *data, const int wholeExtent[6])
+{
+  delete this->ThreadData;
+  vtkROIContourDataStatisticsThreadStruct *ts =
+    new vtkROIContourDataStatisticsThreadStruct;
+  this->ThreadData = ts;
+
+  ts->Filter = this;
+  ts->InputPointer = 0;
+  ts->ScalarType = input->GetScalarType();
+  for (int k = 0; k < 6; k++)
+    {
+    ts->WholeExtent[k] = wholeExtent[k];
+    ts->Extent[k] = wholeExtent[k];
+    }
+  input->GetSpacing(ts->Spacing);
+  ts->PartialVoxelWeighting = this->PartialVoxelWeighting;
+  ts->NumberOfBins = this->NumberOfBins;
+  ts->BinOrigin = this->BinOrigin;
+  ts->BinSpacing = this->BinSpacing;
+  ts->NumberOfThreads = this->NumberOfThreads;
+
+  double origin[3];
+  input->GetOrigin(origin);
+  double *spacing = ts->Spacing;
+  int numSlices = wholeExtent[5] - wholeExtent[4] + 1;
+  ts->Slices.resize(static_cast<size_t>(numSlices));
+
+  // Every label of a closed contour is a structure, even if the contour
+  // does not intersect the image
+  int numContours = (data ? data->GetNumberOfContours() : 0);
+  std::map<int, int> labelMap;
+  for (int i = 0; i < numContours; i++)
+    {
+    if (data->GetContourType(i) == vtkROIContourData::CLOSED_PLANAR)
+      {
+      labelMap[data->GetContourLabel(i)] = 0;
+      }
+    }
+  std::map<int, int>::iterator iter;
+  for (iter = labelMap.begin(); iter != labelMap.end(); ++iter)
+    {
+    iter->second = static_cast<int>(ts->Labels.size());
+    ts->Labels.push_back(iter->first);
+    }
+
+  // The contours go to world coordinates through the ROIMatrix, and then
+  // to the data coordinates of the image through the inverse ImageMatrix
+  double matrix[16];
+  vtkMatrix4x4::Identity(matrix);
+  if (this->ROIMatrix)
+    {
+    vtkMatrix4x4::DeepCopy(matrix, this->ROIMatrix);
+    }
+  if (this->ImageMatrix)
+    {
+    double invmatrix[16];
+    vtkMatrix4x4::Invert(*this->ImageMatrix->Element, invmatrix);
+    vtkMatrix4x4::Multiply4x4(invmatrix, matrix, matrix);
+    }
+  int useMatrix = (this->ROIMatrix || this->ImageMatrix);
+
+  vtkDoubleArray *subdivided = vtkDoubleArray::New();
+  std::vector<double> coords;
+
+  for (int i = 0; i < numContours; i++)
+    {
+    vtkPoints *points = data->GetContourPoints(i);
+    if (!points || points->GetNumberOfPoints() < 3 ||
+        data->GetContourType(i) != vtkROIContourData::CLOSED_PLANAR)
+      {
+      continue;
+      }
+
+    // Get the points as x,y,z triples
+    vtkIdType n = points->GetNumberOfPoints();
+    if (this->Subdivision)
+      {
+      n = vtkROIContourDataToPolyData::SubdivideWithCatmullRom(
+        points, 1, this->SubdivisionTarget, subdivided);
+      coords.assign(subdivided->GetPointer(0),
+                    subdivided->GetPointer(0) + 3*n);
+      }
+    else
+      {
+      coords.resize(static_cast<size_t>(3*n));
+      for (vtkIdType j = 0; j < n; j++)
+        {
+        points->GetPoint(j, &coords[3*j]);
+        }
+      }
+    if (n < 3)
+      {
+      continue;
+      }
+
+    // Convert to structured coordinates
+    vtkROIContourDataStatisticsThreadStruct::Polygon polygon;
+    polygon.LabelIndex = labelMap[data->GetContourLabel(i)];
+    polygon.Coords.resize(static_cast<size_t>(2*n));
+    double zRange[2] = { VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX };
+    for (vtkIdType j = 0; j < n; j++)
+      {
+      double p[4];
+      p[0] = coords[3*j];
+      p[1] = coords[3*j + 1];
+      p[2] = coords[3*j + 2];
+      p[3] = 1.0;
+      if (useMatrix)
+        {
+        vtkMatrix4x4::MultiplyPoint(matrix, p, p);
+        p[0] /= p[3];
+        p[1] /= p[3];
+        p[2] /= p[3];
+        }
+      double x = (p[0] - origin[0])/spacing[0];
+      double y = (p[1] - origin[1])/spacing[1];
+      double z = (p[2] - origin[2])/spacing[2];
+      polygon.Coords[2*j] = x;
+      polygon.Coords[2*j + 1] = y;
+      zRange[0] = (z < zRange[0] ? z : zRange[0]);
+      zRange[1] = (z > zRange[1] ? z : zRange[1]);
+      }
+
+    // Put the polygon on the slice that is nearest to its center
+    int zIdx = vtkMath::Floor(0.5*(zRange[0] + zRange[1]) + 0.5);
+    if (zIdx >= wholeExtent[4] && zIdx <= wholeExtent[5])
+      {
+      ts->Slices[zIdx - wholeExtent[4]].push_back(polygon);
+      }
+    }
+
+  subdivided->Delete();
+
+  for (int k = 0; k < numSlices; k++)
+    {
+    std::stable_sort(ts->Slices[k].begin(), ts->Slices[k].end(),
+                     vtkPolygonLabelLess);
+    }
+
+  // Clear the sums
+  vtkROIContourDataStatisticsThreadStruct::Accumulator empty;
+  empty.Shift = 0.0;
+  empty.Weight = 0.0;
+  empty.Sum = 0.0;
+  empty.SumOfSquares = 0.0;
+  empty.Minimum = VTK_DOUBLE_MAX;
+  empty.Maximum = -VTK_DOUBLE_MAX;
+  empty.Histogram.resize(static_cast<size_t>(this->NumberOfBins), 0.0);
+
+  ts->Accumulators.resize(static_cast<size_t>(ts->NumberOfThreads));
+  for (int t = 0; t < ts->NumberOfThreads; t++)
+    {
+    ts->Accumulators[t].assign(ts->Labels.size(), empty);
+    }
+}
+
+//----------------------------------------------------------------------------
+namespace {
+
+// The coverage of the voxels in one slice by the polygons of one label.
+// The spans are found by the scan converter along several sample lines
+// through each row, and the coverage along each sample line is computed
+// exactly.  The coverage for the fully covered voxels in a span is added
+// to a difference array, so that long spans are cheap.
+class vtkROIStatisticsCoverage
+{
+public:
+  vtkROIStatisticsCoverage(const int extent[6], int samples);
+  ~vtkROIStatisticsCoverage();
+
+  // Find where the polygons cross the sample lines, and return the range
+  // of rows that they touch.
+  void AddPolygons(
+    const vtkROIContourDataStatisticsThreadStruct::Polygon *polygons,
+    size_t n, int *rowMin, int *rowMax);
+
+  // Compute the coverage for a row, and return the range of voxels that
+  // might have nonzero coverage.  This also clears the sample lines.
+  void ComputeRow(int yIdx, int *xMin, int *xMax);
+
+  // Get the coverage for a voxel in the row, and clear it.
+  double PopWeight(int xIdx)
+  {
+    double w = this->Weights[xIdx - this->Extent[0]];
+    this->Weights[xIdx - this->Extent[0]] = 0.0;
+    return (w < 1.0 ? w : 1.0);
+  }
+
+private:
+  void AddSpan(double xa, double xb, double w, int *xMin, int *xMax);
+
+  int Extent[6];
+  int Samples;
+  vtkROIContourScanConverter *Scanner;
+  std::vector<double> Weights;
+  std::vector<double> Steps;
+};
+
+vtkROIStatisticsCoverage::vtkROIStatisticsCoverage(
+  const int extent[6], int samples)
+{
+  for (int k = 0; k < 6; k++)
+    {
+    this->Extent[k] = extent[k];
+    }
+  this->Samples = samples;
+  this->Scanner = vtkROIContourScanConverter::New();
+  this->Scanner->Initialize(extent, samples);
+  int numCols = extent[1] - extent[0] + 1;
+  this->Weights.resize(static_cast<size_t>(numCols + 1), 0.0);
+  this->Steps.resize(static_cast<size_t>(numCols + 1), 0.0);
+}
+
+vtkROIStatisticsCoverage::~vtkROIStatisticsCoverage()
+{
+  this->Scanner->Delete();
+}
+
+void vtkROIStatisticsCoverage::AddPolygons(
+  const vtkROIContourDataStatisticsThreadStruct::Polygon *polygons,
+  size_t numPolygons, int *rowMin, int *rowMax)
+{
+  for (size_t c = 0; c < numPolygons; c++)
+    {
+    vtkIdType n = static_cast<vtkIdType>(polygons[c].Coords.size()/2);
+    if (n > 0)
+      {
+      this->Scanner->AddPolygon(&polygons[c].Coords[0], n, rowMin, rowMax);
+      }
+    }
+}
+
+void vtkROIStatisticsCoverage::AddSpan(
+  double xa, double xb, double w, int *xMin, int *xMax)
+{
+  // Voxel i covers [i - 0.5, i + 0.5) relative to the start of the row
+  int numCols = this->Extent[1] - this->Extent[0] + 1;
+  xa -= this->Extent[0];
+  xb -= this->Extent[0];
+  xa = (xa > -0.5 ? xa : -0.5);
+  xb = (xb < numCols - 0.5 ? xb : numCols - 0.5);
+  if (xa >= xb)
+    {
+    return;
+    }
+
+  int ia = static_cast<int>(floor(xa + 0.5));
+  int ib = static_cast<int>(floor(xb + 0.5));
+  ib = (ib < numCols - 1 ? ib : numCols - 1);
+
+  if (ia == ib)
+    {
+    this->Weights[ia] += w*(xb - xa);
+    }
+  else
+    {
+    this->Weights[ia] += w*(ia + 0.5 - xa);
+    this->Weights[ib] += w*(xb - ib + 0.5);
+    this->Steps[ia + 1] += w;
+    this->Steps[ib] -= w;
+    }
+
+  ia += this->Extent[0];
+  ib += this->Extent[0];
+  *xMin = (ia < *xMin ? ia : *xMin);
+  *xMax = (ib > *xMax ? ib : *xMax);
+}
+
+void vtkROIStatisticsCoverage::ComputeRow(int yIdx, int *xMin, int *xMax)
+{
+  const int *extent = this->Extent;
+  int samples = this->Samples;
+  *xMin = extent[1] + 1;
+  *xMax = extent[0] - 1;
+
+  if (samples == 1)
+    {
+    // Without weighting, a voxel is in if its center is in
+    int r1, r2;
+    int iter = 0;
+    while (this->Scanner->GetNextExtent(yIdx, iter, r1, r2))
+      {
+      for (int r = r1; r <= r2; r++)
+        {
+        this->Weights[r - extent[0]] = 1.0;
+        }
+      *xMin = (r1 < *xMin ? r1 : *xMin);
+      *xMax = (r2 > *xMax ? r2 : *xMax);
+      }
+    }
+  else
+    {
+    for (int s = 0; s < samples; s++)
+      {
+      double xa, xb;
+      int iter = 0;
+      while (this->Scanner->GetNextSpan(yIdx, s, iter, xa, xb))
+        {
+        this->AddSpan(xa, xb, 1.0/samples, xMin, xMax);
+        }
+      }
+    }
+
+  // Add the fully covered voxels from the difference array
+  double step = 0.0;
+  for (int xIdx = *xMin; xIdx <= *xMax; xIdx++)
+    {
+    step += this->Steps[xIdx - extent[0]];
+    this->Steps[xIdx - extent[0]] = 0.0;
+    this->Weights[xIdx - extent[0]] += step;
+    }
+}
+
+// Add the voxels of one slice that are covered by the polygons of one
+// structure to the sums for that structure.
+template<class T>
+void vtkROIStatisticsAccumulate(
+  const T *inPtr, const vtkIdType increments[3],
+  const vtkROIContourDataStatisticsThreadStruct::Polygon *polygons,
+  size_t numPolygons, vtkROIStatisticsCoverage *coverage,
+  const vtkROIContourDataStatisticsThreadStruct *ts,
+  vtkROIContourDataStatisticsThreadStruct::Accumulator *acc)
+{
+  const int *extent = ts->Extent;
+  int numBins = ts->NumberOfBins;
+  double *histogram = &acc->Histogram[0];
+  double binScale = (ts->BinSpacing != 0 ? 1.0/ts->BinSpacing : 0.0);
+  double binShift = 0.5 - ts->BinOrigin*binScale;
+
+  int rowMin = extent[3] + 1;
+  int rowMax = extent[2] - 1;
+  coverage->AddPolygons(polygons, numPolygons, &rowMin, &rowMax);
+
+  for (int yIdx = rowMin; yIdx <= rowMax; yIdx++)
+    {
+    int xMin, xMax;
+    coverage->ComputeRow(yIdx, &xMin, &xMax);
+    const T *ptr = inPtr + (yIdx - extent[2])*increments[1];
+
+    for (int xIdx = xMin; xIdx <= xMax; xIdx++)
+      {
+      double w = coverage->PopWeight(xIdx);
+      if (w <= 0)
+        {
+        continue;
+        }
+
+      double v = ptr[(xIdx - extent[0])*increments[0]];
+      if (acc->Weight == 0)
+        {
+        acc->Shift = v;
+        }
+      double d = v - acc->Shift;
+      acc->Weight += w;
+      acc->Sum += w*d;
+      acc->SumOfSquares += w*d*d;
+      acc->Minimum = (v < acc->Minimum ? v : acc->Minimum);
+      acc->Maximum = (v > acc->Maximum ? v : acc->Maximum);
+
+      double b = v*binScale + binShift;
+      if (binScale != 0 && b >= 0 && b < numBins)
+        {
+        histogram[static_cast<int>(b)] += w;
+        }
+      }
+    }
+}
+
+// Do all of the slices of the current slab that belong to one thread.
+template<class T>
+void vtkROIStatisticsExecute(
+  const T *inPtr, vtkROIContourDataStatisticsThreadStruct *ts,
+  int threadId, int numThreads)
+{
+  const int *extent = ts->Extent;
+  const vtkIdType *increments = ts->Increments;
+  vtkROIContourDataStatisticsThreadStruct::AccumulatorList *accumulators =
+    &ts->Accumulators[threadId];
+  vtkROIStatisticsCoverage coverage(
+    extent, (ts->PartialVoxelWeighting ? 8 : 1));
+
+  // Do every numThreads'th slice, as for vtkImageToROIContourData
+  for (int zIdx = extent[4] + threadId; zIdx <= extent[5];
+       zIdx += numThreads)
+    {
+    const T *slicePtr = inPtr + (zIdx - extent[4])*increments[2];
+    vtkROIContourDataStatisticsThreadStruct::PolygonList *polygons =
+      &ts->Slices[zIdx - ts->WholeExtent[4]];
+
+    // Do the polygons for each structure together
+    size_t n = polygons->size();
+    size_t c = 0;
+    while (c < n)
+      {
+      int labelIndex = (*polygons)[c].LabelIndex;
+      size_t m = c + 1;
+      while (m < n && (*polygons)[m].LabelIndex == labelIndex)
+        {
+        m++;
+        }
+      vtkROIStatisticsAccumulate(
+        slicePtr, increments, &(*polygons)[c], m - c, &coverage, ts,
+        &(*accumulators)[labelIndex]);
+      c = m;
+      }
+    }
+}
+
+} // end anonymous namespace
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkROIContourDataStatisticsThreadStruct::ThreadMain(
+  void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkROIContourDataStatisticsThreadStruct *ts =
+    static_cast<vtkROIContourDataStatisticsThreadStruct *>(info->UserData);
+
+  ts->Filter->ThreadedExecute(ts, info->ThreadID, info->NumberOfThreads);
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourDataStatistics::ThreadedExecute(
+  vtkROIContourDataStatisticsThreadStruct *ts, int threadId, int numThreads)
+{
+  switch (ts->ScalarType)
+    {
+    vtkTemplateAliasMacro(
+      vtkROIStatisticsExecute(static_cast<VTK_TT *>(ts->InputPointer),
+                              ts, threadId, numThreads));
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourDataStatistics::AccumulateSlab(
+  vtkImageData *input, const int extent[6])
+{
+  vtkROIContourDataStatisticsThreadStruct *ts = this->ThreadData;
+  if (input->GetScalarType() != ts->ScalarType)
+    {
+    vtkErrorMacro("AccumulateSlab: the scalar type changed while "
+                  "streaming");
+    return;
+    }
+
+  // Get the pointer and increments here, rather than in the threads
+  ts->InputPointer = input->GetScalarPointer(extent[0], extent[2], extent[4]);
+  if (!ts->InputPointer)
+    {
+    vtkErrorMacro("AccumulateSlab: the image has no scalars");
+    return;
+    }
+  input->GetIncrements(ts->Increments);
+  for (int k = 0; k < 6; k++)
+    {
+    ts->Extent[k] = extent[k];
+    }
+
+  int numSlices = extent[5] - extent[4] + 1;
+  int numThreads = ts->NumberOfThreads;
+  numThreads = (numThreads > numSlices ? numSlices : numThreads);
+
+  if (numThreads > 1)
+    {
+    this->Threader->SetNumberOfThreads(numThreads);
+    this->Threader->SetSingleMethod(
+      &vtkROIContourDataStatisticsThreadStruct::ThreadMain, ts);
+    this->Threader->SingleMethodExecute();
+    }
+  else
+    {
+    this->ThreadedExecute(ts, 0, 1);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourDataStatistics::GenerateTable(vtkTable *output)
+{
+  vtkROIContourDataStatisticsThreadStruct *ts = this->ThreadData;
+  int numLabels = static_cast<int>(ts->Labels.size());
+  int numBins = ts->NumberOfBins;
+  double voxelVolume = fabs(ts->Spacing[0]*ts->Spacing[1]*ts->Spacing[2]);
+
+  vtkIntArray *labels = vtkIntArray::New();
+  labels->SetName("Label");
+  vtkDoubleArray *counts = vtkDoubleArray::New();
+  counts->SetName("VoxelCount");
+  vtkDoubleArray *volumes = vtkDoubleArray::New();
+  volumes->SetName("Volume");
+  vtkDoubleArray *means = vtkDoubleArray::New();
+  means->SetName("Mean");
+  vtkDoubleArray *minima = vtkDoubleArray::New();
+  minima->SetName("Minimum");
+  vtkDoubleArray *maxima = vtkDoubleArray::New();
+  maxima->SetName("Maximum");
+  vtkDoubleArray *deviations = vtkDoubleArray::New();
+  deviations->SetName("StandardDeviation");
+  vtkDoubleArray *histograms = vtkDoubleArray::New();
+  histograms->SetName("Histogram");
+  histograms->SetNumberOfComponents(numBins);
+  histograms->SetNumberOfTuples(numLabels);
+
+  for (int l = 0; l < numLabels; l++)
+    {
+    // Combine the sums from the threads, using the mean and the sum of
+    // squared deviations from the mean for each thread
+    double weight = 0.0;
+    double mean = 0.0;
+    double m2 = 0.0;
+    double minimum = VTK_DOUBLE_MAX;
+    double maximum = -VTK_DOUBLE_MAX;
+    double *histogram = histograms->GetPointer(static_cast<vtkIdType>(l)*
+                                               numBins);
+    for (int b = 0; b < numBins; b++)
+      {
+      histogram[b] = 0.0;
+      }
+
+    for (int t = 0; t < ts->NumberOfThreads; t++)
+      {
+      vtkROIContourDataStatisticsThreadStruct::Accumulator *acc =
+        &ts->Accumulators[t][l];
+      if (acc->Weight <= 0)
+        {
+        continue;
+        }
+      double w = acc->Weight;
+      double m = acc->Shift + acc->Sum/w;
+      double s = acc->SumOfSquares - acc->Sum*acc->Sum/w;
+      double delta = m - mean;
+      double total = weight + w;
+      mean += delta*w/total;
+      m2 += (s > 0 ? s : 0.0) + delta*delta*weight*w/total;
+      weight = total;
+      minimum = (acc->Minimum < minimum ? acc->Minimum : minimum);
+      maximum = (acc->Maximum > maximum ? acc->Maximum : maximum);
+      for (int b = 0; b < numBins; b++)
+        {
+        histogram[b] += acc->Histogram[b];
+        }
+      }
+
+    if (weight <= 0)
+      {
+      minimum = 0.0;
+      maximum = 0.0;
+      }
+
+    labels->InsertNextValue(ts->Labels[l]);
+    counts->InsertNextValue(weight);
+    volumes->InsertNextValue(weight*voxelVolume);
+    means->InsertNextValue(mean);
+    minima->InsertNextValue(minimum);
+    maxima->InsertNextValue(maximum);
+    deviations->InsertNextValue(weight > 0 ? sqrt(m2/weight) : 0.0);
+    }
+
+  output->Initialize();
+  output->AddColumn(labels);
+  output->AddColumn(counts);
+  output->AddColumn(volumes);
+  output->AddColumn(means);
+  output->AddColumn(minima);
+  output->AddColumn(maxima);
+  output->AddColumn(deviations);
+  output->AddColumn(histograms);
+
+  labels->Delete();
+  counts->Delete();
+  volumes->Delete();
+  means->Delete();
+  minima->Delete();
+  maxima->Delete();
+  deviations->Delete();
+  histograms->Delete();
+}
@@ -0,0 +1,184 @@
+/*=========================================================================
+
+  Program:   ToolCursor
+  Module:    vtkROIContourDataStatistics.h
+
+  Copyright (c) 2010 David Gobbi
+  All rights reserved.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkROIContourDataStatistics - Image statistics within ROI contours
+// .SECTION Description
+// This filter computes statistics of an image within each structure of a
+// vtkROIContourData.  The structures are identified by their contour
+// labels, and the statistics for all of the structures are computed in
+// a single pass through the image.  The output is a vtkTable with one row
+// per label, with the columns "Label", "VoxelCount", "Volume", "Mean",
+// "Minimum", "Maximum", "StandardDeviation", and "Histogram", where the
+// histogram column has NumberOfBins components.  Only the first component
+// of the image is used.  The closed contours are assumed to lie in the
+// x-y planes of the image once they are in the data coordinates of the
+// image, and each contour is assigned to the slice that is nearest to it.
+// Within a slice, the contours for each label are combined with an
+// even-odd rule, so that contours inside other contours become holes.
+// When Streaming is on, the sums are carried from one slab to the next,
+// and the table is made after the last slab.
+// .SECTION See Also
+// vtkROIContourDataToImageStencil
+
+#ifndef __vtkROIContourDataStatistics_h
+#define __vtkROIContourDataStatistics_h
+
+#include "vtkSlabStreamingAlgorithm.h"
+#include "vtkMultiThreader.h" // for VTK_MAX_THREADS
+
+class vtkROIContourData;
+class vtkImageData;
+class vtkTable;
+class vtkMatrix4x4;
+class vtkROIContourDataStatisticsThreadStruct;
+
+class VTK_EXPORT vtkROIContourDataStatistics :
+  public vtkSlabStreamingAlgorithm
+{
+public:
+  static vtkROIContourDataStatistics *New();
+  vtkTypeMacro(vtkROIContourDataStatistics,vtkSlabStreamingAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // A matrix that transforms the contour coordinates into world
+  // coordinates, as for the ROIMatrix of vtkLassoImageTool.  If this is
+  // not set, then the contours are in world coordinates.
+  void SetROIMatrix(vtkMatrix4x4 *matrix);
+  vtkGetObjectMacro(ROIMatrix, vtkMatrix4x4);
+
+  // Description:
+  // A matrix that transforms the data coordinates of the image into world
+  // coordinates, usually the UserMatrix of the image actor.  The contours
+  // are transformed by the inverse of this matrix after the ROIMatrix.
+  // If this is not set, then the image data is in world coordinates.
+  void SetImageMatrix(vtkMatrix4x4 *matrix);
+  vtkGetObjectMacro(ImageMatrix, vtkMatrix4x4);
+
+  // Description:
+  // Weight the voxels on the boundaries of the contours by the fraction
+  // of the voxel that is inside.  The fraction is computed exactly along
+  // each row, and by sampling at eight positions across the row.  If this
+  // is off, then a voxel is either in or out, according to whether its
+  // center is inside the contour.  The default is On.
+  vtkSetMacro(PartialVoxelWeighting, int);
+  vtkBooleanMacro(PartialVoxelWeighting, int);
+  vtkGetMacro(PartialVoxelWeighting, int);
+
+  // Description:
+  // Smooth the contours with a Catmull-Rom spline, in the same way as
+  // vtkROIContourDataToImageStencil.  The default is Off.
+  vtkSetMacro(Subdivision, int);
+  vtkBooleanMacro(Subdivision, int);
+  vtkGetMacro(Subdivision, int);
+
+  // Description:
+  // The target segment length for subdivision.  The default is 1.0.
+  vtkSetMacro(SubdivisionTarget, double);
+  vtkGetMacro(SubdivisionTarget, double);
+
+  // Description:
+  // The number of bins in the histogram for each structure.  The default
+  // is 256.
+  vtkSetClampMacro(NumberOfBins, int, 1, VTK_INT_MAX);
+  vtkGetMacro(NumberOfBins, int);
+
+  // Description:
+  // The value at the center of the first bin.  The default is zero.
+  vtkSetMacro(BinOrigin, double);
+  vtkGetMacro(BinOrigin, double);
+
+  // Description:
+  // The width of each bin.  Values that fall outside of the bins are
+  // not counted in the histogram.  The default is 1.0.
+  vtkSetMacro(BinSpacing, double);
+  vtkGetMacro(BinSpacing, double);
+
+  // Description:
+  // The number of threads to use.  The slices are divided between the
+  // threads, and each thread keeps its own sums until the end, so the
+  // threads do not have to synchronize.  The default is the number of
+  // processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
+  // Description:
+  // The image input to this filter must be a vtkImageData.
+  void SetInput(vtkDataObject *d);
+  vtkDataObject *GetInput();
+
+  // Description:
+  // The contours, which are connected to the second input port.
+  void SetROIContourData(vtkROIContourData *data);
+  vtkROIContourData *GetROIContourData();
+
+  // Description:
+  // Get the output table.
+  vtkTable* GetOutput();
+
+  // Description:
+  // The modification time includes the ROIMatrix and ImageMatrix.
+  unsigned long GetMTime();
+
+protected:
+  vtkROIContourDataStatistics();
+  ~vtkROIContourDataStatistics();
+
+  virtual vtkDataObject *NewOutputData();
+
+  virtual int RequestData(
+    vtkInformation* request, vtkInformationVector** inputVector,
+    vtkInformationVector* outputVector);
+
+  virtual int FillOutputPortInformation(int port, vtkInformation *info);
+  virtual int FillInputPortInformation(int port, vtkInformation *info);
+
+  // Description:
+  // Convert the contours to the structured coordinates of the image,
+  // sort them by slice, and clear the sums for all of the structures.
+  void PrepareContours(vtkImageData *input, vtkROIContourData *data,
+                       const int wholeExtent[6]);
+
+  // Description:
+  // Add the voxels in the given extent to the sums.
+  void AccumulateSlab(vtkImageData *input, const int extent[6]);
+
+  // Description:
+  // Combine the sums from all of the threads to make the output.
+  void GenerateTable(vtkTable *output);
+
+  // Description:
+  // Add the voxels from the slices that belong to the given thread.
+  void ThreadedExecute(vtkROIContourDataStatisticsThreadStruct *ts,
+                       int threadId, int numThreads);
+
+  friend class vtkROIContourDataStatisticsThreadStruct;
+
+  vtkMatrix4x4 *ROIMatrix;
+  vtkMatrix4x4 *ImageMatrix;
+  int PartialVoxelWeighting;
+  int Subdivision;
+  double SubdivisionTarget;
+  int NumberOfBins;
+  double BinOrigin;
+  double BinSpacing;
+  int NumberOfThreads;
+  vtkMultiThreader *Threader;
+  vtkROIContourDataStatisticsThreadStruct *ThreadData;
+
+private:
+  vtkROIContourDataStatistics(const vtkROIContourDataStatistics&);  // Not implemented.
+  void operator=(const vtkROIContourDataStatistics&);  // Not implemented.
+};
+
+#endif
@@ -0,0 +1,387 @@
+/*=========================================================================
+
+  Program:   ToolCursor
+  Module:    vtkROIContourDataToImageStencil.cxx
+
+  Copyright (c) 2010 David Gobbi
+  All rights reserved.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkROIContourDataToImageStencil.h"
+
+#include "vtkROIContourData.h"
+#include "vtkROIContourDataToPolyData.h"
+#include "vtkROIContourScanConverter.h"
+#include "vtkImageStencilData.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkObjectFactory.h"
+#include "vtkPoints.h"
+#include "vtkDoubleArray.h"
+#include "vtkIdList.h"
+#include "vtkMultiThreader.h"
+#include "vtkMath.h"
+
+#include <vector>
+
+vtkStandardNewMacro(vtkROIContourDataToImageStencil);
+
+//----------------------------------------------------------------------------
+// The information that is shared by the threads.  The contours are sorted
+// by slice before the threads start, so each thread only has to look at
+// the contours for its own slices.
+class vtkROIContourDataToImageStencilThreadStruct
+{
+public:
+  vtkROIContourDataToImageStencil *Filter;
+  vtkImageStencilData *Output;
+  int Extent[6];
+  std::vector<std::vector<vtkPoints *> > Slices;
+
+  static VTK_THREAD_RETURN_TYPE ThreadMain(void *arg);
+};
+
+//----------------------------------------------------------------------------
+vtkROIContourDataToImageStencil::vtkROIContourDataToImageStencil()
+{
+  this->Subdivision = 0;
+  this->SubdivisionTarget = 1.0;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->Threader = vtkMultiThreader::New();
+
+  this->SetNumberOfInputPorts(1);
+}
+
+//----------------------------------------------------------------------------
+vtkROIContourDataToImageStencil::~vtkROIContourDataToImageStencil()
+{
+  this->Threader->Delete();
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourDataToImageStencil::PrintSelf(
+  ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Subdivision: " << (this->Subdivision ? "On\n" : "Off\n");
+  os << indent << "SubdivisionTarget: " << this->SubdivisionTarget << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+}
+
+//----------------------------------------------------------------------------
+vtkDataObject* vtkROIContourDataToImageStencil::GetInput()
+{
+  return this->GetExecutive()->GetInputData(0, 0);
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourDataToImageStencil::SetInput(vtkDataObject* input)
+{
+#if VTK_MAJOR_VERSION >= 6
+  this->SetInputDataInternal(0, input);
+#else
+  vtkAlgorithmOutput *producerPort = 0;
+
+  if (input)
+    {
+    producerPort = input->GetProducerPort();
+    }
+
+  this->SetInputConnection(0, producerPort);
+#endif
+}
+
+//----------------------------------------------------------------------------
+int vtkROIContourDataToImageStencil::FillInputPortInformation(
+  int, vtkInformation *info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkROIContourData");
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+namespace {
+
+// Add the runs for one row to the stencil.  Runs that touch are merged
+// before they are added.
+void vtkFillRow(
+  vtkROIContourScanConverter *scanner, int yIdx, int zIdx,
+  vtkImageStencilData *output)
+{
+  bool pending = false;
+  int s1 = 0;
+  int s2 = 0;
+  int r1, r2;
+  int iter = 0;
+  while (scanner->GetNextExtent(yIdx, iter, r1, r2))
+    {
+    if (pending && r1 <= s2 + 1)
+      {
+      s2 = (r2 > s2 ? r2 : s2);
+      }
+    else
+      {
+      if (pending)
+        {
+        output->InsertNextExtent(s1, s2, yIdx, zIdx);
+        }
+      s1 = r1;
+      s2 = r2;
+      pending = true;
+      }
+    }
+
+  if (pending)
+    {
+    output->InsertNextExtent(s1, s2, yIdx, zIdx);
+    }
+}
+
+// Convert the contours on a slice, one slice at a time.  The scratch
+// space is kept between slices, so one of these is used per thread.
+class vtkContourSliceConverter
+{
+public:
+  vtkContourSliceConverter(vtkImageStencilData *output, int subdivision,
+                           double subdivisionTarget);
+  ~vtkContourSliceConverter();
+
+  void ConvertSlice(vtkPoints *const *contours, size_t n, int zIdx);
+
+private:
+  vtkImageStencilData *Output;
+  int Extent[6];
+  double Spacing[3];
+  double Origin[3];
+  double SubdivisionTarget;
+  vtkDoubleArray *Subdivided;
+  vtkROIContourScanConverter *Scanner;
+  std::vector<double> Coords;
+  std::vector<double> XY;
+};
+
+vtkContourSliceConverter::vtkContourSliceConverter(
+  vtkImageStencilData *output, int subdivision, double subdivisionTarget)
+{
+  this->Output = output;
+  output->GetExtent(this->Extent);
+  output->GetSpacing(this->Spacing);
+  output->GetOrigin(this->Origin);
+  this->SubdivisionTarget = subdivisionTarget;
+  this->Subdivided = 0;
+  if (subdivision)
+    {
+    this->Subdivided = vtkDoubleArray::New();
+    }
+  this->Scanner = vtkROIContourScanConverter::New();
+  this->Scanner->Initialize(this->Extent, 1);
+}
+
+vtkContourSliceConverter::~vtkContourSliceConverter()
+{
+  if (this->Subdivided)
+    {
+    this->Subdivided->Delete();
+    }
+  this->Scanner->Delete();
+}
+
+void vtkContourSliceConverter::ConvertSlice(
+  vtkPoints *const *contours, size_t numContours, int zIdx)
+{
+  const int *extent = this->Extent;
+  if (extent[1] < extent[0] || extent[3] < extent[2] ||
+      zIdx < extent[4] || zIdx > extent[5])
+    {
+    return;
+    }
+
+  int rowMin = extent[3] + 1;
+  int rowMax = extent[2] - 1;
+
+  for (size_t c = 0; c < numContours; c++)
+    {
+    vtkPoints *points = contours[c];
+    const double *xyz = 0;
+    vtkIdType n = 0;
+    if (this->Subdivided)
+      {
+      n = vtkROIContourDataToPolyData::SubdivideWithCatmullRom(
+        points, 1, this->SubdivisionTarget, this->Subdivided);
+      xyz = this->Subdivided->GetPointer(0);
+      }
+    else
+      {
+      n = points->GetNumberOfPoints();
+      this->Coords.resize(static_cast<size_t>(3*n));
+      for (vtkIdType j = 0; j < n; j++)
+        {
+        points->GetPoint(j, &this->Coords[3*j]);
+        }
+      xyz = (n > 0 ? &this->Coords[0] : 0);
+      }
+    if (n < 2)
+      {
+      continue;
+      }
+
+    // Convert to structured x,y coordinates
+    this->XY.resize(static_cast<size_t>(2*n));
+    for (vtkIdType j = 0; j < n; j++)
+      {
+      this->XY[2*j] = (xyz[3*j] - this->Origin[0])/this->Spacing[0];
+      this->XY[2*j + 1] = (xyz[3*j + 1] - this->Origin[1])/this->Spacing[1];
+      }
+
+    this->Scanner->AddPolygon(&this->XY[0], n, &rowMin, &rowMax);
+    }
+
+  for (int yIdx = rowMin; yIdx <= rowMax; yIdx++)
+    {
+    vtkFillRow(this->Scanner, yIdx, zIdx, this->Output);
+    }
+}
+
+} // end anonymous namespace
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkROIContourDataToImageStencilThreadStruct::ThreadMain(
+  void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkROIContourDataToImageStencilThreadStruct *ts =
+    static_cast<vtkROIContourDataToImageStencilThreadStruct *>(info->UserData);
+
+  ts->Filter->ThreadedExecute(ts, info->ThreadID, info->NumberOfThreads);
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourDataToImageStencil::ThreadedExecute(
+  vtkROIContourDataToImageStencilThreadStruct *ts, int threadId,
+  int numThreads)
+{
+  const int *extent = ts->Extent;
+  vtkContourSliceConverter converter(
+    ts->Output, this->Subdivision, this->SubdivisionTarget);
+
+  // Each thread takes every numThreads'th slice
+  for (int zIdx = extent[4] + threadId; zIdx <= extent[5];
+       zIdx += numThreads)
+    {
+    std::vector<vtkPoints *> *contours = &ts->Slices[zIdx - extent[4]];
+    if (!contours->empty())
+      {
+      converter.ConvertSlice(&(*contours)[0], contours->size(), zIdx);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourDataToImageStencil::ConvertSlice(
+  vtkROIContourData *data, vtkIdList *contourIds,
+  vtkImageStencilData *stencil, int zIdx, int subdivision,
+  double subdivisionTarget)
+{
+  std::vector<vtkPoints *> contours;
+  vtkIdType n = contourIds->GetNumberOfIds();
+  for (vtkIdType i = 0; i < n; i++)
+    {
+    int contourId = static_cast<int>(contourIds->GetId(i));
+    vtkPoints *points = data->GetContourPoints(contourId);
+    if (points && points->GetNumberOfPoints() >= 2 &&
+        data->GetContourType(contourId) == vtkROIContourData::CLOSED_PLANAR)
+      {
+      contours.push_back(points);
+      }
+    }
+
+  if (!contours.empty())
+    {
+    vtkContourSliceConverter converter(
+      stencil, subdivision, subdivisionTarget);
+    converter.ConvertSlice(&contours[0], contours.size(), zIdx);
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkROIContourDataToImageStencil::RequestData(
+  vtkInformation *request,
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  // The superclass allocates the extents of the stencil
+  this->Superclass::RequestData(request, inputVector, outputVector);
+
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+
+  vtkROIContourData *input = vtkROIContourData::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkImageStencilData *output = vtkImageStencilData::SafeDownCast(
+    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+
+  vtkROIContourDataToImageStencilThreadStruct ts;
+  ts.Filter = this;
+  ts.Output = output;
+  output->GetExtent(ts.Extent);
+  double spacing[3];
+  double origin[3];
+  output->GetSpacing(spacing);
+  output->GetOrigin(origin);
+
+  const int *extent = ts.Extent;
+  int numSlices = extent[5] - extent[4] + 1;
+  if (numSlices <= 0 || extent[1] < extent[0] || extent[3] < extent[2])
+    {
+    return 1;
+    }
+
+  // Put each closed contour on the slice that is nearest to its center.
+  // This is done before the threads start, since getting the points
+  // might require views of packed points to be made.
+  ts.Slices.resize(static_cast<size_t>(numSlices));
+  int numContours = input->GetNumberOfContours();
+  for (int i = 0; i < numContours; i++)
+    {
+    vtkPoints *points = input->GetContourPoints(i);
+    if (!points || points->GetNumberOfPoints() < 2 ||
+        input->GetContourType(i) != vtkROIContourData::CLOSED_PLANAR)
+      {
+      continue;
+      }
+
+    double bounds[6];
+    input->GetContourBounds(i, bounds);
+    double z = 0.5*(bounds[4] + bounds[5]);
+    int zIdx = vtkMath::Floor((z - origin[2])/spacing[2] + 0.5);
+    if (zIdx >= extent[4] && zIdx <= extent[5])
+      {
+      ts.Slices[zIdx - extent[4]].push_back(points);
+      }
+    }
+
+  int numThreads = this->NumberOfThreads;
+  numThreads = (numThreads > numSlices ? numSlices : numThreads);
+
+  if (numThreads > 1)
+    {
+    this->Threader->SetNumberOfThreads(numThreads);
+    this->Threader->SetSingleMethod(
+      &vtkROIContourDataToImageStencilThreadStruct::ThreadMain, &ts);
+    this->Threader->SingleMethodExecute();
+    }
+  else
+    {
+    this->ThreadedExecute(&ts, 0, 1);
+    }
+
+  return 1;
+}
@@ -0,0 +1,105 @@
+/*=========================================================================
+
+  Program:   ToolCursor
+  Module:    vtkROIContourDataToImageStencil.h
+
+  Copyright (c) 2010 David Gobbi
+  All rights reserved.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkROIContourDataToImageStencil - Convert ROI contours to a stencil
+// .SECTION Description
+// This filter will scan-convert the closed contours of a vtkROIContourData
+// directly into a vtkImageStencilData, without making a polydata first.
+// The contours are assumed to lie in the x-y planes of the image, and each
+// contour is assigned to the slice that is nearest to it.  Within a slice,
+// the stencil is made with an even-odd rule, so contours that lie inside
+// other contours become holes.  A pixel is inside if its center is inside
+// the contour.  The slices are divided between several threads.
+// Use SetInformationInput() or SetOutputWholeExtent(), SetOutputSpacing(),
+// and SetOutputOrigin() to set the geometry of the stencil.
+
+#ifndef __vtkROIContourDataToImageStencil_h
+#define __vtkROIContourDataToImageStencil_h
+
+#include "vtkImageStencilSource.h"
+#include "vtkMultiThreader.h" // for VTK_MAX_THREADS
+
+class vtkROIContourData;
+class vtkIdList;
+class vtkImageStencilData;
+class vtkROIContourDataToImageStencilThreadStruct;
+
+class VTK_EXPORT vtkROIContourDataToImageStencil :
+  public vtkImageStencilSource
+{
+public:
+  static vtkROIContourDataToImageStencil *New();
+  vtkTypeMacro(vtkROIContourDataToImageStencil, vtkImageStencilSource);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // The input to this filter must be a vtkROIContourData.
+  void SetInput(vtkDataObject *d);
+  vtkDataObject *GetInput();
+
+  // Description:
+  // Smooth the contours by subdividing them with the same Catmull-Rom
+  // spline as vtkROIContourDataToPolyData, before they are converted.
+  // The default is Off.
+  vtkSetMacro(Subdivision, int);
+  vtkBooleanMacro(Subdivision, int);
+  vtkGetMacro(Subdivision, int);
+
+  // Description:
+  // The target segment length for subdivision.  The default is 1.0.
+  vtkSetMacro(SubdivisionTarget, double);
+  vtkGetMacro(SubdivisionTarget, double);
+
+  // Description:
+  // The number of threads to use.  The slices are divided between the
+  // threads.  The default is the number of processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
+  // Description:
+  // Scan-convert the listed contours into slice zIdx of a stencil whose
+  // extents have already been allocated.  The rows of that slice should
+  // be empty.  This is for updating one slice of an existing stencil,
+  // see vtkROIContourMaskUpdater.
+  static void ConvertSlice(vtkROIContourData *data, vtkIdList *contourIds,
+                           vtkImageStencilData *stencil, int zIdx,
+                           int subdivision, double subdivisionTarget);
+
+protected:
+  vtkROIContourDataToImageStencil();
+  ~vtkROIContourDataToImageStencil();
+
+  virtual int RequestData(
+    vtkInformation* request, vtkInformationVector** inputVector,
+    vtkInformationVector* outputVector);
+
+  virtual int FillInputPortInformation(int port, vtkInformation *info);
+
+  // Description:
+  // Convert the contours on the slices that belong to the given thread.
+  void ThreadedExecute(vtkROIContourDataToImageStencilThreadStruct *ts,
+                       int threadId, int numThreads);
+
+  friend class vtkROIContourDataToImageStencilThreadStruct;
+
+  int Subdivision;
+  double SubdivisionTarget;
+  int NumberOfThreads;
+  vtkMultiThreader *Threader;
+
+private:
+  vtkROIContourDataToImageStencil(const vtkROIContourDataToImageStencil&);  // Not implemented.
+  void operator=(const vtkROIContourDataToImageStencil&);  // Not implemented.
+};
+
+#endif
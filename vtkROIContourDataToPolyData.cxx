@@ -23,11 +23,104 @@
 #include "vtkCellArray.h"
 #include "vtkIntArray.h"
 #include "vtkDoubleArray.h"
+#include "vtkIdList.h"
 #include "vtkCellData.h"
 #include "vtkPointData.h"
 #include "vtkPlane.h"
 #include "vtkKochanekSpline.h"
 #include "vtkMath.h"
+#include "vtkSmartPointer.h"
+#include "vtkMultiThreader.h"
+#include "vtkRenderer.h"
+#include "vtkCamera.h"
+
+#include <vector>
+#include <string.h>
+
+//----------------------------------------------------------------------------
+// The subdivided contours from the previous execution.  Each entry is
+// for the contour with the same index, and is only valid if the contour
+// still has the same points, MTime, size, and type.
+class vtkROIContourDataToPolyDataCache
+{
+public:
+  struct Entry
+  {
+    vtkPoints *ContourPoints;
+    unsigned long MTime;
+    vtkIdType NumberOfPoints;
+    int Type;
+    bool Success;
+    vtkSmartPointer<vtkPoints> Points;
+    vtkSmartPointer<vtkCellArray> Lines;
+    vtkSmartPointer<vtkIntArray> SubIds;
+
+    Entry() : ContourPoints(0), MTime(0), NumberOfPoints(0), Type(-1),
+      Success(false) {}
+
+    // Check whether the entry was made from the given contour
+    bool Matches(vtkPoints *points, unsigned long mtime, vtkIdType n,
+                 int type) const {
+      return (this->ContourPoints == points && this->MTime == mtime &&
+              this->NumberOfPoints == n && this->Type == type); }
+
+    // Set the contour that the entry is made from
+    void SetKey(vtkPoints *points, unsigned long mtime, vtkIdType n,
+                int type) {
+      this->ContourPoints = points;
+      this->MTime = mtime;
+      this->NumberOfPoints = n;
+      this->Type = type; }
+  };
+
+  std::vector<Entry> Entries;
+
+  // The settings that were used for the subdivision
+  double SubdivisionTarget;
+  vtkSpline *Spline;
+  unsigned long SplineMTime;
+
+  vtkROIContourDataToPolyDataCache() : SubdivisionTarget(0), Spline(0),
+    SplineMTime(0) {}
+};
+
+//----------------------------------------------------------------------------
+// The information that is shared by the threads.  The contours are done
+// in two passes: first the number of output points for each contour is
+// computed, and then, once the offset of each contour within the output
+// arrays is known, each contour is written directly into the output.
+class vtkROIContourDataToPolyDataThreadStruct
+{
+public:
+  // How each contour is to be written to the output
+  enum { SKIP, COPY, SPLINE, CACHED };
+
+  struct Piece
+  {
+    int Contour;
+    vtkPoints *Points;
+    unsigned long MTime;
+    int Type;
+    int Method;
+    vtkIdType NumberOfKnots;
+    vtkIdType NumberOfPoints;
+    vtkIdType PointOffset;
+    vtkIdType CellOffset;
+  };
+
+  vtkROIContourDataToPolyData *Filter;
+  vtkROIContourDataToPolyDataCache *Cache;
+  int Subdivision;
+  double SubdivisionTarget;
+  std::vector<Piece> Pieces;
+  int Pass;
+  double *Points;
+  int *SubIds;
+  vtkIdType *Lines;
+  vtkIdType *Verts;
+
+  static VTK_THREAD_RETURN_TYPE ThreadMain(void *arg);
+};
 
 vtkStandardNewMacro(vtkROIContourDataToPolyData);
 vtkCxxSetObjectMacro(vtkROIContourDataToPolyData,SelectionPlane,vtkPlane);
@@ -40,12 +133,20 @@ vtkROIContourDataToPolyData::vtkROIContourDataToPolyData()
   this->SelectionPlaneTolerance = 0.5;
   this->Subdivision = 0;
   this->SubdivisionTarget = 1.0;
+  this->PixelSize = 0.0;
+  this->SubdivisionPixels = 4.0;
+  this->ActiveSubdivisionTarget = 1.0;
   this->Spline = 0;
 
   this->SplineX = 0;
   this->SplineY = 0;
   this->SplineZ = 0;
   this->KnotPositions = 0;
+
+  this->Cache = new vtkROIContourDataToPolyDataCache;
+
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->Threader = vtkMultiThreader::New();
 }
 
 //----------------------------------------------------------------------------
@@ -69,6 +170,8 @@ vtkROIContourDataToPolyData::~vtkROIContourDataToPolyData()
     {
     this->KnotPositions->Delete();
     }
+  delete this->Cache;
+  this->Threader->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -81,7 +184,64 @@ void vtkROIContourDataToPolyData::PrintSelf(ostream& os, vtkIndent indent)
      << this->SelectionPlaneTolerance << "\n";
   os << indent << "Subdivision: " << (this->Subdivision ? "On\n" : "Off\n");
   os << indent << "SubdivisionTarget: " << this->SubdivisionTarget << "\n";
+  os << indent << "PixelSize: " << this->PixelSize << "\n";
+  os << indent << "SubdivisionPixels: " << this->SubdivisionPixels << "\n";
+  os << indent << "Renderer: " << this->Renderer.GetPointer() << "\n";
   os << indent << "Spline: " << this->Spline << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourDataToPolyData::SetRenderer(vtkRenderer *renderer)
+{
+  // The renderer is not reference counted, since it usually holds an
+  // actor that holds a mapper that is connected to this filter, but the
+  // weak pointer is cleared if the renderer is destroyed
+  if (renderer != this->Renderer.GetPointer())
+    {
+    this->Renderer = renderer;
+    this->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkRenderer *vtkROIContourDataToPolyData::GetRenderer()
+{
+  return this->Renderer;
+}
+
+//----------------------------------------------------------------------------
+double vtkROIContourDataToPolyData::ComputeSubdivisionTarget()
+{
+  double pixelSize = this->PixelSize;
+
+  vtkRenderer *renderer = this->Renderer;
+  if (renderer)
+    {
+    // Get the size of a pixel at the focal point
+    int *size = renderer->GetSize();
+    vtkCamera *camera = renderer->GetActiveCamera();
+    if (camera && size[1] > 0)
+      {
+      double height = 2*camera->GetParallelScale();
+      if (!camera->GetParallelProjection())
+        {
+        double angle = vtkMath::RadiansFromDegrees(camera->GetViewAngle());
+        height = 2*camera->GetDistance()*tan(0.5*angle);
+        }
+      pixelSize = height/size[1];
+      }
+    }
+
+  if (pixelSize <= 0 || this->SubdivisionPixels <= 0)
+    {
+    return this->SubdivisionTarget;
+    }
+
+  // Round to a power of two, so that the contours are not subdivided
+  // again until the zoom has changed by a factor of two
+  double target = this->SubdivisionPixels*pixelSize;
+  return pow(2.0, floor(log(target)/log(2.0) + 0.5));
 }
 
 //----------------------------------------------------------------------------
@@ -96,7 +256,7 @@ int vtkROIContourDataToPolyData::FillInputPortInformation(
 int vtkROIContourDataToPolyData::ComputePipelineMTime(
   vtkInformation* vtkNotUsed(request),
   vtkInformationVector** vtkNotUsed(inputVector),
-  vtkInformationVector* vtkNotUsed(outputVector),
+  vtkInformationVector* outputVector,
   int vtkNotUsed(requestFromOutputPort),
   unsigned long* mtime)
 {
@@ -113,6 +273,22 @@ int vtkROIContourDataToPolyData::ComputePipelineMTime(
       }
     }
 
+  // Check whether the view has changed enough to need a new subdivision,
+  // and if so, report a time that is newer than the output.  Nothing is
+  // changed here, RequestData() stores the target that it used.
+  if (this->Subdivision &&
+      (this->Renderer.GetPointer() || this->PixelSize > 0) &&
+      this->ComputeSubdivisionTarget() != this->ActiveSubdivisionTarget)
+    {
+    vtkInformation *outInfo = outputVector->GetInformationObject(0);
+    vtkDataObject *output =
+      (outInfo ? outInfo->Get(vtkDataObject::DATA_OBJECT()) : 0);
+    if (output && output->GetUpdateTime() >= mTime)
+      {
+      mTime = output->GetUpdateTime() + 1;
+      }
+    }
+
   *mtime = mTime;
 
   return 1;
@@ -191,7 +367,7 @@ void vtkROIContourDataToPolyData::ComputeSpline(
   if (closed)
     {
     // require a tolerance, base it off the desired subdivision
-    double tol = this->SubdivisionTarget*1e-3;
+    double tol = this->ActiveSubdivisionTarget*1e-3;
     tol *= tol;
 
     // sometimes that last point (or several last points) are almost exactly
@@ -258,6 +434,72 @@ void vtkROIContourDataToPolyData::ComputeSpline(
 }
 
 
+//----------------------------------------------------------------------------
+// Cardinal and Kochanek splines are cubic between the knots, so their
+// intervals can be stepped through by forward differencing instead of
+// calling Evaluate() for every sample.
+namespace {
+
+// Given the values of a cubic at u = 0, 1/3, 2/3 and 1, compute its value
+// and forward differences at u = 0 for steps of size h.
+void vtkCubicForwardDifferences(const double y[4], double h, double d[4])
+{
+  // Newton's forward differences for the steps of 1/3
+  double d1 = y[1] - y[0];
+  double d2 = y[2] - 2*y[1] + y[0];
+  double d3 = y[3] - 3*y[2] + 3*y[1] - y[0];
+
+  // The polynomial coefficients for u
+  double b = 3*(d1 - 0.5*d2 + d3/3);
+  double c = 9*(0.5*d2 - 0.5*d3);
+  double e = 4.5*d3;
+
+  double h2 = h*h;
+  double h3 = h2*h;
+  d[0] = y[0];
+  d[1] = b*h + c*h2 + e*h3;
+  d[2] = 2*c*h2 + 6*e*h3;
+  d[3] = 6*e*h3;
+}
+
+// Write n points along one interval of the splines, from t0 up to (but
+// not including) t1.  The spline values at t0 and t1 must be given.
+void vtkForwardDifferenceSpline(
+  vtkSpline *splines[3], double t0, double t1, const double p0[3],
+  const double p1[3], int n, double *q)
+{
+  double ta = (2*t0 + t1)/3;
+  double tb = (t0 + 2*t1)/3;
+  double d[3][4];
+  for (int k = 0; k < 3; k++)
+    {
+    double y[4];
+    y[0] = p0[k];
+    y[1] = splines[k]->Evaluate(ta);
+    y[2] = splines[k]->Evaluate(tb);
+    y[3] = p1[k];
+    vtkCubicForwardDifferences(y, 1.0/n, d[k]);
+    }
+
+  int i = n;
+  do
+    {
+    q[0] = d[0][0];
+    q[1] = d[1][0];
+    q[2] = d[2][0];
+    q += 3;
+    for (int k = 0; k < 3; k++)
+      {
+      d[k][0] += d[k][1];
+      d[k][1] += d[k][2];
+      d[k][2] += d[k][3];
+      }
+    }
+  while (--i);
+}
+
+} // end anonymous namespace
+
 //----------------------------------------------------------------------------
 bool vtkROIContourDataToPolyData::GenerateSpline(
   vtkPoints *contourPoints, bool closed,
@@ -281,23 +523,46 @@ bool vtkROIContourDataToPolyData::GenerateSpline(
   // Because InsertNextPoint is very slow
   vtkDoubleArray *da = vtkDoubleArray::SafeDownCast(points->GetData());
 
+  // For cubic splines, each interval only needs two evaluations
+  vtkSpline *splines[3] = { xspline, yspline, zspline };
+  bool cubic = ((xspline->IsA("vtkCardinalSpline") ||
+                 xspline->IsA("vtkKochanekSpline")) &&
+                !xspline->GetClampValue());
+
+  // The spline passes through the contour points at the knots, and for
+  // closed splines the last knot is at the first point
+  vtkIdType numSplinePoints = m - closed;
+  double p0[3], p1[3];
+  contourPoints->GetPoint(0, p0);
+
   vtkIdType id0 = points->GetNumberOfPoints();
   double t0 = 0;
-  double f = dmax/(tmax*this->SubdivisionTarget);
+  double f = dmax/(tmax*this->ActiveSubdivisionTarget);
   for (vtkIdType j = 1; j < m; j++)
     {
     double t1 = knots->GetValue(j);
     int n = vtkMath::Floor((t1 - t0)*f) + 1;
     vtkIdType id = points->GetNumberOfPoints();
     double *p = da->WritePointer(id*3, n*3);
-    for (int i = 0; i < n; i++)
+    contourPoints->GetPoint((j < numSplinePoints ? j : 0), p1);
+    if (cubic && n > 2)
       {
-      double t = (t0*(n-i) + t1*i)/n;
-      p[0] = xspline->Evaluate(t);
-      p[1] = yspline->Evaluate(t);
-      p[2] = zspline->Evaluate(t);
-      p += 3;
+      vtkForwardDifferenceSpline(splines, t0, t1, p0, p1, n, p);
       }
+    else
+      {
+      for (int i = 0; i < n; i++)
+        {
+        double t = (t0*(n-i) + t1*i)/n;
+        p[0] = xspline->Evaluate(t);
+        p[1] = yspline->Evaluate(t);
+        p[2] = zspline->Evaluate(t);
+        p += 3;
+        }
+      }
+    p0[0] = p1[0];
+    p0[1] = p1[1];
+    p0[2] = p1[2];
     if (subIds)
       {
       int *iptr = subIds->WritePointer(subIds->GetMaxId()+1, n);
@@ -345,18 +610,22 @@ bool vtkROIContourDataToPolyData::GenerateSpline(
 }
 
 //----------------------------------------------------------------------------
-// If a vtkSpline is not provided, do the spline computations here
-// (several times faster than using vtkSpline to make a generic spline)
-bool vtkROIContourDataToPolyData::CatmullRomSpline(
-  vtkPoints *contourPoints, bool closed,
-  vtkPoints *points, vtkCellArray *lines, vtkIntArray *subIds)
+// The Catmull-Rom spline is split into a part that counts the output
+// points and a part that writes them, so that the points can be written
+// directly into a preallocated array by several threads at once.
+namespace {
+
+// Get the number of contour points to use for the spline, ignoring any
+// points at the end of a closed contour that lie on the first point.
+vtkIdType vtkCatmullRomNumberOfKnots(
+  vtkPoints *contourPoints, bool closed, double target)
 {
   vtkIdType m = contourPoints->GetNumberOfPoints();
 
   if (closed && m > 2)
     {
     // require a tolerance, base it off the desired subdivision
-    double tol = this->SubdivisionTarget*1e-3;
+    double tol = target*1e-3;
     tol *= tol;
 
     // ignore all end point that are the same as first point
@@ -372,17 +641,38 @@ bool vtkROIContourDataToPolyData::CatmullRomSpline(
     m += 1;
     }
 
-  if (m < 2)
+  return m;
+}
+
+// Get the number of points that the spline will generate from m knots.
+vtkIdType vtkCatmullRomNumberOfPoints(
+  vtkPoints *contourPoints, vtkIdType m, bool closed, double target)
+{
+  int m1 = static_cast<int>(m) + closed - 1;
+  vtkIdType n = (closed ? 0 : 1);
+
+  double p0[3], p1[3];
+  contourPoints->GetPoint(0, p0);
+  for (int j = 0; j < m1; j++)
     {
-    return false;
+    contourPoints->GetPoint((j + 1) % m, p1);
+    double d0 = sqrt(vtkMath::Distance2BetweenPoints(p0, p1));
+    n += vtkMath::Floor(d0/target) + 1;
+    p0[0] = p1[0];
+    p0[1] = p1[1];
+    p0[2] = p1[2];
     }
 
-  // Save the initial size of the point array
-  vtkIdType id0 = points->GetNumberOfPoints();
-
-  // For fast writing to point data
-  vtkDoubleArray *da = vtkDoubleArray::SafeDownCast(points->GetData());
+  return n;
+}
 
+// Evaluate the spline for m knots, and write the points and their subIds.
+// The arrays must have space for vtkCatmullRomNumberOfPoints() values,
+// and subIds can be NULL.
+void vtkCatmullRomWritePoints(
+  vtkPoints *contourPoints, vtkIdType m, bool closed, double target,
+  double *q, int *subIds)
+{
   double p1[3], p0[3], p2[3];
   contourPoints->GetPoint(m-1, p2);
   contourPoints->GetPoint(0, p0);
@@ -406,7 +696,7 @@ bool vtkROIContourDataToPolyData::CatmullRomSpline(
     double dy1 = (p2[1] - p0[1])*f;
     double dz1 = (p2[2] - p0[2])*f;
 
-    int n = vtkMath::Floor(d0/this->SubdivisionTarget) + 1;
+    int n = vtkMath::Floor(d0/target) + 1;
     double dt = 1.0/n;
     double t = 0.0;
 
@@ -440,8 +730,6 @@ bool vtkROIContourDataToPolyData::CatmullRomSpline(
     cz[2] = dz + dz + dz - dz2 - dz3;
     cz[3] = dz3 - dz - dz;
 
-    vtkIdType id = points->GetNumberOfPoints();
-    double *q = da->WritePointer(3*id, 3*n);
     int i = n;
     do
       {
@@ -458,9 +746,7 @@ bool vtkROIContourDataToPolyData::CatmullRomSpline(
 
     if (subIds)
       {
-      id = subIds->GetMaxId() + 1;
-      int *iptr = subIds->WritePointer(id, n);
-      do { *iptr++ = j; } while (--n);
+      do { *subIds++ = j; } while (--n);
       }
 
     p0[0] = p1[0];
@@ -480,22 +766,21 @@ bool vtkROIContourDataToPolyData::CatmullRomSpline(
 
   if (!closed)
     {
-    double q[3];
     contourPoints->GetPoint(m1, q);
-    points->InsertNextPoint(q);
     if (subIds)
       {
-      subIds->InsertNextValue(m1);
+      *subIds = m1;
       }
     }
+}
 
-  vtkIdType id1 = points->GetNumberOfPoints();
-  lines->SetNumberOfCells(lines->GetNumberOfCells() + 1);
-  vtkIdTypeArray *ia = lines->GetData();
-  vtkIdType cellSize = id1 - id0 + closed;
-  vtkIdType *iptr = ia->WritePointer(ia->GetMaxId()+1, cellSize+1);
-  *iptr++ = cellSize;
-  for (vtkIdType id = id0; id < id1; id++)
+// Write the point ids for a polyline cell with n points, starting at
+// point id0.  If the cell is closed, the first id is repeated at the end.
+void vtkWritePolyLineCell(vtkIdType *iptr, vtkIdType id0, vtkIdType n,
+                          bool closed)
+{
+  *iptr++ = n + closed;
+  for (vtkIdType id = id0; id < id0 + n; id++)
     {
     *iptr++ = id;
     }
@@ -503,10 +788,392 @@ bool vtkROIContourDataToPolyData::CatmullRomSpline(
     {
     *iptr++ = id0;
     }
+}
+
+} // end anonymous namespace
+
+//----------------------------------------------------------------------------
+// If a vtkSpline is not provided, do the spline computations here
+// (several times faster than using vtkSpline to make a generic spline)
+bool vtkROIContourDataToPolyData::CatmullRomSpline(
+  vtkPoints *contourPoints, bool closed,
+  vtkPoints *points, vtkCellArray *lines, vtkIntArray *subIds)
+{
+  double target = this->ActiveSubdivisionTarget;
+  vtkIdType m = vtkCatmullRomNumberOfKnots(contourPoints, closed, target);
+
+  if (m < 2)
+    {
+    return false;
+    }
+
+  vtkIdType n = vtkCatmullRomNumberOfPoints(contourPoints, m, closed, target);
+
+  // For fast writing to point data
+  vtkIdType id0 = points->GetNumberOfPoints();
+  vtkDoubleArray *da = vtkDoubleArray::SafeDownCast(points->GetData());
+  double *q = da->WritePointer(3*id0, 3*n);
+
+  int *iptr = 0;
+  if (subIds)
+    {
+    iptr = subIds->WritePointer(subIds->GetMaxId() + 1, n);
+    }
+
+  vtkCatmullRomWritePoints(contourPoints, m, closed, target, q, iptr);
+
+  lines->SetNumberOfCells(lines->GetNumberOfCells() + 1);
+  vtkIdTypeArray *ia = lines->GetData();
+  vtkIdType *cptr = ia->WritePointer(ia->GetMaxId()+1, n + closed + 1);
+  vtkWritePolyLineCell(cptr, id0, n, closed);
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkROIContourDataToPolyData::SubdivideWithCatmullRom(
+  vtkPoints *contourPoints, int closed, double target,
+  vtkDoubleArray *points)
+{
+  vtkIdType m = vtkCatmullRomNumberOfKnots(contourPoints, closed, target);
+  if (m < 2)
+    {
+    points->SetNumberOfTuples(0);
+    return 0;
+    }
+
+  vtkIdType n = vtkCatmullRomNumberOfPoints(contourPoints, m, closed, target);
+  points->SetNumberOfComponents(3);
+  points->SetNumberOfTuples(n);
+  vtkCatmullRomWritePoints(contourPoints, m, closed != 0, target,
+                           points->GetPointer(0), 0);
+
+  return n;
+}
+
+//----------------------------------------------------------------------------
+bool vtkROIContourDataToPolyData::SubdivideContour(
+  vtkROIContourData *data, int i,
+  vtkPoints *points, vtkCellArray *lines, vtkIntArray *subIds)
+{
+  vtkROIContourDataToPolyDataCache::Entry *e = &this->Cache->Entries[i];
+  vtkPoints *contourPoints = data->GetContourPoints(i);
+  unsigned long mtime = data->GetContourMTime(i);
+  vtkIdType m = contourPoints->GetNumberOfPoints();
+  int t = data->GetContourType(i);
+
+  if (!e->Matches(contourPoints, mtime, m, t))
+    {
+    // The contour has changed, so subdivide it again
+    e->SetKey(contourPoints, mtime, m, t);
+    e->Points = vtkSmartPointer<vtkPoints>::New();
+    e->Points->SetDataTypeToDouble();
+    e->Lines = vtkSmartPointer<vtkCellArray>::New();
+    e->SubIds = vtkSmartPointer<vtkIntArray>::New();
+
+    bool closed = (t == vtkROIContourData::CLOSED_PLANAR);
+    if (this->Spline)
+      {
+      e->Success = this->GenerateSpline(
+        contourPoints, closed, e->Points, e->Lines, e->SubIds);
+      }
+    else
+      {
+      e->Success = this->CatmullRomSpline(
+        contourPoints, closed, e->Points, e->Lines, e->SubIds);
+      }
+    }
+
+  if (!e->Success)
+    {
+    return false;
+    }
+
+  // Append the cached points to the output
+  vtkIdType id0 = points->GetNumberOfPoints();
+  vtkIdType n = e->Points->GetNumberOfPoints();
+  vtkDoubleArray *da = vtkDoubleArray::SafeDownCast(points->GetData());
+  double *p = da->WritePointer(3*id0, 3*n);
+  memcpy(p, e->Points->GetVoidPointer(0), 3*n*sizeof(double));
+
+  if (subIds)
+    {
+    int *iptr = subIds->WritePointer(subIds->GetMaxId()+1, n);
+    memcpy(iptr, e->SubIds->GetPointer(0), n*sizeof(int));
+    }
+
+  // Append the cell, with the point ids offset to the new position
+  vtkIdTypeArray *cachedIds = e->Lines->GetData();
+  vtkIdType size = cachedIds->GetMaxId() + 1;
+  const vtkIdType *cptr = cachedIds->GetPointer(0);
+  lines->SetNumberOfCells(lines->GetNumberOfCells() + 1);
+  vtkIdTypeArray *ia = lines->GetData();
+  vtkIdType *iptr = ia->WritePointer(ia->GetMaxId()+1, size);
+  *iptr++ = *cptr++;
+  for (vtkIdType j = 1; j < size; j++)
+    {
+    *iptr++ = *cptr++ + id0;
+    }
 
   return true;
 }
 
+//----------------------------------------------------------------------------
+// Find out how a contour will be written, and how many points it needs.
+namespace {
+void vtkCountContourPoints(
+  vtkROIContourDataToPolyDataThreadStruct *ts,
+  vtkROIContourDataToPolyDataThreadStruct::Piece *piece)
+{
+  vtkPoints *points = piece->Points;
+  vtkIdType m = points->GetNumberOfPoints();
+  int t = piece->Type;
+  bool closed = (t == vtkROIContourData::CLOSED_PLANAR);
+
+  piece->Method = vtkROIContourDataToPolyDataThreadStruct::SKIP;
+  piece->NumberOfPoints = 0;
+
+  if (ts->Subdivision && m > 2 && t != vtkROIContourData::POINT)
+    {
+    vtkROIContourDataToPolyDataCache::Entry *e =
+      &ts->Cache->Entries[piece->Contour];
+    if (e->Matches(points, piece->MTime, m, t))
+      {
+      if (e->Success)
+        {
+        piece->Method = vtkROIContourDataToPolyDataThreadStruct::CACHED;
+        piece->NumberOfPoints = e->Points->GetNumberOfPoints();
+        }
+      }
+    else
+      {
+      // The cache arrays are allocated later, by the main thread
+      double target = ts->SubdivisionTarget;
+      vtkIdType knots = vtkCatmullRomNumberOfKnots(points, closed, target);
+      e->SetKey(points, piece->MTime, m, t);
+      e->Success = (knots >= 2);
+      if (e->Success)
+        {
+        piece->Method = vtkROIContourDataToPolyDataThreadStruct::SPLINE;
+        piece->NumberOfKnots = knots;
+        piece->NumberOfPoints =
+          vtkCatmullRomNumberOfPoints(points, knots, closed, target);
+        }
+      }
+    }
+  else if (m > 0)
+    {
+    piece->Method = vtkROIContourDataToPolyDataThreadStruct::COPY;
+    piece->NumberOfPoints = m;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Write a contour into the output at the offsets that were computed.
+void vtkWriteContourPoints(
+  vtkROIContourDataToPolyDataThreadStruct *ts,
+  vtkROIContourDataToPolyDataThreadStruct::Piece *piece)
+{
+  vtkIdType n = piece->NumberOfPoints;
+  vtkIdType id0 = piece->PointOffset;
+  bool closed = (piece->Type == vtkROIContourData::CLOSED_PLANAR);
+  double *q = ts->Points + 3*id0;
+  int *subIds = ts->SubIds + id0;
+  vtkROIContourDataToPolyDataCache::Entry *e = 0;
+
+  switch (piece->Method)
+    {
+    case vtkROIContourDataToPolyDataThreadStruct::SKIP:
+      return;
+    case vtkROIContourDataToPolyDataThreadStruct::COPY:
+      for (vtkIdType j = 0; j < n; j++)
+        {
+        piece->Points->GetPoint(j, &q[3*j]);
+        subIds[j] = static_cast<int>(j);
+        }
+      break;
+    case vtkROIContourDataToPolyDataThreadStruct::SPLINE:
+      // Write to the output, and then save a copy in the cache
+      e = &ts->Cache->Entries[piece->Contour];
+      vtkCatmullRomWritePoints(piece->Points, piece->NumberOfKnots, closed,
+                               ts->SubdivisionTarget, q, subIds);
+      memcpy(e->Points->GetVoidPointer(0), q, 3*n*sizeof(double));
+      memcpy(e->SubIds->GetPointer(0), subIds, n*sizeof(int));
+      vtkWritePolyLineCell(e->Lines->GetData()->GetPointer(0), 0, n, closed);
+      break;
+    case vtkROIContourDataToPolyDataThreadStruct::CACHED:
+      e = &ts->Cache->Entries[piece->Contour];
+      memcpy(q, e->Points->GetVoidPointer(0), 3*n*sizeof(double));
+      memcpy(subIds, e->SubIds->GetPointer(0), n*sizeof(int));
+      break;
+    }
+
+  vtkIdType *cell = (piece->Type == vtkROIContourData::POINT ?
+                     ts->Verts : ts->Lines);
+  vtkWritePolyLineCell(cell + piece->CellOffset, id0, n, closed);
+}
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkROIContourDataToPolyDataThreadStruct::ThreadMain(
+  void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkROIContourDataToPolyDataThreadStruct *ts =
+    static_cast<vtkROIContourDataToPolyDataThreadStruct *>(info->UserData);
+
+  ts->Filter->ThreadedExecute(ts, info->ThreadID, info->NumberOfThreads);
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourDataToPolyData::ThreadedExecute(
+  vtkROIContourDataToPolyDataThreadStruct *ts, int threadId, int numThreads)
+{
+  // The contours are interleaved between the threads to balance the load
+  size_t n = ts->Pieces.size();
+  for (size_t k = threadId; k < n; k += numThreads)
+    {
+    if (ts->Pass == 0)
+      {
+      vtkCountContourPoints(ts, &ts->Pieces[k]);
+      }
+    else
+      {
+      vtkWriteContourPoints(ts, &ts->Pieces[k]);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourDataToPolyData::ParallelTessellate(
+  vtkROIContourData *input, vtkIdList *contourList, int numThreads,
+  vtkPoints *points, vtkCellArray **lines, vtkCellArray **verts,
+  vtkIntArray *contourIds, vtkIntArray *subIds)
+{
+  vtkROIContourDataToPolyDataThreadStruct ts;
+  ts.Filter = this;
+  ts.Cache = this->Cache;
+  ts.Subdivision = this->Subdivision;
+  ts.SubdivisionTarget = this->ActiveSubdivisionTarget;
+
+  // Get the points from the main thread, since views of packed points
+  // might have to be created
+  bool hasLines = false;
+  bool hasVerts = false;
+  int n = (contourList ? static_cast<int>(contourList->GetNumberOfIds()) :
+           input->GetNumberOfContours());
+  for (int k = 0; k < n; k++)
+    {
+    vtkROIContourDataToPolyDataThreadStruct::Piece piece;
+    piece.Contour = k;
+    if (contourList)
+      {
+      piece.Contour = static_cast<int>(contourList->GetId(k));
+      }
+    piece.Points = input->GetContourPoints(piece.Contour);
+    if (piece.Points)
+      {
+      piece.Type = input->GetContourType(piece.Contour);
+      piece.MTime = input->GetContourMTime(piece.Contour);
+      hasVerts |= (piece.Type == vtkROIContourData::POINT);
+      hasLines |= (piece.Type != vtkROIContourData::POINT);
+      ts.Pieces.push_back(piece);
+      }
+    }
+
+  this->Threader->SetNumberOfThreads(numThreads);
+  this->Threader->SetSingleMethod(
+    &vtkROIContourDataToPolyDataThreadStruct::ThreadMain, &ts);
+
+  // First pass: count the points for each contour
+  ts.Pass = 0;
+  this->Threader->SingleMethodExecute();
+
+  // Compute the offsets of each contour in the output arrays
+  vtkIdType numPoints = 0;
+  vtkIdType numLines = 0;
+  vtkIdType numVerts = 0;
+  vtkIdType lineSize = 0;
+  vtkIdType vertSize = 0;
+  for (size_t k = 0; k < ts.Pieces.size(); k++)
+    {
+    vtkROIContourDataToPolyDataThreadStruct::Piece *piece = &ts.Pieces[k];
+    if (piece->Method == vtkROIContourDataToPolyDataThreadStruct::SKIP)
+      {
+      continue;
+      }
+
+    vtkIdType m = piece->NumberOfPoints;
+    bool closed = (piece->Type == vtkROIContourData::CLOSED_PLANAR);
+    vtkIdType cellSize = m + closed + 1;
+    piece->PointOffset = numPoints;
+    numPoints += m;
+    if (piece->Type == vtkROIContourData::POINT)
+      {
+      piece->CellOffset = vertSize;
+      vertSize += cellSize;
+      numVerts++;
+      }
+    else
+      {
+      piece->CellOffset = lineSize;
+      lineSize += cellSize;
+      numLines++;
+      }
+    contourIds->InsertNextValue(piece->Contour);
+
+    if (piece->Method == vtkROIContourDataToPolyDataThreadStruct::SPLINE)
+      {
+      // Make space in the cache for the contour
+      vtkROIContourDataToPolyDataCache::Entry *e =
+        &this->Cache->Entries[piece->Contour];
+      e->Points = vtkSmartPointer<vtkPoints>::New();
+      e->Points->SetDataTypeToDouble();
+      e->Points->SetNumberOfPoints(m);
+      e->SubIds = vtkSmartPointer<vtkIntArray>::New();
+      e->SubIds->SetNumberOfValues(m);
+      vtkIdTypeArray *ids = vtkIdTypeArray::New();
+      ids->SetNumberOfValues(cellSize);
+      e->Lines = vtkSmartPointer<vtkCellArray>::New();
+      e->Lines->SetCells(1, ids);
+      ids->Delete();
+      }
+    }
+
+  // Allocate the output arrays
+  points->SetNumberOfPoints(numPoints);
+  subIds->SetNumberOfValues(numPoints);
+  ts.Points = static_cast<double *>(points->GetVoidPointer(0));
+  ts.SubIds = subIds->GetPointer(0);
+  ts.Lines = 0;
+  ts.Verts = 0;
+  if (hasLines)
+    {
+    vtkIdTypeArray *ids = vtkIdTypeArray::New();
+    ids->SetNumberOfValues(lineSize);
+    *lines = vtkCellArray::New();
+    (*lines)->SetCells(numLines, ids);
+    ts.Lines = ids->GetPointer(0);
+    ids->Delete();
+    }
+  if (hasVerts)
+    {
+    vtkIdTypeArray *ids = vtkIdTypeArray::New();
+    ids->SetNumberOfValues(vertSize);
+    *verts = vtkCellArray::New();
+    (*verts)->SetCells(numVerts, ids);
+    ts.Verts = ids->GetPointer(0);
+    ids->Delete();
+    }
+
+  // Second pass: write the contours into the output
+  ts.Pass = 1;
+  this->Threader->SingleMethodExecute();
+}
+
 //----------------------------------------------------------------------------
 int vtkROIContourDataToPolyData::RequestData(
   vtkInformation *vtkNotUsed(request),
@@ -538,36 +1205,54 @@ int vtkROIContourDataToPolyData::RequestData(
   vtkIntArray *contourSubIds = vtkIntArray::New();
   contourSubIds->SetName("SubIds");
 
-  // Go through all the contours
+  // Get the target segment length, which might depend on the view
+  this->ActiveSubdivisionTarget = this->ComputeSubdivisionTarget();
+
+  // Throw away the cache if the subdivision settings have changed
+  vtkROIContourDataToPolyDataCache *cache = this->Cache;
+  if (!this->Subdivision ||
+      cache->SubdivisionTarget != this->ActiveSubdivisionTarget ||
+      cache->Spline != this->Spline ||
+      (this->Spline && cache->SplineMTime != this->Spline->GetMTime()))
+    {
+    cache->Entries.clear();
+    cache->SubdivisionTarget = this->ActiveSubdivisionTarget;
+    cache->Spline = this->Spline;
+    cache->SplineMTime = (this->Spline ? this->Spline->GetMTime() : 0);
+    }
+  cache->Entries.resize(static_cast<size_t>(input->GetNumberOfContours()));
+
+  // Use the contour index to find the contours near the plane
+  vtkIdList *contourList = 0;
   int n = input->GetNumberOfContours();
-  for (int i = 0; i < n; i++)
+  if (plane)
     {
-    vtkPoints *points = input->GetContourPoints(i);
-    int t = input->GetContourType(i);
+    contourList = vtkIdList::New();
+    input->FindContoursNearPlane(plane, tol, contourList);
+    n = static_cast<int>(contourList->GetNumberOfIds());
+    }
 
-    if (points)
+  // Use several threads if there are several contours, unless there is
+  // a vtkSpline, since it cannot be used by more than one thread
+  int numThreads = (this->NumberOfThreads < n ? this->NumberOfThreads : n);
+  if (numThreads > 1 && !(this->Subdivision && this->Spline))
+    {
+    this->ParallelTessellate(input, contourList, numThreads, outPoints,
+                             &lines, &verts, contourIds, contourSubIds);
+    }
+  else
+    {
+    // Go through all the contours
+    for (int k = 0; k < n; k++)
       {
-      vtkIdType m = points->GetNumberOfPoints();
-      bool includeContour = true;
+      int i = (contourList ? static_cast<int>(contourList->GetId(k)) : k);
+      vtkPoints *points = input->GetContourPoints(i);
+      int t = input->GetContourType(i);
 
-      if (plane)
+      if (points)
         {
-        for (int j = 0; j < m; j++)
-          {
-          double p[3];
-          points->GetPoint(j, p);
-          double d = plane->DistanceToPlane(p);
-          if (d < -tol || d > tol)
-            {
-            includeContour = false;
-            break;
-            }
-          }
-        }
+        vtkIdType m = points->GetNumberOfPoints();
 
-      // Include this contour in the output
-      if (includeContour)
-        {
         bool closed = false;
         vtkCellArray *cells = 0;
         if (t == vtkROIContourData::POINT)
@@ -599,16 +1284,8 @@ int vtkROIContourDataToPolyData::RequestData(
         if (this->Subdivision && m > 2 && t != vtkROIContourData::POINT)
           {
           // Use a spline to subdivide and smooth contour
-          if (this->Spline)
-            {
-            success = this->GenerateSpline(
-              points, closed, outPoints, lines, contourSubIds);
-            }
-          else
-            {
-            success = this->CatmullRomSpline(
-              points, closed, outPoints, lines, contourSubIds);
-            }
+          success = this->SubdivideContour(
+            input, i, outPoints, lines, contourSubIds);
           }
         else if (m > 0)
           {
@@ -658,6 +1335,11 @@ int vtkROIContourDataToPolyData::RequestData(
       }
     }
 
+  if (contourList)
+    {
+    contourList->Delete();
+    }
+
   output->SetPoints(outPoints);
   output->SetLines(lines);
   output->SetVerts(verts);
@@ -17,12 +17,16 @@
 // vtkPolyData consisting of verts and lines.  The resulting polydata will
 // have integer cell scalars called "Labels" to identify of the contour that
 // they originated from, and will have integer point scalars called "SubIds"
-// to indicate which line segment they correspond to.
+// to indicate which line segment they correspond to.  When subdivision
+// is on, the subdivided contours are cached, and on each execution only
+// the contours that have changed are subdivided again.
 
 #ifndef __vtkROIContourDataToPolyData_h
 #define __vtkROIContourDataToPolyData_h
 
 #include "vtkPolyDataAlgorithm.h"
+#include "vtkMultiThreader.h" // for VTK_MAX_THREADS
+#include "vtkWeakPointer.h" // for Renderer
 
 class vtkROIContourData;
 class vtkPlane;
@@ -31,6 +35,10 @@ class vtkPoints;
 class vtkCellArray;
 class vtkDoubleArray;
 class vtkIntArray;
+class vtkIdList;
+class vtkRenderer;
+class vtkROIContourDataToPolyDataCache;
+class vtkROIContourDataToPolyDataThreadStruct;
 
 class VTK_EXPORT vtkROIContourDataToPolyData : public vtkPolyDataAlgorithm
 {
@@ -63,11 +71,55 @@ public:
   vtkSetMacro(SubdivisionTarget, double);
   vtkGetMacro(SubdivisionTarget, double);
 
+  // Description:
+  // Make the subdivision depend on the view.  Set this to the size of a
+  // screen pixel, in the same units as the contours, and the segments
+  // will be about SubdivisionPixels pixels long instead of having the
+  // length SubdivisionTarget.  The segment length is rounded to a power
+  // of two, so that small changes in zoom do not cause the contours to
+  // be subdivided again.  The default is zero, which means Off.
+  vtkSetMacro(PixelSize, double);
+  vtkGetMacro(PixelSize, double);
+
+  // Description:
+  // Get the pixel size from this renderer's camera and viewport, at the
+  // camera's focal point.  The pixel size is checked every time that the
+  // filter is updated, so the subdivision will follow the zoom.  Only a
+  // weak reference to the renderer is kept, so it becomes NULL when the
+  // renderer is destroyed.
+  void SetRenderer(vtkRenderer *renderer);
+  vtkRenderer *GetRenderer();
+
+  // Description:
+  // The target segment length in pixels, when the subdivision depends
+  // on the view.  The default is 4.
+  vtkSetMacro(SubdivisionPixels, double);
+  vtkGetMacro(SubdivisionPixels, double);
+
   // Description:
   // Specify an instance of vtkSpline to use to perform the subdivision.
   virtual void SetSpline(vtkSpline *spline);
   vtkSpline *GetSpline() { return this->Spline; }
 
+  // Description:
+  // The number of threads to use.  The contours are done in two passes:
+  // first the number of points for each contour is computed, and then
+  // each contour is written directly into the output.  The output is the
+  // same as with a single thread.  Only one thread is used if a vtkSpline
+  // has been set.  The default is the number of processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
+  // Description:
+  // Subdivide a contour with the Catmull-Rom spline that is used when
+  // no vtkSpline has been set.  The new points are stored in the array
+  // as x,y,z triples, and the number of points is returned, or zero if
+  // the contour has fewer than two points.  This can be called from
+  // several threads at once.
+  static vtkIdType SubdivideWithCatmullRom(
+    vtkPoints *contourPoints, int closed, double target,
+    vtkDoubleArray *points);
+
 protected:
   vtkROIContourDataToPolyData();
   ~vtkROIContourDataToPolyData();
@@ -83,6 +135,10 @@ protected:
 
   virtual int FillInputPortInformation(int port, vtkInformation *info);
 
+  // Description:
+  // Get the target segment length, using the view if there is one.
+  double ComputeSubdivisionTarget();
+
   void ComputeSpline(
     vtkPoints *points, bool closed, double &tmax, double &dmax);
 
@@ -94,10 +150,36 @@ protected:
     vtkPoints *contourPoints, bool closed,
     vtkPoints *points, vtkCellArray *lines, vtkIntArray *subIds);
 
+  // Description:
+  // Subdivide a contour and append it to the output, using the cached
+  // subdivision if the contour has not changed since it was cached.
+  bool SubdivideContour(
+    vtkROIContourData *data, int contour,
+    vtkPoints *points, vtkCellArray *lines, vtkIntArray *subIds);
+
+  // Description:
+  // Convert the contours with several threads.  The output cell arrays
+  // are created if there are contours that need them.
+  void ParallelTessellate(
+    vtkROIContourData *input, vtkIdList *contourList, int numThreads,
+    vtkPoints *points, vtkCellArray **lines, vtkCellArray **verts,
+    vtkIntArray *contourIds, vtkIntArray *subIds);
+
+  // Description:
+  // Convert the contours that belong to the given thread.
+  void ThreadedExecute(vtkROIContourDataToPolyDataThreadStruct *ts,
+                       int threadId, int numThreads);
+
+  friend class vtkROIContourDataToPolyDataThreadStruct;
+
   vtkPlane *SelectionPlane;
   double SelectionPlaneTolerance;
   int Subdivision;
   double SubdivisionTarget;
+  double PixelSize;
+  double SubdivisionPixels;
+  vtkWeakPointer<vtkRenderer> Renderer;
+  double ActiveSubdivisionTarget;
   vtkSpline *Spline;
 
   vtkSpline *SplineX;
@@ -105,6 +187,11 @@ protected:
   vtkSpline *SplineZ;
   vtkDoubleArray *KnotPositions;
 
+  vtkROIContourDataToPolyDataCache *Cache;
+
+  int NumberOfThreads;
+  vtkMultiThreader *Threader;
+
 private:
   vtkROIContourDataToPolyData(const vtkROIContourDataToPolyData&);  // Not implemented.
   void operator=(const vtkROIContourDataToPolyData&);  // Not implemented.
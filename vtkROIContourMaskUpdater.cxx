@@ -0,0 +1,452 @@
+/*=========================================================================
+
+  Program:   ToolCursor
+  Module:    vtkROIContourMaskUpdater.cxx
+
+  Copyright (c) 2010 David Gobbi
+  All rights reserved.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkROIContourMaskUpdater.h"
+
+#include "vtkROIContourData.h"
+#include "vtkROIContourDataToImageStencil.h"
+#include "vtkImageStencilData.h"
+#include "vtkImageData.h"
+#include "vtkPoints.h"
+#include "vtkIdList.h"
+#include "vtkMath.h"
+#include "vtkObjectFactory.h"
+
+#include <vector>
+#include <map>
+
+vtkStandardNewMacro(vtkROIContourMaskUpdater);
+vtkCxxSetObjectMacro(vtkROIContourMaskUpdater,ROIContourData,vtkROIContourData);
+vtkCxxSetObjectMacro(vtkROIContourMaskUpdater,Stencil,vtkImageStencilData);
+vtkCxxSetObjectMacro(vtkROIContourMaskUpdater,Image,vtkImageData);
+
+//----------------------------------------------------------------------------
+// The state of each contour at the last update, and the slice that the
+// contour was on, so that the slice can be cleared if the contour is
+// moved or removed.  The contours are keyed by their points rather than
+// by their index, since removing a contour changes the indices of all
+// the contours that follow it.
+class vtkROIContourMaskUpdaterCache
+{
+public:
+  struct Entry
+  {
+    unsigned long MTime;
+    vtkIdType NumberOfPoints;
+    int Type;
+    int Slice;
+    bool Seen;
+  };
+
+  typedef std::map<vtkPoints *, Entry> EntryMap;
+
+  EntryMap Entries;
+  std::vector<int> Slices;
+  std::vector<int> ModifiedSlices;
+};
+
+//----------------------------------------------------------------------------
+vtkROIContourMaskUpdater::vtkROIContourMaskUpdater()
+{
+  this->ROIContourData = 0;
+  this->Stencil = 0;
+  this->Image = 0;
+  this->LabelValue = 1.0;
+  this->BackgroundValue = 0.0;
+  this->Subdivision = 0;
+  this->SubdivisionTarget = 1.0;
+
+  for (int i = 0; i < 3; i++)
+    {
+    this->UpdatedExtent[2*i] = 0;
+    this->UpdatedExtent[2*i+1] = -1;
+    this->Extent[2*i] = 0;
+    this->Extent[2*i+1] = -1;
+    this->Spacing[i] = 1.0;
+    this->Origin[i] = 0.0;
+    }
+
+  this->Cache = new vtkROIContourMaskUpdaterCache;
+}
+
+//----------------------------------------------------------------------------
+vtkROIContourMaskUpdater::~vtkROIContourMaskUpdater()
+{
+  if (this->ROIContourData)
+    {
+    this->ROIContourData->Delete();
+    }
+  if (this->Stencil)
+    {
+    this->Stencil->Delete();
+    }
+  if (this->Image)
+    {
+    this->Image->Delete();
+    }
+  delete this->Cache;
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourMaskUpdater::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "ROIContourData: " << this->ROIContourData << "\n";
+  os << indent << "Stencil: " << this->Stencil << "\n";
+  os << indent << "Image: " << this->Image << "\n";
+  os << indent << "LabelValue: " << this->LabelValue << "\n";
+  os << indent << "BackgroundValue: " << this->BackgroundValue << "\n";
+  os << indent << "Subdivision: " << (this->Subdivision ? "On\n" : "Off\n");
+  os << indent << "SubdivisionTarget: " << this->SubdivisionTarget << "\n";
+  os << indent << "UpdatedExtent: " << this->UpdatedExtent[0] << " "
+     << this->UpdatedExtent[1] << " " << this->UpdatedExtent[2] << " "
+     << this->UpdatedExtent[3] << " " << this->UpdatedExtent[4] << " "
+     << this->UpdatedExtent[5] << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourMaskUpdater::SliceModified(int zIdx)
+{
+  this->Cache->ModifiedSlices.push_back(zIdx);
+}
+
+//----------------------------------------------------------------------------
+namespace {
+
+// Set the voxels of one slice of an image, where the stencil is inside
+// the voxels are set to the label, and where it is outside the voxels
+// that have the label are set to the background.
+template<class T>
+void vtkROIContourMaskUpdaterFillSlice(
+  vtkImageData *image, T *ptr, vtkImageStencilData *stencil, int zIdx,
+  T label, T background)
+{
+  int extent[6];
+  image->GetExtent(extent);
+  vtkIdType *increments = image->GetIncrements();
+  vtkIdType xInc = increments[0];
+
+  for (int yIdx = extent[2]; yIdx <= extent[3]; yIdx++)
+    {
+    T *rowPtr = ptr + (yIdx - extent[2])*increments[1];
+    int xIdx = extent[0];
+    int r1, r2;
+    int iter = 0;
+    while (stencil->GetNextExtent(
+             r1, r2, extent[0], extent[1], yIdx, zIdx, iter))
+      {
+      for (; xIdx < r1; xIdx++)
+        {
+        T *vptr = rowPtr + (xIdx - extent[0])*xInc;
+        if (*vptr == label)
+          {
+          *vptr = background;
+          }
+        }
+      for (; xIdx <= r2; xIdx++)
+        {
+        rowPtr[(xIdx - extent[0])*xInc] = label;
+        }
+      }
+    for (; xIdx <= extent[1]; xIdx++)
+      {
+      T *vptr = rowPtr + (xIdx - extent[0])*xInc;
+      if (*vptr == label)
+        {
+        *vptr = background;
+        }
+      }
+    }
+}
+
+} // end anonymous namespace
+
+//----------------------------------------------------------------------------
+void vtkROIContourMaskUpdater::UpdateImageSlice(
+  vtkImageStencilData *stencil, int zIdx)
+{
+  vtkImageData *image = this->Image;
+  int extent[6];
+  image->GetExtent(extent);
+
+  void *ptr = image->GetScalarPointer(extent[0], extent[2], zIdx);
+  if (!ptr)
+    {
+    vtkErrorMacro("UpdateImageSlice: the image has no scalars");
+    return;
+    }
+
+  switch (image->GetScalarType())
+    {
+    vtkTemplateMacro(
+      vtkROIContourMaskUpdaterFillSlice(
+        image, static_cast<VTK_TT *>(ptr), stencil, zIdx,
+        static_cast<VTK_TT>(this->LabelValue),
+        static_cast<VTK_TT>(this->BackgroundValue)));
+    default:
+      vtkErrorMacro("UpdateImageSlice: unknown scalar type");
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourMaskUpdater::Update()
+{
+  int *updatedExtent = this->UpdatedExtent;
+  updatedExtent[0] = updatedExtent[2] = updatedExtent[4] = 0;
+  updatedExtent[1] = updatedExtent[3] = updatedExtent[5] = -1;
+
+  vtkROIContourData *data = this->ROIContourData;
+  if (!data || (!this->Stencil && !this->Image))
+    {
+    return;
+    }
+
+  // Get the geometry of the mask
+  int extent[6];
+  double spacing[3];
+  double origin[3];
+  if (this->Image)
+    {
+    this->Image->GetExtent(extent);
+    this->Image->GetSpacing(spacing);
+    this->Image->GetOrigin(origin);
+    }
+  else
+    {
+    this->Stencil->GetExtent(extent);
+    this->Stencil->GetSpacing(spacing);
+    this->Stencil->GetOrigin(origin);
+    }
+
+  int numSlices = extent[5] - extent[4] + 1;
+  if (numSlices <= 0 || extent[1] < extent[0] || extent[3] < extent[2])
+    {
+    return;
+    }
+
+  // Convert every slice if the settings or the geometry have changed
+  vtkROIContourMaskUpdaterCache *cache = this->Cache;
+  bool rebuild = (this->GetMTime() > this->UpdateTime.GetMTime());
+  for (int i = 0; i < 3; i++)
+    {
+    rebuild |= (extent[2*i] != this->Extent[2*i] ||
+                extent[2*i+1] != this->Extent[2*i+1] ||
+                spacing[i] != this->Spacing[i] ||
+                origin[i] != this->Origin[i]);
+    this->Extent[2*i] = extent[2*i];
+    this->Extent[2*i+1] = extent[2*i+1];
+    this->Spacing[i] = spacing[i];
+    this->Origin[i] = origin[i];
+    }
+  if (rebuild)
+    {
+    cache->Entries.clear();
+    }
+
+  // The slices are stored relative to the first slice, and -1 is used
+  // for contours that are not on any slice
+  std::vector<char> dirty(static_cast<size_t>(numSlices), rebuild);
+  for (size_t j = 0; j < cache->ModifiedSlices.size(); j++)
+    {
+    int zIdx = cache->ModifiedSlices[j];
+    if (zIdx >= extent[4] && zIdx <= extent[5])
+      {
+      dirty[zIdx - extent[4]] = 1;
+      }
+    }
+  cache->ModifiedSlices.clear();
+
+  // Any cached contour that is not seen again has been removed
+  vtkROIContourMaskUpdaterCache::EntryMap::iterator iter;
+  for (iter = cache->Entries.begin(); iter != cache->Entries.end(); ++iter)
+    {
+    iter->second.Seen = false;
+    }
+
+  // A contour that has changed makes both its old slice and its new
+  // slice dirty
+  int numContours = data->GetNumberOfContours();
+  cache->Slices.assign(static_cast<size_t>(numContours), -1);
+  for (int i = 0; i < numContours; i++)
+    {
+    // Get the points first, since making a view of packed points will
+    // change the modification time of the contour
+    vtkPoints *points = data->GetContourPoints(i);
+    if (!points)
+      {
+      continue;
+      }
+    unsigned long mtime = data->GetContourMTime(i);
+    vtkIdType numPoints = points->GetNumberOfPoints();
+    int type = data->GetContourType(i);
+
+    vtkROIContourMaskUpdaterCache::Entry entry;
+    entry.MTime = 0;
+    entry.NumberOfPoints = 0;
+    entry.Type = -1;
+    entry.Slice = -1;
+    entry.Seen = false;
+    iter = cache->Entries.insert(std::make_pair(points, entry)).first;
+    vtkROIContourMaskUpdaterCache::Entry *e = &iter->second;
+
+    // If two contours share the same points, the second one is always
+    // treated as changed
+    if (!e->Seen && e->MTime == mtime && e->NumberOfPoints == numPoints &&
+        e->Type == type)
+      {
+      e->Seen = true;
+      cache->Slices[i] = e->Slice;
+      continue;
+      }
+
+    if (e->Slice >= 0)
+      {
+      dirty[e->Slice] = 1;
+      }
+
+    int slice = -1;
+    if (numPoints >= 2 && type == vtkROIContourData::CLOSED_PLANAR)
+      {
+      double bounds[6];
+      data->GetContourBounds(i, bounds);
+      double z = 0.5*(bounds[4] + bounds[5]);
+      int zIdx = vtkMath::Floor((z - origin[2])/spacing[2] + 0.5);
+      if (zIdx >= extent[4] && zIdx <= extent[5])
+        {
+        slice = zIdx - extent[4];
+        dirty[slice] = 1;
+        }
+      }
+
+    e->MTime = mtime;
+    e->NumberOfPoints = numPoints;
+    e->Type = type;
+    e->Slice = slice;
+    e->Seen = true;
+    cache->Slices[i] = slice;
+    }
+
+  // Contours that were removed leave their slices dirty
+  iter = cache->Entries.begin();
+  while (iter != cache->Entries.end())
+    {
+    if (iter->second.Seen)
+      {
+      ++iter;
+      }
+    else
+      {
+      if (iter->second.Slice >= 0)
+        {
+        dirty[iter->second.Slice] = 1;
+        }
+      cache->Entries.erase(iter++);
+      }
+    }
+
+  // Without a stencil, each slice is converted into a scratch stencil
+  // that is then used to set the voxels of the image
+  vtkImageStencilData *stencil = this->Stencil;
+  vtkImageStencilData *sliceStencil = 0;
+  if (!stencil)
+    {
+    sliceStencil = vtkImageStencilData::New();
+    sliceStencil->SetSpacing(spacing);
+    sliceStencil->SetOrigin(origin);
+    }
+
+  vtkIdList *contourIds = vtkIdList::New();
+  int zMin = extent[5] + 1;
+  int zMax = extent[4] - 1;
+
+  for (int slice = 0; slice < numSlices; slice++)
+    {
+    if (!dirty[slice])
+      {
+      continue;
+      }
+
+    int zIdx = slice + extent[4];
+    zMin = (zIdx < zMin ? zIdx : zMin);
+    zMax = (zIdx > zMax ? zIdx : zMax);
+
+    contourIds->Reset();
+    for (int i = 0; i < numContours; i++)
+      {
+      if (cache->Slices[i] == slice)
+        {
+        contourIds->InsertNextId(i);
+        }
+      }
+
+    if (stencil)
+      {
+      for (int yIdx = extent[2]; yIdx <= extent[3]; yIdx++)
+        {
+        stencil->RemoveExtent(extent[0], extent[1], yIdx, zIdx);
+        }
+      vtkROIContourDataToImageStencil::ConvertSlice(
+        data, contourIds, stencil, zIdx,
+        this->Subdivision, this->SubdivisionTarget);
+      if (this->Image)
+        {
+        this->UpdateImageSlice(stencil, zIdx);
+        }
+      }
+    else
+      {
+      int sliceExtent[6];
+      sliceExtent[0] = extent[0];
+      sliceExtent[1] = extent[1];
+      sliceExtent[2] = extent[2];
+      sliceExtent[3] = extent[3];
+      sliceExtent[4] = zIdx;
+      sliceExtent[5] = zIdx;
+      sliceStencil->SetExtent(sliceExtent);
+      sliceStencil->AllocateExtents();
+      vtkROIContourDataToImageStencil::ConvertSlice(
+        data, contourIds, sliceStencil, zIdx,
+        this->Subdivision, this->SubdivisionTarget);
+      this->UpdateImageSlice(sliceStencil, zIdx);
+      }
+    }
+
+  contourIds->Delete();
+  if (sliceStencil)
+    {
+    sliceStencil->Delete();
+    }
+
+  // Only modify the mask if something was changed
+  if (zMin <= zMax)
+    {
+    updatedExtent[0] = extent[0];
+    updatedExtent[1] = extent[1];
+    updatedExtent[2] = extent[2];
+    updatedExtent[3] = extent[3];
+    updatedExtent[4] = zMin;
+    updatedExtent[5] = zMax;
+
+    if (this->Stencil)
+      {
+      this->Stencil->Modified();
+      }
+    if (this->Image)
+      {
+      this->Image->Modified();
+      }
+    }
+
+  this->UpdateTime.Modified();
+}
@@ -0,0 +1,132 @@
+/*=========================================================================
+
+  Program:   ToolCursor
+  Module:    vtkROIContourMaskUpdater.h
+
+  Copyright (c) 2010 David Gobbi
+  All rights reserved.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkROIContourMaskUpdater - Keep a mask up to date with contours
+// .SECTION Description
+// This class keeps an existing stencil or label image in step with the
+// contours of a vtkROIContourData while the contours are being edited.
+// Each time Update() is called, the modification time and the number of
+// points of every contour are checked, and only the slices whose contours
+// have changed are converted again.  The contours are recognized by their
+// vtkPoints, so removing a contour only affects the slice that it was on.
+// Slices can also be marked for conversion with SliceModified().
+// The stencil and the image must already be allocated, and if both are
+// set then they must have the same geometry.  In the image, the voxels
+// inside the contours are set to LabelValue, and voxels outside of the
+// contours that have the LabelValue are set to the BackgroundValue, so
+// that other labels in the image are not disturbed.  After the update,
+// GetUpdatedExtent() gives the sub-extent that was changed.
+// .SECTION See Also
+// vtkROIContourDataToImageStencil
+
+#ifndef __vtkROIContourMaskUpdater_h
+#define __vtkROIContourMaskUpdater_h
+
+#include "vtkObject.h"
+
+class vtkROIContourData;
+class vtkImageStencilData;
+class vtkImageData;
+class vtkROIContourMaskUpdaterCache;
+
+class VTK_EXPORT vtkROIContourMaskUpdater : public vtkObject
+{
+public:
+  static vtkROIContourMaskUpdater *New();
+  vtkTypeMacro(vtkROIContourMaskUpdater,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // The contours that the mask is made from.
+  void SetROIContourData(vtkROIContourData *data);
+  vtkGetObjectMacro(ROIContourData, vtkROIContourData);
+
+  // Description:
+  // A stencil to keep up to date.  Its extents must be allocated.
+  void SetStencil(vtkImageStencilData *stencil);
+  vtkGetObjectMacro(Stencil, vtkImageStencilData);
+
+  // Description:
+  // A label image to keep up to date.  Its scalars must be allocated.
+  void SetImage(vtkImageData *image);
+  vtkGetObjectMacro(Image, vtkImageData);
+
+  // Description:
+  // The value for voxels inside the contours.  The default is 1.
+  vtkSetMacro(LabelValue, double);
+  vtkGetMacro(LabelValue, double);
+
+  // Description:
+  // The value for voxels that are no longer inside the contours.
+  // The default is 0.
+  vtkSetMacro(BackgroundValue, double);
+  vtkGetMacro(BackgroundValue, double);
+
+  // Description:
+  // Smooth the contours with a Catmull-Rom spline, in the same way as
+  // vtkROIContourDataToImageStencil.  The default is Off.
+  vtkSetMacro(Subdivision, int);
+  vtkBooleanMacro(Subdivision, int);
+  vtkGetMacro(Subdivision, int);
+
+  // Description:
+  // The target segment length for subdivision.  The default is 1.0.
+  vtkSetMacro(SubdivisionTarget, double);
+  vtkGetMacro(SubdivisionTarget, double);
+
+  // Description:
+  // Force the given slice to be converted at the next Update().  This
+  // is only needed if the contours were changed in a way that does not
+  // change their modification times.
+  void SliceModified(int zIdx);
+
+  // Description:
+  // Convert the slices that have changed since the last update.  The
+  // first update, or the first one after the settings or the geometry
+  // of the mask have changed, will convert all of the slices.
+  void Update();
+
+  // Description:
+  // The extent that was changed by the last Update().  The extent will
+  // be empty if nothing was changed.
+  vtkGetVector6Macro(UpdatedExtent, int);
+
+protected:
+  vtkROIContourMaskUpdater();
+  ~vtkROIContourMaskUpdater();
+
+  // Description:
+  // Set the voxels of one slice of the image from a stencil.
+  void UpdateImageSlice(vtkImageStencilData *stencil, int zIdx);
+
+  vtkROIContourData *ROIContourData;
+  vtkImageStencilData *Stencil;
+  vtkImageData *Image;
+  double LabelValue;
+  double BackgroundValue;
+  int Subdivision;
+  double SubdivisionTarget;
+  int UpdatedExtent[6];
+
+  int Extent[6];
+  double Spacing[3];
+  double Origin[3];
+  vtkTimeStamp UpdateTime;
+  vtkROIContourMaskUpdaterCache *Cache;
+
+private:
+  vtkROIContourMaskUpdater(const vtkROIContourMaskUpdater&);  // Not implemented.
+  void operator=(const vtkROIContourMaskUpdater&);  // Not implemented.
+};
+
+#endif
@@ -0,0 +1,178 @@
+/*=========================================================================
+
+  Program:   ToolCursor
+  Module:    vtkROIContourScanConverter.cxx
+
+  Copyright (c) 2010 David Gobbi
+  All rights reserved.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkROIContourScanConverter.h"
+#include "vtkObjectFactory.h"
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+vtkStandardNewMacro(vtkROIContourScanConverter);
+
+//----------------------------------------------------------------------------
+// The x positions where the polygons cross each sample line.
+class vtkROIContourScanConverterLines
+{
+public:
+  std::vector<std::vector<double> > Crossings;
+};
+
+//----------------------------------------------------------------------------
+vtkROIContourScanConverter::vtkROIContourScanConverter()
+{
+  for (int k = 0; k < 3; k++)
+    {
+    this->Extent[2*k] = 0;
+    this->Extent[2*k+1] = -1;
+    }
+  this->SamplesPerRow = 1;
+  this->Lines = new vtkROIContourScanConverterLines;
+}
+
+//----------------------------------------------------------------------------
+vtkROIContourScanConverter::~vtkROIContourScanConverter()
+{
+  delete this->Lines;
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourScanConverter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Extent: " << this->Extent[0] << " "
+     << this->Extent[1] << " " << this->Extent[2] << " "
+     << this->Extent[3] << " " << this->Extent[4] << " "
+     << this->Extent[5] << "\n";
+  os << indent << "SamplesPerRow: " << this->SamplesPerRow << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourScanConverter::Initialize(
+  const int extent[6], int samplesPerRow)
+{
+  for (int k = 0; k < 6; k++)
+    {
+    this->Extent[k] = extent[k];
+    }
+  this->SamplesPerRow = (samplesPerRow > 1 ? samplesPerRow : 1);
+
+  int numRows = extent[3] - extent[2] + 1;
+  numRows = (extent[1] < extent[0] || numRows < 0 ? 0 : numRows);
+  std::vector<std::vector<double> > *lines = &this->Lines->Crossings;
+  for (size_t q = 0; q < lines->size(); q++)
+    {
+    (*lines)[q].clear();
+    }
+  lines->resize(static_cast<size_t>(numRows*this->SamplesPerRow));
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourScanConverter::AddPolygon(
+  const double *xy, vtkIdType n, int *rowMin, int *rowMax)
+{
+  std::vector<std::vector<double> > *lines = &this->Lines->Crossings;
+  int numLines = static_cast<int>(lines->size());
+  if (n < 2 || numLines == 0)
+    {
+    return;
+    }
+
+  // Sample line q is at y = extent[2] - 0.5 + (q + 0.5)/samples, so with
+  // one sample per row, line q is at the center of row extent[2] + q
+  const int *extent = this->Extent;
+  int samples = this->SamplesPerRow;
+  double f = samples;
+  double g = (0.5 - extent[2])*f - 0.5;
+
+  double x0 = xy[2*(n - 1)];
+  double y0 = xy[2*(n - 1) + 1];
+
+  for (vtkIdType j = 0; j < n; j++)
+    {
+    double x1 = xy[2*j];
+    double y1 = xy[2*j + 1];
+
+    double qa = (y0 < y1 ? y0 : y1)*f + g;
+    double qb = (y0 < y1 ? y1 : y0)*f + g;
+    if (qa != qb && qa <= numLines - 1 && qb > 0)
+      {
+      int q1 = (qa < 0 ? 0 : static_cast<int>(ceil(qa)));
+      int q2 = (qb > numLines - 1 ? numLines - 1 :
+                static_cast<int>(ceil(qb)) - 1);
+      double s = (x1 - x0)/(y1 - y0);
+      for (int q = q1; q <= q2; q++)
+        {
+        double y = extent[2] - 0.5 + (q + 0.5)/f;
+        (*lines)[q].push_back(x0 + (y - y0)*s);
+        }
+      if (q1 <= q2)
+        {
+        int r1 = extent[2] + q1/samples;
+        int r2 = extent[2] + q2/samples;
+        *rowMin = (r1 < *rowMin ? r1 : *rowMin);
+        *rowMax = (r2 > *rowMax ? r2 : *rowMax);
+        }
+      }
+
+    x0 = x1;
+    y0 = y1;
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkROIContourScanConverter::GetNextSpan(
+  int yIdx, int sample, int &iter, double &x1, double &x2)
+{
+  int q = (yIdx - this->Extent[2])*this->SamplesPerRow + sample;
+  std::vector<double> *line = &this->Lines->Crossings[q];
+  if (iter == 0)
+    {
+    std::sort(line->begin(), line->end());
+    }
+
+  // An odd crossing at the end, from an unclosed polygon, is ignored
+  size_t k = 2*static_cast<size_t>(iter);
+  if (k + 1 >= line->size())
+    {
+    line->clear();
+    return 0;
+    }
+
+  x1 = (*line)[k];
+  x2 = (*line)[k+1];
+  iter++;
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkROIContourScanConverter::GetNextExtent(
+  int yIdx, int &iter, int &r1, int &r2)
+{
+  const int *extent = this->Extent;
+  double x1, x2;
+  while (this->GetNextSpan(yIdx, 0, iter, x1, x2))
+    {
+    if (x1 <= extent[1] && x2 >= extent[0])
+      {
+      r1 = (x1 < extent[0] ? extent[0] : static_cast<int>(ceil(x1)));
+      r2 = (x2 > extent[1] ? extent[1] : static_cast<int>(floor(x2)));
+      if (r1 <= r2)
+        {
+        return 1;
+        }
+      }
+    }
+  return 0;
+}
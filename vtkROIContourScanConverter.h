@@ -0,0 +1,81 @@
+/*=========================================================================
+
+  Program:   ToolCursor
+  Module:    vtkROIContourScanConverter.h
+
+  Copyright (c) 2010 David Gobbi
+  All rights reserved.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkROIContourScanConverter - Scan-convert polygons on a slice
+// .SECTION Description
+// This class finds where the edges of closed polygons cross the rows of
+// one slice of an image, and gives the spans that are inside by the
+// even-odd rule, so that polygons inside other polygons become holes.
+// The polygons are given in the structured x,y coordinates of the image.
+// Each row can be sampled by several lines, for filters that compute how
+// much of each voxel is inside.  The scratch space is kept from one slice
+// to the next, so each thread should have its own scan converter.
+
+#ifndef __vtkROIContourScanConverter_h
+#define __vtkROIContourScanConverter_h
+
+#include "vtkObject.h"
+
+class vtkROIContourScanConverterLines;
+
+class VTK_EXPORT vtkROIContourScanConverter : public vtkObject
+{
+public:
+  static vtkROIContourScanConverter *New();
+  vtkTypeMacro(vtkROIContourScanConverter,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Set the extent of the slice, and the number of sample lines across
+  // each row.  With one sample per row, the sample line goes through the
+  // centers of the voxels.  With n samples, sample line s of a row is
+  // at (s + 0.5)/n - 0.5 from the center of the row.  This also removes
+  // all of the crossings.
+  void Initialize(const int extent[6], int samplesPerRow);
+  int GetSamplesPerRow() { return this->SamplesPerRow; }
+
+  // Description:
+  // Add a closed polygon given as n x,y pairs, and expand the row range
+  // to include the rows that it crosses.  Each edge includes its lower
+  // end but not its upper end, so that a vertex that joins two edges is
+  // only counted once.
+  void AddPolygon(const double *xy, vtkIdType n, int *rowMin, int *rowMax);
+
+  // Description:
+  // Get the spans from one sample line of a row, in order of increasing
+  // x.  Set iter to zero to get the first span, and it will be advanced
+  // for each span.  After the last span, zero is returned and the
+  // crossings for the sample line are removed.
+  int GetNextSpan(int yIdx, int sample, int &iter, double &x1, double &x2);
+
+  // Description:
+  // Get the voxels with centers inside the spans of a row, clipped to
+  // the extent, for a scan converter with one sample per row.  Spans
+  // that have no voxel centers are skipped, and the crossings for the
+  // row are removed after the last span.
+  int GetNextExtent(int yIdx, int &iter, int &r1, int &r2);
+
+protected:
+  vtkROIContourScanConverter();
+  ~vtkROIContourScanConverter();
+
+  int Extent[6];
+  int SamplesPerRow;
+  vtkROIContourScanConverterLines *Lines;
+
+private:
+  vtkROIContourScanConverter(const vtkROIContourScanConverter&);  // Not implemented.
+  void operator=(const vtkROIContourScanConverter&);  // Not implemented.
+};
+
+#endif
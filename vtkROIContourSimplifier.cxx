@@ -0,0 +1,286 @@
+/*=========================================================================
+
+  Program:   ToolCursor
+  Module:    vtkROIContourSimplifier.cxx
+
+  Copyright (c) 2010 David Gobbi
+  All rights reserved.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkROIContourSimplifier.h"
+#include "vtkROIContourData.h"
+#include "vtkPoints.h"
+#include "vtkIdTypeArray.h"
+#include "vtkObjectFactory.h"
+
+#include <vector>
+#include <queue>
+
+vtkStandardNewMacro(vtkROIContourSimplifier);
+
+//----------------------------------------------------------------------------
+vtkROIContourSimplifier::vtkROIContourSimplifier()
+{
+  this->Tolerance = 0.5;
+  this->MinimumNumberOfPoints = 4;
+}
+
+//----------------------------------------------------------------------------
+vtkROIContourSimplifier::~vtkROIContourSimplifier()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourSimplifier::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Tolerance: " << this->Tolerance << "\n";
+  os << indent << "MinimumNumberOfPoints: "
+     << this->MinimumNumberOfPoints << "\n";
+}
+
+//----------------------------------------------------------------------------
+namespace {
+
+// A section of the contour between two points that will be kept, and
+// the point within the section that is farthest from the line segment
+// between those two points.
+struct vtkContourSection
+{
+  double Distance2;
+  vtkIdType First;
+  vtkIdType Last;
+  vtkIdType Farthest;
+
+  bool operator<(const vtkContourSection &other) const {
+    return (this->Distance2 < other.Distance2 ||
+            (this->Distance2 == other.Distance2 &&
+             this->First > other.First)); }
+};
+
+//----------------------------------------------------------------------------
+// Compute the squared distance from point x to the line segment p1,p2.
+inline double vtkDistance2ToSegment(
+  const double x[3], const double p1[3], const double p2[3])
+{
+  double v[3], w[3];
+  v[0] = p2[0] - p1[0];
+  v[1] = p2[1] - p1[1];
+  v[2] = p2[2] - p1[2];
+  w[0] = x[0] - p1[0];
+  w[1] = x[1] - p1[1];
+  w[2] = x[2] - p1[2];
+
+  double vv = v[0]*v[0] + v[1]*v[1] + v[2]*v[2];
+  double vw = v[0]*w[0] + v[1]*w[1] + v[2]*w[2];
+  if (vw > 0 && vv > 0)
+    {
+    double t = (vw < vv ? vw/vv : 1.0);
+    w[0] -= t*v[0];
+    w[1] -= t*v[1];
+    w[2] -= t*v[2];
+    }
+
+  return w[0]*w[0] + w[1]*w[1] + w[2]*w[2];
+}
+
+//----------------------------------------------------------------------------
+// Find the point between "first" and "last" that is farthest from the
+// segment that joins them.  The index "last" can be equal to n, which
+// refers to the first point of a closed contour.
+void vtkFindFarthestPoint(
+  const double *points, vtkIdType n, vtkContourSection *section)
+{
+  const double *p1 = &points[3*section->First];
+  const double *p2 = &points[3*(section->Last % n)];
+  section->Distance2 = -1.0;
+  section->Farthest = -1;
+  for (vtkIdType i = section->First + 1; i < section->Last; i++)
+    {
+    double d2 = vtkDistance2ToSegment(&points[3*i], p1, p2);
+    if (d2 > section->Distance2)
+      {
+      section->Distance2 = d2;
+      section->Farthest = i;
+      }
+    }
+}
+
+} // end anonymous namespace
+
+//----------------------------------------------------------------------------
+// This is the Douglas-Peucker algorithm, except that the sections are
+// split in order of decreasing error via a heap, instead of recursively.
+// This makes it possible to keep a minimum number of points, since the
+// points that are added first are the most important ones.  The heap
+// does not change the complexity: each split searches the whole section
+// for its farthest point, so if the splits are unbalanced (for example,
+// a spiral where the farthest point is always next to an end) the time
+// is O(n^2) rather than O(n log n).
+vtkIdType vtkROIContourSimplifier::SimplifyCoordinates(
+  double *points, vtkIdType n, int closed)
+{
+  vtkIdType minPoints = (closed ? this->MinimumNumberOfPoints : 2);
+  if (n <= minPoints)
+    {
+    return n;
+    }
+
+  double tol2 = this->Tolerance*this->Tolerance;
+  std::vector<char> keep(static_cast<size_t>(n), 0);
+  std::priority_queue<vtkContourSection> heap;
+  vtkIdType numKept = 2;
+
+  vtkContourSection section;
+  section.First = 0;
+  if (closed)
+    {
+    // Split at the point farthest from the first point, so that the
+    // contour becomes two sections with distinct end points
+    double maxDist2 = -1.0;
+    vtkIdType split = n/2;
+    for (vtkIdType i = 1; i < n; i++)
+      {
+      double d2 = vtkDistance2ToSegment(&points[3*i], points, points);
+      if (d2 > maxDist2)
+        {
+        maxDist2 = d2;
+        split = i;
+        }
+      }
+    keep[0] = 1;
+    keep[split] = 1;
+    section.Last = split;
+    vtkFindFarthestPoint(points, n, &section);
+    heap.push(section);
+    section.First = split;
+    section.Last = n;
+    }
+  else
+    {
+    keep[0] = 1;
+    keep[n-1] = 1;
+    section.Last = n - 1;
+    }
+  vtkFindFarthestPoint(points, n, &section);
+  heap.push(section);
+
+  // Split the section with the largest error until all are within the
+  // tolerance, and there are enough points
+  while (!heap.empty())
+    {
+    section = heap.top();
+    if (section.Farthest < 0 ||
+        (section.Distance2 <= tol2 && numKept >= minPoints))
+      {
+      break;
+      }
+    heap.pop();
+    keep[section.Farthest] = 1;
+    numKept++;
+
+    vtkContourSection part;
+    part.First = section.First;
+    part.Last = section.Farthest;
+    vtkFindFarthestPoint(points, n, &part);
+    if (part.Farthest >= 0)
+      {
+      heap.push(part);
+      }
+    part.First = section.Farthest;
+    part.Last = section.Last;
+    vtkFindFarthestPoint(points, n, &part);
+    if (part.Farthest >= 0)
+      {
+      heap.push(part);
+      }
+    }
+
+  // Move the points that were kept to the front of the array
+  vtkIdType m = 0;
+  for (vtkIdType i = 0; i < n; i++)
+    {
+    if (keep[i])
+      {
+      if (m != i)
+        {
+        points[3*m] = points[3*i];
+        points[3*m + 1] = points[3*i + 1];
+        points[3*m + 2] = points[3*i + 2];
+        }
+      m++;
+      }
+    }
+
+  return m;
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourSimplifier::SimplifyPoints(vtkPoints *points, int closed)
+{
+  vtkIdType n = points->GetNumberOfPoints();
+  vtkIdType m = n;
+
+  if (points->GetDataType() == VTK_DOUBLE)
+    {
+    double *coords = static_cast<double *>(points->GetVoidPointer(0));
+    m = this->SimplifyCoordinates(coords, n, closed);
+    }
+  else if (n > 0)
+    {
+    std::vector<double> coords(static_cast<size_t>(3*n));
+    for (vtkIdType i = 0; i < n; i++)
+      {
+      points->GetPoint(i, &coords[3*i]);
+      }
+    m = this->SimplifyCoordinates(&coords[0], n, closed);
+    for (vtkIdType i = 0; i < m; i++)
+      {
+      points->SetPoint(i, &coords[3*i]);
+      }
+    }
+
+  if (m != n)
+    {
+    points->SetNumberOfPoints(m);
+    points->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkROIContourSimplifier::SimplifyContours(vtkROIContourData *data)
+{
+  int numContours = data->GetNumberOfContours();
+  data->PrepareForEdit();
+
+  vtkIdTypeArray *sizes = vtkIdTypeArray::New();
+  sizes->SetNumberOfTuples(numContours);
+
+  for (int i = 0; i < numContours; i++)
+    {
+    int closed =
+      (data->GetContourType(i) == vtkROIContourData::CLOSED_PLANAR);
+    vtkIdType n = data->GetNumberOfContourPoints(i);
+    double *coords = data->GetContourCoordinates(i);
+    if (coords)
+      {
+      n = this->SimplifyCoordinates(coords, n, closed);
+      }
+    else if (n > 0)
+      {
+      vtkPoints *points = data->GetContourPoints(i);
+      this->SimplifyPoints(points, closed);
+      n = points->GetNumberOfPoints();
+      }
+    sizes->SetValue(i, n);
+    }
+
+  // Shorten the contours to match the number of points that were kept
+  data->TruncateContours(sizes);
+  sizes->Delete();
+}
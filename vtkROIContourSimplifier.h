@@ -0,0 +1,85 @@
+/*=========================================================================
+
+  Program:   ToolCursor
+  Module:    vtkROIContourSimplifier.h
+
+  Copyright (c) 2010 David Gobbi
+  All rights reserved.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkROIContourSimplifier - Remove redundant points from contours
+// .SECTION Description
+// This class reduces the number of points in a contour while keeping the
+// contour within a specified distance of the original.  It uses the
+// Douglas-Peucker algorithm: every point that is removed is within the
+// Tolerance of the line segment that replaces it.  For n points, the
+// time is O(n log n) for typical contours, but it is O(n^2) in the worst
+// case, when each split leaves nearly all of the points on one side.
+// The contours are simplified in place, so no new arrays are allocated
+// for the points.
+// The methods that simplify a single contour can be called from several
+// threads at once.
+
+#ifndef __vtkROIContourSimplifier_h
+#define __vtkROIContourSimplifier_h
+
+#include "vtkObject.h"
+
+class vtkPoints;
+class vtkROIContourData;
+
+class VTK_EXPORT vtkROIContourSimplifier : public vtkObject
+{
+public:
+  static vtkROIContourSimplifier *New();
+  vtkTypeMacro(vtkROIContourSimplifier,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // The maximum distance that the simplified contour can be from any of
+  // the original points, in the same units as the points.  The default
+  // is 0.5.
+  vtkSetMacro(Tolerance, double);
+  vtkGetMacro(Tolerance, double);
+
+  // Description:
+  // The minimum number of points to keep for a closed contour.  Closed
+  // contours with fewer points will not be simplified.  The default is 4,
+  // and values less than 3 are not allowed.
+  vtkSetClampMacro(MinimumNumberOfPoints, int, 3, VTK_INT_MAX);
+  vtkGetMacro(MinimumNumberOfPoints, int);
+
+  // Description:
+  // Simplify n points stored as x,y,z triples.  The points that are kept
+  // are moved to the front of the array, and the number of points that
+  // were kept is returned.  If closed is set, then the last point is
+  // assumed to connect to the first point.
+  vtkIdType SimplifyCoordinates(double *points, vtkIdType n, int closed);
+
+  // Description:
+  // Simplify the points of one contour in place.
+  void SimplifyPoints(vtkPoints *points, int closed);
+
+  // Description:
+  // Simplify all of the contours in a vtkROIContourData.  Contours of
+  // type CLOSED_PLANAR are treated as closed.  With packed storage, the
+  // packed array is simplified and compacted in place.
+  void SimplifyContours(vtkROIContourData *data);
+
+protected:
+  vtkROIContourSimplifier();
+  ~vtkROIContourSimplifier();
+
+  double Tolerance;
+  int MinimumNumberOfPoints;
+
+private:
+  vtkROIContourSimplifier(const vtkROIContourSimplifier&);  // Not implemented.
+  void operator=(const vtkROIContourSimplifier&);  // Not implemented.
+};
+
+#endif
@@ -0,0 +1,210 @@
+/*=========================================================================
+
+  Program:   ToolCursor
+  Module:    vtkSlabStreamingAlgorithm.cxx
+
+  Copyright (c) 2010 David Gobbi
+  All rights reserved.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkSlabStreamingAlgorithm.h"
+
+#include "vtkDataObject.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+
+//----------------------------------------------------------------------------
+vtkSlabStreamingAlgorithm::vtkSlabStreamingAlgorithm()
+{
+  this->Streaming = 0;
+  this->SlabSize = 16;
+  this->SlabIndex = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkSlabStreamingAlgorithm::~vtkSlabStreamingAlgorithm()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkSlabStreamingAlgorithm::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Streaming: " << (this->Streaming ? "On\n" : "Off\n");
+  os << indent << "SlabSize: " << this->SlabSize << "\n";
+}
+
+//----------------------------------------------------------------------------
+int vtkSlabStreamingAlgorithm::ProcessRequest(
+  vtkInformation* request,
+  vtkInformationVector** inputVector,
+  vtkInformationVector* outputVector)
+{
+  // create data object
+  if (request->Has(vtkDemandDrivenPipeline::REQUEST_DATA_OBJECT()))
+    {
+    return this->RequestDataObject(request, inputVector, outputVector);
+    }
+
+  // generate the data
+  if (request->Has(vtkDemandDrivenPipeline::REQUEST_DATA()))
+    {
+    return this->RequestData(request, inputVector, outputVector);
+    }
+
+  // tell inputs how to update
+  if (request->Has(vtkStreamingDemandDrivenPipeline::REQUEST_UPDATE_EXTENT()))
+    {
+    return this->RequestUpdateExtent(request, inputVector, outputVector);
+    }
+
+  // execute information
+  if (request->Has(vtkDemandDrivenPipeline::REQUEST_INFORMATION()))
+    {
+    return this->RequestInformation(request, inputVector, outputVector);
+    }
+
+  return this->Superclass::ProcessRequest(request, inputVector, outputVector);
+}
+
+//----------------------------------------------------------------------------
+int vtkSlabStreamingAlgorithm::RequestDataObject(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **vtkNotUsed(inputVector),
+  vtkInformationVector *outputVector)
+{
+  vtkInformation* info = outputVector->GetInformationObject(0);
+  vtkDataObject *data = info->Get(vtkDataObject::DATA_OBJECT());
+  if (!data)
+    {
+    data = this->NewOutputData();
+#if VTK_MAJOR_VERSION >= 6
+    info->Set(vtkDataObject::DATA_OBJECT(), data);
+#else
+    data->SetPipelineInformation(info);
+#endif
+    data->Delete();
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlabStreamingAlgorithm::RequestInformation(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **vtkNotUsed(inputVector),
+  vtkInformationVector *vtkNotUsed(outputVector))
+{
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlabStreamingAlgorithm::RequestUpdateExtent(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **inputVector,
+  vtkInformationVector *vtkNotUsed(outputVector))
+{
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  int wholeExtent[6];
+  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExtent);
+
+  int extent[6];
+  this->ComputeNextSlabExtent(wholeExtent, extent);
+  inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent, 6);
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlabStreamingAlgorithm::GetNumberOfSlabs(const int wholeExtent[6])
+{
+  int numSlices = wholeExtent[5] - wholeExtent[4] + 1;
+  if (numSlices <= 0 || wholeExtent[1] < wholeExtent[0] ||
+      wholeExtent[3] < wholeExtent[2])
+    {
+    return 0;
+    }
+  if (!this->Streaming)
+    {
+    return 1;
+    }
+  return (numSlices - 1)/this->SlabSize + 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlabStreamingAlgorithm::ComputeSlabExtent(
+  const int wholeExtent[6], int slab, int extent[6])
+{
+  for (int k = 0; k < 6; k++)
+    {
+    extent[k] = wholeExtent[k];
+    }
+  if (this->Streaming)
+    {
+    extent[4] = wholeExtent[4] + slab*this->SlabSize;
+    extent[5] = extent[4] + this->SlabSize - 1;
+    extent[5] = (extent[5] > wholeExtent[5] ? wholeExtent[5] : extent[5]);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlabStreamingAlgorithm::ComputeNextSlabExtent(
+  const int wholeExtent[6], int extent[6])
+{
+  int numSlabs = this->GetNumberOfSlabs(wholeExtent);
+  if (this->SlabIndex >= numSlabs)
+    {
+    // Settings changed while streaming, so start again
+    this->SlabIndex = 0;
+    }
+  if (numSlabs > 0)
+    {
+    this->ComputeSlabExtent(wholeExtent, this->SlabIndex, extent);
+    }
+  else
+    {
+    for (int k = 0; k < 6; k++)
+      {
+      extent[k] = wholeExtent[k];
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlabStreamingAlgorithm::StartSlab(
+  vtkInformation *request, int numSlabs)
+{
+  if (this->SlabIndex != 0)
+    {
+    return 0;
+    }
+  if (numSlabs > 1)
+    {
+    request->Set(vtkStreamingDemandDrivenPipeline::CONTINUE_EXECUTING(), 1);
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlabStreamingAlgorithm::FinishSlab(
+  vtkInformation *request, int numSlabs)
+{
+  if (++this->SlabIndex < numSlabs)
+    {
+    return 0;
+    }
+  this->StopStreaming(request);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlabStreamingAlgorithm::StopStreaming(vtkInformation *request)
+{
+  this->SlabIndex = 0;
+  request->Remove(vtkStreamingDemandDrivenPipeline::CONTINUE_EXECUTING());
+}
@@ -0,0 +1,110 @@
+/*=========================================================================
+
+  Program:   ToolCursor
+  Module:    vtkSlabStreamingAlgorithm.h
+
+  Copyright (c) 2010 David Gobbi
+  All rights reserved.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkSlabStreamingAlgorithm - Superclass for filters that stream slabs
+// .SECTION Description
+// This is a superclass for filters that read a vtkImageData from their
+// first input port.  When Streaming is on, the filter asks the pipeline
+// for one slab of SlabSize slices at a time, and asks the pipeline to keep
+// executing until all of the slabs are done, so the upstream filters only
+// have to hold one slab in memory.  The subclass must carry its results
+// from one slab to the next.  In RequestData(), the subclass should call
+// StartSlab() before it does each slab, and FinishSlab() after.
+
+#ifndef __vtkSlabStreamingAlgorithm_h
+#define __vtkSlabStreamingAlgorithm_h
+
+#include "vtkAlgorithm.h"
+
+class VTK_EXPORT vtkSlabStreamingAlgorithm : public vtkAlgorithm
+{
+public:
+  vtkTypeMacro(vtkSlabStreamingAlgorithm,vtkAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Stream the input in slabs of SlabSize slices.  The default is Off.
+  vtkSetMacro(Streaming, int);
+  vtkBooleanMacro(Streaming, int);
+  vtkGetMacro(Streaming, int);
+
+  // Description:
+  // The number of slices in each slab when streaming.  The default is 16.
+  vtkSetClampMacro(SlabSize, int, 1, VTK_INT_MAX);
+  vtkGetMacro(SlabSize, int);
+
+  // Description:
+  // see vtkAlgorithm for details
+  virtual int ProcessRequest(vtkInformation*,
+                             vtkInformationVector**,
+                             vtkInformationVector*);
+
+protected:
+  vtkSlabStreamingAlgorithm();
+  ~vtkSlabStreamingAlgorithm();
+
+  // Description:
+  // Create the output data object, if it does not exist yet.
+  virtual vtkDataObject *NewOutputData() = 0;
+
+  virtual int RequestDataObject(
+    vtkInformation* request, vtkInformationVector** inputVector,
+    vtkInformationVector* outputVector);
+
+  virtual int RequestInformation(
+    vtkInformation* request, vtkInformationVector** inputVector,
+    vtkInformationVector* outputVector);
+
+  // Description:
+  // Ask for the current slab of the input, or for the whole extent if
+  // not streaming.
+  virtual int RequestUpdateExtent(
+    vtkInformation* request, vtkInformationVector** inputVector,
+    vtkInformationVector* outputVector);
+
+  virtual int RequestData(
+    vtkInformation* request, vtkInformationVector** inputVector,
+    vtkInformationVector* outputVector) = 0;
+
+  // Description:
+  // Get the number of slabs that the whole extent will be divided into,
+  // and the extent of one of the slabs.  If the whole extent is empty,
+  // then there are no slabs.
+  int GetNumberOfSlabs(const int wholeExtent[6]);
+  void ComputeSlabExtent(const int wholeExtent[6], int slab, int extent[6]);
+
+  // Description:
+  // Get the extent of the slab that will be done next.  If the settings
+  // were changed while streaming, this goes back to the first slab.
+  void ComputeNextSlabExtent(const int wholeExtent[6], int extent[6]);
+
+  // Description:
+  // StartSlab() returns 1 for the first slab, and if more slabs will
+  // follow, it asks the pipeline to keep executing.  FinishSlab() moves
+  // on to the next slab, and returns 1 after the last slab, at which
+  // point it tells the pipeline to stop.  StopStreaming() goes back to
+  // the first slab immediately, for example if the input is empty.
+  int StartSlab(vtkInformation *request, int numSlabs);
+  int FinishSlab(vtkInformation *request, int numSlabs);
+  void StopStreaming(vtkInformation *request);
+
+  int Streaming;
+  int SlabSize;
+  int SlabIndex;
+
+private:
+  vtkSlabStreamingAlgorithm(const vtkSlabStreamingAlgorithm&);  // Not implemented.
+  void operator=(const vtkSlabStreamingAlgorithm&);  // Not implemented.
+};
+
+#endif
@@ -30,11 +30,14 @@
 #include "vtkProperty.h"
 #include "vtkDataSetMapper.h"
 #include "vtkAbstractVolumeMapper.h"
-#include "vtkVolumeRayCastMapper.h"
 #include "vtkLookupTable.h"
 #include "vtkDataSetCollection.h"
 #include "vtkImageData.h"
 #include "vtkPolyData.h"
+#include "vtkPoints.h"
+#include "vtkCellArray.h"
+#include "vtkCellData.h"
+#include "vtkUnsignedCharArray.h"
 #include "vtkMatrix4x4.h"
 #include "vtkMath.h"
 #include "vtkVolumePicker.h"
@@ -47,6 +50,23 @@
 #include "vtkTubeFilter.h"
 #include "vtkInformation.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
+#include "vtkSmartPointer.h"
+#include "vtkAssemblyNode.h"
+#include "vtkImageSlice.h"
+#include "vtkAlgorithmOutput.h"
+#include "vtkExecutive.h"
+#include "vtkTimerLog.h"
+#include "vtkRenderWindow.h"
+#include "vtkMapper.h"
+#include "vtkVolumeProperty.h"
+#include "vtkFixedPointVolumeRayCastMapper.h"
+#include "vtkImageProperty.h"
+#include "vtkImageSliceMapper.h"
+#include "vtkImageResliceMapper.h"
+#include "vtkImageSliceCollection.h"
+#include "vtkMultiThreader.h"
+#include "vtkMutexLock.h"
+#include "vtkConditionVariable.h"
 
 #include "vtkCursorShapes.h"
 #include "vtkActionCursorShapes.h"
@@ -59,6 +79,12 @@
 #include "vtkZoomCameraTool.h"
 #include "vtkFollowerPlane.h"
 
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
 // A macro to assist VTK 5 backwards compatibility
 #if VTK_MAJOR_VERSION >= 6
 #define SET_INPUT_DATA SetInputData
@@ -66,31 +92,1598 @@
 #define SET_INPUT_DATA SetInput
 #endif
 
-vtkStandardNewMacro(vtkToolCursor);
+vtkStandardNewMacro(vtkToolCursor);
+
+//----------------------------------------------------------------------------
+class vtkToolCursorRenderCommand : public vtkCommand
+{
+public:
+  static vtkToolCursorRenderCommand *New(vtkToolCursor *cursor) {
+    return new vtkToolCursorRenderCommand(cursor); };
+
+  virtual void Execute(vtkObject *, unsigned long, void *) {
+    this->Cursor->OnRender(); };
+
+protected:
+  vtkToolCursorRenderCommand(vtkToolCursor *cursor) {
+    this->Cursor = cursor; };
+
+  vtkToolCursor* Cursor;
+
+private:
+  static vtkToolCursorRenderCommand *New(); // Not implemented.
+  vtkToolCursorRenderCommand(); // Not implemented.
+  vtkToolCursorRenderCommand(const vtkToolCursorRenderCommand&);  // Not implemented.
+  void operator=(const vtkToolCursorRenderCommand&);  // Not implemented.
+};
+
+//----------------------------------------------------------------------------
+// The state of a prop's pipeline at the time when it was last updated
+class vtkToolCursorPropCacheEntry
+{
+public:
+  vtkToolCursorPropCacheEntry() : Algorithm(0), PipelineMTime(0),
+    Generation(0) {
+    for (int i = 0; i < 6; i++) { this->DisplayExtent[i] = 0; } };
+
+  vtkAlgorithm *Algorithm;
+  unsigned long PipelineMTime;
+  unsigned long Generation;
+  int DisplayExtent[6];
+};
+
+// A map of the above, keyed by prop, with a VTK-like interface
+class vtkToolCursorPropCache
+{
+private:
+  typedef std::map<vtkProp *, vtkToolCursorPropCacheEntry> MapType;
+  MapType Map;
+  unsigned long Generation;
+  unsigned long SceneMTime;
+
+  vtkToolCursorPropCache() : Generation(0), SceneMTime(0) {};
+
+  static void ComputePipelineMTime(
+    vtkAlgorithm *alg, unsigned long *mtime, std::set<vtkAlgorithm *> *seen);
+
+public:
+  static vtkToolCursorPropCache *New() {
+    return new vtkToolCursorPropCache; };
+
+  void Delete() {
+    delete this; };
+
+  // Get the most recent MTime of the algorithm, its inputs, and the
+  // algorithms and data objects that are upstream of it.
+  static unsigned long GetPipelineMTime(vtkAlgorithm *alg) {
+    unsigned long mtime = 0;
+    std::set<vtkAlgorithm *> seen;
+    vtkToolCursorPropCache::ComputePipelineMTime(alg, &mtime, &seen);
+    return mtime; };
+
+  // Start a new traversal of the props, entries for any props that are
+  // not visited before RemoveStaleEntries() is called will be removed.
+  void NewGeneration() {
+    this->Generation++; this->SceneMTime = 0; };
+
+  // The most recent MTime of all props and pipelines visited during
+  // this generation, this is used as a key for the pick cache.
+  void AddToSceneMTime(unsigned long t) {
+    this->SceneMTime = (t > this->SceneMTime ? t : this->SceneMTime); };
+  unsigned long GetSceneMTime() {
+    return this->SceneMTime; };
+
+  // Get the pipeline MTime of the algorithm, or the MTime of the data
+  // if it is newer.  The data is needed when it is the output of the
+  // algorithm, since it can be modified in place.
+  static unsigned long GetPipelineMTime(vtkAlgorithm *alg,
+                                        vtkDataObject *data) {
+    unsigned long mtime = vtkToolCursorPropCache::GetPipelineMTime(alg);
+    unsigned long t = (data ? data->GetMTime() : 0);
+    return (t > mtime ? t : mtime); };
+
+  // Check whether the prop has already been updated with the same
+  // pipeline and display extent.
+  bool IsCurrent(vtkProp *prop, vtkAlgorithm *alg, const int extent[6],
+                 vtkDataObject *data = 0);
+
+  // Record the state of the prop's pipeline after it has been updated.
+  void Store(vtkProp *prop, vtkAlgorithm *alg, const int extent[6],
+             vtkDataObject *data = 0);
+
+  void RemoveStaleEntries();
+
+  void Clear() {
+    this->Map.clear(); };
+};
+
+//----------------------------------------------------------------------------
+void vtkToolCursorPropCache::ComputePipelineMTime(
+  vtkAlgorithm *alg, unsigned long *mtime, std::set<vtkAlgorithm *> *seen)
+{
+  if (alg == 0 || !seen->insert(alg).second)
+    {
+    return;
+    }
+
+  unsigned long t = alg->GetMTime();
+  *mtime = (t > *mtime ? t : *mtime);
+
+  vtkExecutive *executive = alg->GetExecutive();
+  int numPorts = alg->GetNumberOfInputPorts();
+  for (int port = 0; port < numPorts; port++)
+    {
+    int numConnections = alg->GetNumberOfInputConnections(port);
+    for (int i = 0; i < numConnections; i++)
+      {
+      vtkDataObject *data = executive->GetInputData(port, i);
+      if (data)
+        {
+        t = data->GetMTime();
+        *mtime = (t > *mtime ? t : *mtime);
+        }
+      vtkAlgorithmOutput *connection = alg->GetInputConnection(port, i);
+      if (connection)
+        {
+        vtkToolCursorPropCache::ComputePipelineMTime(
+          connection->GetProducer(), mtime, seen);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkToolCursorPropCache::IsCurrent(
+  vtkProp *prop, vtkAlgorithm *alg, const int extent[6], vtkDataObject *data)
+{
+  MapType::iterator iter = this->Map.find(prop);
+  if (iter == this->Map.end())
+    {
+    return false;
+    }
+
+  vtkToolCursorPropCacheEntry &entry = iter->second;
+  unsigned long mtime = vtkToolCursorPropCache::GetPipelineMTime(alg, data);
+  this->AddToSceneMTime(mtime);
+  if (entry.Algorithm != alg ||
+      entry.DisplayExtent[0] != extent[0] ||
+      entry.DisplayExtent[1] != extent[1] ||
+      entry.DisplayExtent[2] != extent[2] ||
+      entry.DisplayExtent[3] != extent[3] ||
+      entry.DisplayExtent[4] != extent[4] ||
+      entry.DisplayExtent[5] != extent[5] ||
+      entry.PipelineMTime != mtime)
+    {
+    return false;
+    }
+
+  entry.Generation = this->Generation;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursorPropCache::Store(
+  vtkProp *prop, vtkAlgorithm *alg, const int extent[6], vtkDataObject *data)
+{
+  vtkToolCursorPropCacheEntry &entry = this->Map[prop];
+  entry.Algorithm = alg;
+  entry.PipelineMTime = vtkToolCursorPropCache::GetPipelineMTime(alg, data);
+  entry.Generation = this->Generation;
+  this->AddToSceneMTime(entry.PipelineMTime);
+  for (int i = 0; i < 6; i++)
+    {
+    entry.DisplayExtent[i] = extent[i];
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursorPropCache::RemoveStaleEntries()
+{
+  MapType::iterator iter = this->Map.begin();
+  while (iter != this->Map.end())
+    {
+    if (iter->second.Generation != this->Generation)
+      {
+      this->Map.erase(iter++);
+      }
+    else
+      {
+      ++iter;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// The outputs of a pick, saved so that the pick can be reused
+#define VTK_TOOL_PICK_CACHE_KEY_SIZE 7
+
+class vtkToolCursorPickResult
+{
+public:
+  int DisplayPosition[2];
+  int PickFlags;
+  vtkSmartPointer<vtkAssemblyPath> Path;
+  vtkAbstractMapper3D *Mapper;
+  vtkDataSet *DataSet;
+  double SelectionPoint[3];
+  double PickPosition[3];
+  double PickNormal[3];
+  double MapperPosition[3];
+  double MapperNormal[3];
+  double PCoords[3];
+  int CellIJK[3];
+  int PointIJK[3];
+  vtkIdType CellId;
+  vtkIdType PointId;
+  int SubId;
+  int ClippingPlaneId;
+  int CroppingPlaneId;
+};
+
+// A picker that can save its results and restore them later
+class vtkToolCursorPicker : public vtkVolumePicker
+{
+public:
+  static vtkToolCursorPicker *New();
+  vtkTypeMacro(vtkToolCursorPicker, vtkVolumePicker);
+
+  void SaveResult(vtkToolCursorPickResult *result);
+  void RestoreResult(const vtkToolCursorPickResult *result);
+
+protected:
+  vtkToolCursorPicker() {};
+  ~vtkToolCursorPicker() {};
+
+private:
+  vtkToolCursorPicker(const vtkToolCursorPicker&);  // Not implemented.
+  void operator=(const vtkToolCursorPicker&);  // Not implemented.
+};
+
+vtkStandardNewMacro(vtkToolCursorPicker);
+
+//----------------------------------------------------------------------------
+void vtkToolCursorPicker::SaveResult(vtkToolCursorPickResult *result)
+{
+  result->Path = this->Path;
+  result->Mapper = this->Mapper;
+  result->DataSet = this->DataSet;
+  result->CellId = this->CellId;
+  result->PointId = this->PointId;
+  result->SubId = this->SubId;
+  result->ClippingPlaneId = this->ClippingPlaneId;
+  result->CroppingPlaneId = this->CroppingPlaneId;
+  for (int i = 0; i < 3; i++)
+    {
+    result->SelectionPoint[i] = this->SelectionPoint[i];
+    result->PickPosition[i] = this->PickPosition[i];
+    result->PickNormal[i] = this->PickNormal[i];
+    result->MapperPosition[i] = this->MapperPosition[i];
+    result->MapperNormal[i] = this->MapperNormal[i];
+    result->PCoords[i] = this->PCoords[i];
+    result->CellIJK[i] = this->CellIJK[i];
+    result->PointIJK[i] = this->PointIJK[i];
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursorPicker::RestoreResult(const vtkToolCursorPickResult *result)
+{
+  this->SetPath(result->Path);
+  this->Mapper = result->Mapper;
+  this->DataSet = result->DataSet;
+  this->CellId = result->CellId;
+  this->PointId = result->PointId;
+  this->SubId = result->SubId;
+  this->ClippingPlaneId = result->ClippingPlaneId;
+  this->CroppingPlaneId = result->CroppingPlaneId;
+  for (int i = 0; i < 3; i++)
+    {
+    this->SelectionPoint[i] = result->SelectionPoint[i];
+    this->PickPosition[i] = result->PickPosition[i];
+    this->PickNormal[i] = result->PickNormal[i];
+    this->MapperPosition[i] = result->MapperPosition[i];
+    this->MapperNormal[i] = result->MapperNormal[i];
+    this->PCoords[i] = result->PCoords[i];
+    this->CellIJK[i] = result->CellIJK[i];
+    this->PointIJK[i] = result->PointIJK[i];
+    }
+}
+
+//----------------------------------------------------------------------------
+// A most-recently-used list of pick results for one state of the scene
+class vtkToolCursorPickCache
+{
+private:
+  typedef std::vector<vtkToolCursorPickResult> VectorType;
+  VectorType Results;
+  unsigned long SceneKey[VTK_TOOL_PICK_CACHE_KEY_SIZE];
+
+  vtkToolCursorPickCache() {
+    for (int i = 0; i < VTK_TOOL_PICK_CACHE_KEY_SIZE; i++) {
+      this->SceneKey[i] = 0; } };
+
+public:
+  static vtkToolCursorPickCache *New() {
+    return new vtkToolCursorPickCache; };
+
+  void Delete() {
+    delete this; };
+
+  // Set the key that describes the scene, all saved results are
+  // discarded if the key has changed.
+  void SetSceneKey(const unsigned long key[VTK_TOOL_PICK_CACHE_KEY_SIZE]) {
+    for (int i = 0; i < VTK_TOOL_PICK_CACHE_KEY_SIZE; i++) {
+      if (key[i] != this->SceneKey[i]) {
+        this->Results.clear(); this->SceneKey[i] = key[i]; } } };
+
+  // Find the result for the display position, or return null.  The
+  // result becomes the most recently used result.
+  vtkToolCursorPickResult *Find(int x, int y);
+
+  // Make room for a new result and return it, the least recently used
+  // results are discarded to keep the list within the maximum size.
+  vtkToolCursorPickResult *Insert(int x, int y, int maxSize);
+
+  void Clear() {
+    this->Results.clear(); };
+};
+
+//----------------------------------------------------------------------------
+vtkToolCursorPickResult *vtkToolCursorPickCache::Find(int x, int y)
+{
+  VectorType::iterator iter;
+  for (iter = this->Results.begin(); iter != this->Results.end(); ++iter)
+    {
+    if (iter->DisplayPosition[0] == x && iter->DisplayPosition[1] == y)
+      {
+      if (iter != this->Results.begin())
+        {
+        vtkToolCursorPickResult result = *iter;
+        this->Results.erase(iter);
+        this->Results.insert(this->Results.begin(), result);
+        }
+      return &this->Results.front();
+      }
+    }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+vtkToolCursorPickResult *vtkToolCursorPickCache::Insert(
+  int x, int y, int maxSize)
+{
+  VectorType::size_type n = static_cast<VectorType::size_type>(maxSize);
+  if (n > 0 && this->Results.size() >= n)
+    {
+    this->Results.resize(n - 1);
+    }
+
+  this->Results.insert(this->Results.begin(), vtkToolCursorPickResult());
+  vtkToolCursorPickResult *result = &this->Results.front();
+  result->DisplayPosition[0] = x;
+  result->DisplayPosition[1] = y;
+
+  return result;
+}
+
+//----------------------------------------------------------------------------
+// Compare two pick cache keys
+inline bool vtkToolCursorPickKeysEqual(
+  const unsigned long a[VTK_TOOL_PICK_CACHE_KEY_SIZE],
+  const unsigned long b[VTK_TOOL_PICK_CACHE_KEY_SIZE])
+{
+  for (int i = 0; i < VTK_TOOL_PICK_CACHE_KEY_SIZE; i++)
+    {
+    if (a[i] != b[i])
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// A deep copy of the pickable props, so that picks can be done by a
+// worker thread while the real props are rendered and modified.  Each
+// leaf of each prop's assembly path becomes a separate prop, with its
+// own mapper, property, and copy of the input data.  The scene has its
+// own renderer, camera, and render window, and the window is never
+// rendered or shown.  The copies of the data are kept when the scene is
+// rebuilt, unless the data has been modified since it was copied.
+class vtkToolCursorPickScene
+{
+public:
+  // A mapper in the scene, and the mapper and data that it copies
+  class Item
+  {
+  public:
+    vtkAbstractMapper3D *Mapper;
+    vtkDataSet *DataSet;
+    vtkAbstractMapper3D *MapperCopy;
+  };
+
+  // A prop in the scene, and the path of the prop that it copies.  If
+  // the path has no matrix, the copy follows the matrix of MatrixProp.
+  class Leaf
+  {
+  public:
+    vtkSmartPointer<vtkAssemblyPath> Path;
+    vtkSmartPointer<vtkProp3D> MatrixProp;
+    vtkSmartPointer<vtkProp3D> Copy;
+    std::vector<Item> Items;
+  };
+
+  // A copy of a data set, and the MTime of the data when it was copied
+  class DataCopy
+  {
+  public:
+    DataCopy() : MTime(0), Used(false) {};
+
+    unsigned long MTime;
+    bool Used;
+    vtkSmartPointer<vtkDataSet> Copy;
+  };
+
+  typedef std::vector<Leaf> VectorType;
+  typedef std::map<vtkDataSet *, DataCopy> MapType;
+
+  static vtkToolCursorPickScene *New() {
+    return new vtkToolCursorPickScene; };
+
+  void Delete() {
+    delete this; };
+
+  // Copy the props from the collection, skipping the given props, and
+  // copy the settings of the picker.  Returns false if any of the props
+  // could not be copied.
+  bool Build(vtkPropCollection *props, vtkVolumePicker *picker,
+             vtkProp *const skip[3]);
+
+  // Copy the camera, window size, and viewport from the renderer, and
+  // update the matrices and slices of props that might follow the camera.
+  void SetView(vtkRenderer *renderer);
+
+  // Replace the path, mapper, and data set of a result with the ones
+  // that the picked prop in the scene is a copy of.
+  void MapResult(vtkToolCursorPickResult *result, vtkProp *prop);
+
+  // These are only used by the main thread
+  unsigned long Key[2];
+  bool Stale;
+  bool Complete;
+
+  // These are only used by the worker thread while it is picking
+  vtkRenderer *Renderer;
+  vtkToolCursorPicker *Picker;
+
+private:
+  vtkToolCursorPickScene();
+  ~vtkToolCursorPickScene();
+
+  vtkDataSet *CopyData(vtkDataSet *data);
+  static vtkPlaneCollection *CopyPlanes(vtkPlaneCollection *planes);
+  static vtkMatrix4x4 *GetLeafMatrix(vtkAssemblyPath *path, vtkProp3D *prop);
+  static void CopyMatrix(vtkMatrix4x4 *matrix, vtkMatrix4x4 *copy);
+  static void CopySlice(vtkImageMapper3D *mapper, vtkImageMapper3D *copy);
+
+  vtkActor *CopyActor(vtkActor *actor, Leaf *leaf);
+  vtkVolume *CopyVolume(vtkVolume *volume, Leaf *leaf);
+  vtkImageSlice *CopyImage(vtkImageSlice *image, Leaf *leaf);
+  vtkImageStack *CopyImageStack(vtkImageStack *stack, Leaf *leaf);
+
+  void AddLeaf(Leaf *leaf, vtkAssemblyPath *path, vtkProp3D *prop,
+               vtkProp3D *copy);
+
+  vtkRenderWindow *Window;
+  vtkCamera *Camera;
+  VectorType Leaves;
+  MapType DataCopies;
+};
+
+//----------------------------------------------------------------------------
+vtkToolCursorPickScene::vtkToolCursorPickScene()
+{
+  this->Key[0] = 0;
+  this->Key[1] = 0;
+  this->Stale = true;
+  this->Complete = false;
+
+  // The window is only used for its size, it is never rendered
+  this->Window = vtkRenderWindow::New();
+  this->Camera = vtkCamera::New();
+  this->Renderer = vtkRenderer::New();
+  this->Renderer->SetRenderWindow(this->Window);
+  this->Renderer->SetActiveCamera(this->Camera);
+  this->Picker = vtkToolCursorPicker::New();
+}
+
+//----------------------------------------------------------------------------
+vtkToolCursorPickScene::~vtkToolCursorPickScene()
+{
+  this->Leaves.clear();
+  this->DataCopies.clear();
+  this->Renderer->RemoveAllViewProps();
+  this->Renderer->SetRenderWindow(0);
+  this->Renderer->Delete();
+  this->Camera->Delete();
+  this->Window->Delete();
+  this->Picker->Delete();
+}
+
+//----------------------------------------------------------------------------
+vtkDataSet *vtkToolCursorPickScene::CopyData(vtkDataSet *data)
+{
+  // The copy is deep so that the worker thread never uses the same
+  // arrays as the main thread, and it is reused until the data changes
+  DataCopy &entry = this->DataCopies[data];
+  if (entry.Copy == 0 || entry.MTime != data->GetMTime())
+    {
+    vtkDataSet *copy = data->NewInstance();
+    copy->DeepCopy(data);
+#if VTK_MAJOR_VERSION < 6
+    // The whole extent is pipeline information, it is not copied
+    vtkImageData *image = vtkImageData::SafeDownCast(copy);
+    if (image)
+      {
+      image->SetWholeExtent(image->GetExtent());
+      }
+#endif
+    entry.Copy = copy;
+    entry.MTime = data->GetMTime();
+    copy->Delete();
+    }
+  entry.Used = true;
+
+  return entry.Copy;
+}
+
+//----------------------------------------------------------------------------
+vtkPlaneCollection *vtkToolCursorPickScene::CopyPlanes(
+  vtkPlaneCollection *planes)
+{
+  if (planes == 0)
+    {
+    return 0;
+    }
+
+  vtkPlaneCollection *copy = vtkPlaneCollection::New();
+  vtkCollectionSimpleIterator iter;
+  vtkPlane *plane;
+  planes->InitTraversal(iter);
+  while ( (plane = planes->GetNextPlane(iter)) )
+    {
+    vtkPlane *planeCopy = vtkPlane::New();
+    planeCopy->SetOrigin(plane->GetOrigin());
+    planeCopy->SetNormal(plane->GetNormal());
+    copy->AddItem(planeCopy);
+    planeCopy->Delete();
+    }
+
+  return copy;
+}
+
+//----------------------------------------------------------------------------
+vtkMatrix4x4 *vtkToolCursorPickScene::GetLeafMatrix(
+  vtkAssemblyPath *path, vtkProp3D *prop)
+{
+  vtkMatrix4x4 *matrix = path->GetLastNode()->GetMatrix();
+  if (matrix == 0)
+    {
+    matrix = prop->GetMatrix();
+    }
+
+  return matrix;
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursorPickScene::CopyMatrix(
+  vtkMatrix4x4 *matrix, vtkMatrix4x4 *copy)
+{
+  // Only modify the copy if the matrix has changed
+  for (int i = 0; i < 4; i++)
+    {
+    for (int j = 0; j < 4; j++)
+      {
+      if (copy->Element[i][j] != matrix->Element[i][j])
+        {
+        copy->DeepCopy(matrix);
+        return;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursorPickScene::CopySlice(
+  vtkImageMapper3D *mapper, vtkImageMapper3D *copy)
+{
+  // The set methods only modify the copy if the slice has changed
+  vtkImageSliceMapper *sliceMapper = vtkImageSliceMapper::SafeDownCast(mapper);
+  if (sliceMapper)
+    {
+    vtkImageSliceMapper *sliceCopy = static_cast<vtkImageSliceMapper *>(copy);
+    sliceCopy->SetOrientation(sliceMapper->GetOrientation());
+    sliceCopy->SetSliceNumber(sliceMapper->GetSliceNumber());
+    }
+
+  vtkPlane *slicePlane = mapper->GetSlicePlane();
+  copy->GetSlicePlane()->SetOrigin(slicePlane->GetOrigin());
+  copy->GetSlicePlane()->SetNormal(slicePlane->GetNormal());
+  copy->UpdateInformation();
+}
+
+//----------------------------------------------------------------------------
+vtkActor *vtkToolCursorPickScene::CopyActor(vtkActor *actor, Leaf *leaf)
+{
+  vtkMapper *mapper = actor->GetMapper();
+  vtkDataSet *data = mapper->GetInput();
+
+  // The copy is never rendered, so only the opacity of the property is
+  // needed, since the picker ignores actors that are fully transparent
+  vtkActor *copy = vtkActor::New();
+  vtkDataSetMapper *mapperCopy = vtkDataSetMapper::New();
+  vtkPlaneCollection *planes =
+    vtkToolCursorPickScene::CopyPlanes(mapper->GetClippingPlanes());
+
+  mapperCopy->SET_INPUT_DATA(this->CopyData(data));
+  mapperCopy->SetClippingPlanes(planes);
+  mapperCopy->StaticOn();
+  copy->SetMapper(mapperCopy);
+  copy->GetProperty()->SetOpacity(actor->GetProperty()->GetOpacity());
+
+  Item item;
+  item.Mapper = mapper;
+  item.DataSet = data;
+  item.MapperCopy = mapperCopy;
+  leaf->Items.push_back(item);
+
+  if (planes) { planes->Delete(); }
+  mapperCopy->Delete();
+
+  return copy;
+}
+
+//----------------------------------------------------------------------------
+vtkVolume *vtkToolCursorPickScene::CopyVolume(vtkVolume *volume, Leaf *leaf)
+{
+  // Only image volumes can be copied
+  vtkVolumeMapper *mapper = vtkVolumeMapper::SafeDownCast(volume->GetMapper());
+  vtkImageData *data = (mapper ? mapper->GetInput() : 0);
+  if (data == 0)
+    {
+    return 0;
+    }
+
+  // The mapper is never used for rendering, so any concrete volume
+  // mapper will do for holding the cropping information, and the
+  // property's DeepCopy() also copies the transfer functions
+  vtkVolume *copy = vtkVolume::New();
+  vtkVolumeProperty *property = vtkVolumeProperty::New();
+  vtkVolumeMapper *mapperCopy = vtkFixedPointVolumeRayCastMapper::New();
+  vtkPlaneCollection *planes =
+    vtkToolCursorPickScene::CopyPlanes(mapper->GetClippingPlanes());
+
+  mapperCopy->SET_INPUT_DATA(
+    static_cast<vtkImageData *>(this->CopyData(data)));
+  mapperCopy->SetClippingPlanes(planes);
+  mapperCopy->SetCropping(mapper->GetCropping());
+  mapperCopy->SetCroppingRegionPlanes(mapper->GetCroppingRegionPlanes());
+  mapperCopy->SetCroppingRegionFlags(mapper->GetCroppingRegionFlags());
+  mapperCopy->Update();
+  property->DeepCopy(volume->GetProperty());
+  copy->SetMapper(mapperCopy);
+  copy->SetProperty(property);
+
+  Item item;
+  item.Mapper = mapper;
+  item.DataSet = data;
+  item.MapperCopy = mapperCopy;
+  leaf->Items.push_back(item);
+
+  if (planes) { planes->Delete(); }
+  mapperCopy->Delete();
+  property->Delete();
+
+  return copy;
+}
+
+//----------------------------------------------------------------------------
+vtkImageSlice *vtkToolCursorPickScene::CopyImage(
+  vtkImageSlice *image, Leaf *leaf)
+{
+  vtkImageMapper3D *mapper = image->GetMapper();
+  vtkImageData *data = (mapper ? mapper->GetInput() : 0);
+  if (data == 0)
+    {
+    return 0;
+    }
+
+  vtkImageSlice *copy = vtkImageSlice::New();
+  vtkImageProperty *property = vtkImageProperty::New();
+  vtkImageMapper3D *mapperCopy = mapper->NewInstance();
+  vtkPlaneCollection *planes =
+    vtkToolCursorPickScene::CopyPlanes(mapper->GetClippingPlanes());
+
+  mapperCopy->SET_INPUT_DATA(
+    static_cast<vtkImageData *>(this->CopyData(data)));
+  mapperCopy->SetClippingPlanes(planes);
+  mapperCopy->SetBorder(mapper->GetBorder());
+
+  // The copy does not follow the camera, instead the slice that the
+  // original mapper most recently used is copied before every pick
+  mapperCopy->SliceAtFocalPointOff();
+  mapperCopy->SliceFacesCameraOff();
+
+  vtkImageSliceMapper *sliceMapper = vtkImageSliceMapper::SafeDownCast(mapper);
+  vtkImageResliceMapper *resliceMapper =
+    vtkImageResliceMapper::SafeDownCast(mapper);
+  if (sliceMapper)
+    {
+    vtkImageSliceMapper *sliceCopy =
+      static_cast<vtkImageSliceMapper *>(mapperCopy);
+    sliceCopy->SetCropping(sliceMapper->GetCropping());
+    sliceCopy->SetCroppingRegion(sliceMapper->GetCroppingRegion());
+    }
+  else if (resliceMapper)
+    {
+    vtkPlane *plane = vtkPlane::New();
+    static_cast<vtkImageResliceMapper *>(mapperCopy)->SetSlicePlane(plane);
+    plane->Delete();
+    }
+
+  vtkToolCursorPickScene::CopySlice(mapper, mapperCopy);
+
+  // Only the opacity and the layer are used for picking
+  property->SetOpacity(image->GetProperty()->GetOpacity());
+  property->SetLayerNumber(image->GetProperty()->GetLayerNumber());
+  copy->SetMapper(mapperCopy);
+  copy->SetProperty(property);
+
+  Item item;
+  item.Mapper = mapper;
+  item.DataSet = data;
+  item.MapperCopy = mapperCopy;
+  leaf->Items.push_back(item);
+
+  if (planes) { planes->Delete(); }
+  mapperCopy->Delete();
+  property->Delete();
+
+  return copy;
+}
+
+//----------------------------------------------------------------------------
+vtkImageStack *vtkToolCursorPickScene::CopyImageStack(
+  vtkImageStack *stack, Leaf *leaf)
+{
+  // Each image is copied with its matrix relative to the stack, and the
+  // picker will use the copy of the active image
+  vtkImageStack *copy = vtkImageStack::New();
+  vtkImageSliceCollection *images = stack->GetImages();
+  vtkCollectionSimpleIterator iter;
+  images->InitTraversal(iter);
+  vtkObject *object;
+  while ( (object = images->GetNextItemAsObject(iter)) )
+    {
+    vtkImageSlice *image = static_cast<vtkImageSlice *>(object);
+    vtkImageSlice *imageCopy = this->CopyImage(image, leaf);
+    if (imageCopy)
+      {
+      vtkMatrix4x4 *matrix = vtkMatrix4x4::New();
+      matrix->DeepCopy(image->GetMatrix());
+      imageCopy->SetUserMatrix(matrix);
+      copy->AddImage(imageCopy);
+      imageCopy->Delete();
+      matrix->Delete();
+      }
+    }
+  copy->SetActiveLayer(stack->GetActiveLayer());
+
+  return copy;
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursorPickScene::AddLeaf(
+  Leaf *leaf, vtkAssemblyPath *path, vtkProp3D *prop, vtkProp3D *copy)
+{
+  // Keep a copy of the path, since the prop might rebuild its paths
+  vtkAssemblyPath *pathCopy = vtkAssemblyPath::New();
+  pathCopy->ShallowCopy(path);
+  leaf->Path = pathCopy;
+  pathCopy->Delete();
+
+  // Assembly parts have a fixed matrix, other props might move, e.g.
+  // a follower moves whenever the camera moves
+  if (path->GetLastNode()->GetMatrix() == 0)
+    {
+    leaf->MatrixProp = prop;
+    }
+
+  vtkMatrix4x4 *matrix = vtkMatrix4x4::New();
+  matrix->DeepCopy(vtkToolCursorPickScene::GetLeafMatrix(path, prop));
+  copy->SetUserMatrix(matrix);
+  matrix->Delete();
+
+  leaf->Copy = copy;
+  this->Leaves.push_back(*leaf);
+  this->Renderer->AddViewProp(copy);
+}
+
+//----------------------------------------------------------------------------
+bool vtkToolCursorPickScene::Build(
+  vtkPropCollection *props, vtkVolumePicker *picker, vtkProp *const skip[3])
+{
+  this->Picker->SetTolerance(picker->GetTolerance());
+  this->Picker->SetPickClippingPlanes(picker->GetPickClippingPlanes());
+  this->Picker->SetPickCroppingPlanes(picker->GetPickCroppingPlanes());
+  this->Picker->SetVolumeOpacityIsovalue(picker->GetVolumeOpacityIsovalue());
+  this->Picker->SetUseVolumeGradientOpacity(
+    picker->GetUseVolumeGradientOpacity());
+
+  this->Renderer->RemoveAllViewProps();
+  this->Leaves.clear();
+
+  MapType::iterator iter;
+  for (iter = this->DataCopies.begin(); iter != this->DataCopies.end();
+       ++iter)
+    {
+    iter->second.Used = false;
+    }
+
+  bool complete = true;
+
+  vtkProp *prop;
+  vtkCollectionSimpleIterator pit;
+  props->InitTraversal(pit);
+  while ( (prop = props->GetNextProp(pit)) )
+    {
+    if (prop == skip[0] || prop == skip[1] || prop == skip[2])
+      {
+      continue;
+      }
+
+    vtkAssemblyPath *path;
+    prop->InitPathTraversal();
+    while ( (path = prop->GetNextPath()) )
+      {
+      if (!prop->GetPickable() || !prop->GetVisibility())
+        {
+        break;
+        }
+
+      vtkProp *anyProp = path->GetLastNode()->GetViewProp();
+      vtkActor *actor;
+      vtkVolume *volume;
+      vtkImageStack *stack;
+      vtkImageSlice *image;
+      vtkProp3D *copy = 0;
+      Leaf leaf;
+
+      if ( (actor = vtkActor::SafeDownCast(anyProp)) )
+        {
+        if (actor->GetMapper() && actor->GetMapper()->GetInput())
+          {
+          copy = this->CopyActor(actor, &leaf);
+          }
+        }
+      else if ( (volume = vtkVolume::SafeDownCast(anyProp)) )
+        {
+        if (volume->GetMapper() && volume->GetMapper()->GetDataSetInput())
+          {
+          copy = this->CopyVolume(volume, &leaf);
+          complete = (complete && copy != 0);
+          }
+        }
+      else if ( (stack = vtkImageStack::SafeDownCast(anyProp)) )
+        {
+        copy = this->CopyImageStack(stack, &leaf);
+        }
+      else if ( (image = vtkImageSlice::SafeDownCast(anyProp)) )
+        {
+        copy = this->CopyImage(image, &leaf);
+        }
+      else if (anyProp->IsA("vtkProp3D"))
+        {
+        // Other kinds of props require a synchronous pick
+        complete = false;
+        }
+
+      if (copy)
+        {
+        this->AddLeaf(&leaf, path, static_cast<vtkProp3D *>(anyProp), copy);
+        copy->Delete();
+        }
+      }
+    }
+
+  // Release the copies of data that is no longer in the scene
+  iter = this->DataCopies.begin();
+  while (iter != this->DataCopies.end())
+    {
+    if (!iter->second.Used)
+      {
+      this->DataCopies.erase(iter++);
+      }
+    else
+      {
+      ++iter;
+      }
+    }
+
+  this->Stale = false;
+  this->Complete = complete;
+
+  return complete;
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursorPickScene::SetView(vtkRenderer *renderer)
+{
+  // Only the view parameters are copied, so this is cheap enough to do
+  // before every pick
+  vtkCamera *camera = renderer->GetActiveCamera();
+  vtkCamera *copy = this->Camera;
+  double *center = camera->GetWindowCenter();
+  copy->SetPosition(camera->GetPosition());
+  copy->SetFocalPoint(camera->GetFocalPoint());
+  copy->SetViewUp(camera->GetViewUp());
+  copy->SetViewAngle(camera->GetViewAngle());
+  copy->SetUseHorizontalViewAngle(camera->GetUseHorizontalViewAngle());
+  copy->SetParallelProjection(camera->GetParallelProjection());
+  copy->SetParallelScale(camera->GetParallelScale());
+  copy->SetClippingRange(camera->GetClippingRange());
+  copy->SetWindowCenter(center[0], center[1]);
+  copy->SetViewShear(camera->GetViewShear());
+
+  vtkRenderWindow *window = renderer->GetRenderWindow();
+  if (window)
+    {
+    this->Window->SetSize(window->GetSize());
+    }
+  this->Renderer->SetViewport(renderer->GetViewport());
+
+  VectorType::iterator iter;
+  for (iter = this->Leaves.begin(); iter != this->Leaves.end(); ++iter)
+    {
+    if (iter->MatrixProp)
+      {
+      vtkToolCursorPickScene::CopyMatrix(
+        iter->MatrixProp->GetMatrix(), iter->Copy->GetUserMatrix());
+      }
+    std::vector<Item>::iterator item;
+    for (item = iter->Items.begin(); item != iter->Items.end(); ++item)
+      {
+      vtkImageMapper3D *mapper = vtkImageMapper3D::SafeDownCast(item->Mapper);
+      if (mapper)
+        {
+        vtkToolCursorPickScene::CopySlice(
+          mapper, static_cast<vtkImageMapper3D *>(item->MapperCopy));
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursorPickScene::MapResult(
+  vtkToolCursorPickResult *result, vtkProp *prop)
+{
+  vtkAbstractMapper3D *mapperCopy = result->Mapper;
+  result->Path = 0;
+  result->Mapper = 0;
+  result->DataSet = 0;
+
+  VectorType::iterator iter;
+  for (iter = this->Leaves.begin(); iter != this->Leaves.end(); ++iter)
+    {
+    if (prop != 0 && iter->Copy == prop)
+      {
+      result->Path = iter->Path;
+      std::vector<Item>::iterator item;
+      for (item = iter->Items.begin(); item != iter->Items.end(); ++item)
+        {
+        if (item->MapperCopy == mapperCopy)
+          {
+          result->Mapper = item->Mapper;
+          result->DataSet = item->DataSet;
+          }
+        }
+      break;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// A worker thread that picks from a vtkToolCursorPickScene.  The scene
+// belongs to the worker while a pick is in progress, and the main thread
+// only modifies the scene while the worker is idle, so only one pick is
+// done at a time and positions that are superseded while the worker is
+// busy are never picked.  Every pick has a serial number, and results
+// that are older than a result that has been taken, or older than a
+// synchronous pick, are dropped.
+class vtkToolCursorPickWorker
+{
+public:
+  static vtkToolCursorPickWorker *New() {
+    return new vtkToolCursorPickWorker; };
+
+  void Delete() {
+    delete this; };
+
+  // Start or stop the thread.  Stopping waits for the current pick.
+  void Start();
+  void Stop();
+
+  // Get the scene.  It must not be modified while the worker is busy.
+  vtkToolCursorPickScene *GetScene() { return this->Scene; };
+
+  // Check whether the worker is doing a pick.
+  bool IsBusy();
+
+  // Start a pick at the given position, the worker must not be busy.
+  // The key is given back with the result.
+  void Request(int x, int y,
+               const unsigned long key[VTK_TOOL_PICK_CACHE_KEY_SIZE]);
+
+  // Check whether the latest request was for the position and key.
+  bool IsRequested(int x, int y,
+                   const unsigned long key[VTK_TOOL_PICK_CACHE_KEY_SIZE]);
+
+  // Take the newest completed result, if no newer result has already
+  // been taken.  The path, mapper, and data set are the scene's, the
+  // key is the key that was given with the request, and the time that
+  // the pick took is also returned.
+  bool TakeResult(vtkToolCursorPickResult *result, vtkProp **prop,
+                  unsigned long key[VTK_TOOL_PICK_CACHE_KEY_SIZE],
+                  double *seconds);
+
+  // Drop the results of all requests that were made before now, this
+  // is called when a synchronous pick is done.
+  void Supersede();
+
+  // Supersede all requests, and rebuild the scene before the next pick.
+  void Invalidate();
+
+  // Check whether any picks have not yet been used.
+  bool IsPending();
+
+  // Check whether a render would make progress, because a result is
+  // ready or because a pick is waiting for the worker to finish.
+  bool IsReady();
+
+  // These are only used by the main thread.  The most recent result
+  // that was taken is kept, with the key that it is valid for, and
+  // Deferred is set when a pick is needed once the worker is idle.
+  vtkToolCursorPickResult LastResult;
+  unsigned long LastKey[VTK_TOOL_PICK_CACHE_KEY_SIZE];
+  bool LastResultValid;
+  bool Deferred;
+
+private:
+  vtkToolCursorPickWorker();
+  ~vtkToolCursorPickWorker();
+
+  static VTK_THREAD_RETURN_TYPE ThreadMain(void *arg);
+  void Run();
+
+  vtkMultiThreader *Threader;
+  int ThreadId;
+  vtkToolCursorPickScene *Scene;
+  vtkSimpleMutexLock Mutex;
+  vtkSimpleConditionVariable Condition;
+
+  // Members below are protected by the mutex, but the request members
+  // are only set by the main thread, so it can read them without locking
+  bool Quit;
+  bool Busy;
+  bool RequestPending;
+  int RequestPosition[2];
+  unsigned long RequestKey[VTK_TOOL_PICK_CACHE_KEY_SIZE];
+  unsigned long RequestSerial;
+  bool ResultReady;
+  unsigned long ResultSerial;
+  unsigned long ResultKey[VTK_TOOL_PICK_CACHE_KEY_SIZE];
+  double ResultTime;
+  vtkProp *ResultProp;
+  vtkToolCursorPickResult Result;
+  unsigned long Serial;
+  unsigned long TakenSerial;
+};
+
+//----------------------------------------------------------------------------
+vtkToolCursorPickWorker::vtkToolCursorPickWorker()
+{
+  this->Threader = vtkMultiThreader::New();
+  this->ThreadId = -1;
+  this->Scene = vtkToolCursorPickScene::New();
+  this->Quit = false;
+  this->Busy = false;
+  this->RequestPending = false;
+  this->RequestPosition[0] = 0;
+  this->RequestPosition[1] = 0;
+  this->RequestSerial = 0;
+  this->ResultReady = false;
+  this->ResultSerial = 0;
+  this->ResultTime = 0.0;
+  this->ResultProp = 0;
+  this->Serial = 0;
+  this->TakenSerial = 0;
+  this->LastResultValid = false;
+  this->Deferred = false;
+
+  for (int i = 0; i < VTK_TOOL_PICK_CACHE_KEY_SIZE; i++)
+    {
+    this->RequestKey[i] = 0;
+    this->ResultKey[i] = 0;
+    this->LastKey[i] = 0;
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkToolCursorPickWorker::~vtkToolCursorPickWorker()
+{
+  this->Stop();
+  this->Scene->Delete();
+  this->Threader->Delete();
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursorPickWorker::Start()
+{
+  if (this->ThreadId < 0)
+    {
+    this->Quit = false;
+    this->ThreadId = this->Threader->SpawnThread(
+      &vtkToolCursorPickWorker::ThreadMain, this);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursorPickWorker::Stop()
+{
+  if (this->ThreadId >= 0)
+    {
+    this->Mutex.Lock();
+    this->Quit = true;
+    this->RequestPending = false;
+    this->Condition.Signal();
+    this->Mutex.Unlock();
+
+    // This waits for the thread to exit
+    this->Threader->TerminateThread(this->ThreadId);
+    this->ThreadId = -1;
+    this->Busy = false;
+    this->ResultReady = false;
+    }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkToolCursorPickWorker::ThreadMain(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  static_cast<vtkToolCursorPickWorker *>(info->UserData)->Run();
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursorPickWorker::Run()
+{
+  this->Mutex.Lock();
+  for (;;)
+    {
+    while (!this->Quit && !this->RequestPending)
+      {
+      this->Condition.Wait(this->Mutex);
+      }
+    if (this->Quit)
+      {
+      break;
+      }
+
+    int x = this->RequestPosition[0];
+    int y = this->RequestPosition[1];
+    unsigned long key[VTK_TOOL_PICK_CACHE_KEY_SIZE];
+    for (int i = 0; i < VTK_TOOL_PICK_CACHE_KEY_SIZE; i++)
+      {
+      key[i] = this->RequestKey[i];
+      }
+    unsigned long serial = this->RequestSerial;
+    this->RequestPending = false;
+    this->Mutex.Unlock();
+
+    // The main thread does not touch the scene while the worker is busy
+    vtkToolCursorPicker *picker = this->Scene->Picker;
+    vtkToolCursorPickResult result;
+    double startTime = vtkTimerLog::GetUniversalTime();
+    picker->Pick(x, y, 0, this->Scene->Renderer);
+    double seconds = vtkTimerLog::GetUniversalTime() - startTime;
+    picker->SaveResult(&result);
+    result.Path = 0;
+    result.DisplayPosition[0] = x;
+    result.DisplayPosition[1] = y;
+    result.PickFlags = 0;
+    vtkProp *prop = picker->GetViewProp();
+
+    this->Mutex.Lock();
+    this->Busy = false;
+    if (serial > this->TakenSerial)
+      {
+      this->ResultReady = true;
+      this->ResultSerial = serial;
+      this->ResultTime = seconds;
+      this->ResultProp = prop;
+      this->Result = result;
+      for (int j = 0; j < VTK_TOOL_PICK_CACHE_KEY_SIZE; j++)
+        {
+        this->ResultKey[j] = key[j];
+        }
+      }
+    }
+  this->Mutex.Unlock();
+}
+
+//----------------------------------------------------------------------------
+bool vtkToolCursorPickWorker::IsBusy()
+{
+  this->Mutex.Lock();
+  bool busy = this->Busy;
+  this->Mutex.Unlock();
+
+  return busy;
+}
 
 //----------------------------------------------------------------------------
-class vtkToolCursorRenderCommand : public vtkCommand
+void vtkToolCursorPickWorker::Request(
+  int x, int y, const unsigned long key[VTK_TOOL_PICK_CACHE_KEY_SIZE])
+{
+  this->Mutex.Lock();
+  this->Busy = true;
+  this->RequestPending = true;
+  this->RequestPosition[0] = x;
+  this->RequestPosition[1] = y;
+  for (int i = 0; i < VTK_TOOL_PICK_CACHE_KEY_SIZE; i++)
+    {
+    this->RequestKey[i] = key[i];
+    }
+  this->RequestSerial = ++this->Serial;
+  this->Condition.Signal();
+  this->Mutex.Unlock();
+
+  this->Deferred = false;
+}
+
+//----------------------------------------------------------------------------
+bool vtkToolCursorPickWorker::IsRequested(
+  int x, int y, const unsigned long key[VTK_TOOL_PICK_CACHE_KEY_SIZE])
+{
+  // Only the main thread sets the request, so no lock is needed
+  return (this->RequestSerial > this->TakenSerial &&
+          this->RequestPosition[0] == x &&
+          this->RequestPosition[1] == y &&
+          vtkToolCursorPickKeysEqual(this->RequestKey, key));
+}
+
+//----------------------------------------------------------------------------
+bool vtkToolCursorPickWorker::TakeResult(
+  vtkToolCursorPickResult *result, vtkProp **prop,
+  unsigned long key[VTK_TOOL_PICK_CACHE_KEY_SIZE], double *seconds)
+{
+  bool ready = false;
+
+  this->Mutex.Lock();
+  if (this->ResultReady && this->ResultSerial > this->TakenSerial)
+    {
+    *result = this->Result;
+    *prop = this->ResultProp;
+    *seconds = this->ResultTime;
+    for (int i = 0; i < VTK_TOOL_PICK_CACHE_KEY_SIZE; i++)
+      {
+      key[i] = this->ResultKey[i];
+      }
+    this->TakenSerial = this->ResultSerial;
+    ready = true;
+    }
+  this->ResultReady = false;
+  this->Mutex.Unlock();
+
+  return ready;
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursorPickWorker::Supersede()
+{
+  this->Mutex.Lock();
+  this->RequestPending = false;
+  this->ResultReady = false;
+  this->TakenSerial = this->Serial;
+  this->Mutex.Unlock();
+
+  this->LastResultValid = false;
+  this->Deferred = false;
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursorPickWorker::Invalidate()
+{
+  this->Supersede();
+  this->Scene->Stale = true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkToolCursorPickWorker::IsPending()
+{
+  this->Mutex.Lock();
+  bool pending = (this->Busy || this->Deferred ||
+                  (this->ResultReady &&
+                   this->ResultSerial > this->TakenSerial));
+  this->Mutex.Unlock();
+
+  return pending;
+}
+
+//----------------------------------------------------------------------------
+bool vtkToolCursorPickWorker::IsReady()
+{
+  this->Mutex.Lock();
+  bool ready = (!this->Busy &&
+                (this->Deferred ||
+                 (this->ResultReady &&
+                  this->ResultSerial > this->TakenSerial)));
+  this->Mutex.Unlock();
+
+  return ready;
+}
+
+//----------------------------------------------------------------------------
+// Check a binding (mode, pickFlags, modifier, item) against the state.
+// The following rules are used to resolve a binding:
+//
+// 1) the mode must match the binding exactly
+//
+// 2) all bits of each of the PROP3D and PLANE sections of the pick
+//    flags must have a matching bit in the binding, unless that section
+//    of the binding is empty.
+//
+// 3) the modifier bits must include all bits in the binding.
+//
+// The first binding that matches is used.
+inline bool vtkToolCursorBindingMatches(
+  const int tuple[4], int mode, int propType, int planeType, int modifier)
+{
+  return (tuple[0] == mode &&
+          ((tuple[1] & VTK_TOOL_PROP3D) == 0 ||
+           (propType != 0 && (tuple[1] & propType) == propType)) &&
+          ((tuple[1] & VTK_TOOL_PLANE) == 0 ||
+           (planeType != 0 && (tuple[1] & planeType) == planeType)) &&
+          (tuple[2] & modifier) == tuple[2]);
+}
+
+//----------------------------------------------------------------------------
+// A binding (mode, pickFlags, modifier, item), as stored in the arrays.
+struct vtkToolCursorBinding
+{
+  int Tuple[4];
+};
+
+//----------------------------------------------------------------------------
+// Order the bindings by mode only.
+inline bool vtkToolCursorBindingModeLess(
+  const vtkToolCursorBinding &a, const vtkToolCursorBinding &b)
+{
+  return (a.Tuple[0] < b.Tuple[0]);
+}
+
+//----------------------------------------------------------------------------
+// A lookup table that is compiled from an array of bindings, so that
+// the binding for any state can be found without searching the array.
+// For each mode, the table is indexed by the PROP3D and PLANE sections
+// of the pick flags and by those modifier bits that are used by the
+// bindings for that mode.
+class vtkToolCursorBindingTable
 {
 public:
-  static vtkToolCursorRenderCommand *New(vtkToolCursor *cursor) {
-    return new vtkToolCursorRenderCommand(cursor); };
+  static vtkToolCursorBindingTable *New() {
+    return new vtkToolCursorBindingTable; };
 
-  virtual void Execute(vtkObject *, unsigned long, void *) {
-    this->Cursor->OnRender(); };
+  void Delete() {
+    delete this; };
 
-protected:
-  vtkToolCursorRenderCommand(vtkToolCursor *cursor) {
-    this->Cursor = cursor; };
+  // Indicate that the bindings have changed.
+  void Modified() {
+    this->NeedsBuild = true; };
 
-  vtkToolCursor* Cursor;
+  // Find the index of the first binding that matches, or -1.
+  int Resolve(vtkIntArray *array, int mode, int pickFlags, int modifier) {
+    const ModeTable *table = this->GetModeTable(array, mode);
+    return (table ? table->First[table->Index(pickFlags, modifier)] : -1); };
+
+  // Get all the modifier bits of all the bindings that match.
+  int GetModifierBits(
+    vtkIntArray *array, int mode, int pickFlags, int modifier) {
+    const ModeTable *table = this->GetModeTable(array, mode);
+    return (table ? table->Bits[table->Index(pickFlags, modifier)] : 0); };
 
 private:
-  static vtkToolCursorRenderCommand *New(); // Not implemented.
-  vtkToolCursorRenderCommand(); // Not implemented.
-  vtkToolCursorRenderCommand(const vtkToolCursorRenderCommand&);  // Not implemented.
-  void operator=(const vtkToolCursorRenderCommand&);  // Not implemented.
+  class ModeTable
+  {
+  public:
+    std::vector<int> ModifierBits;
+    std::vector<int> First;
+    std::vector<int> Bits;
+
+    // Compute the table index, the pick flags give the high bits
+    // and the modifier gives the low bits.
+    int Index(int pickFlags, int modifier) const {
+      int n = static_cast<int>(this->ModifierBits.size());
+      int index = (((pickFlags & VTK_TOOL_PROP3D) >> 6) |
+                   ((pickFlags & VTK_TOOL_PLANE) >> 12));
+      for (int j = 0; j < n; j++) {
+        index = (index << 1) | ((modifier >> this->ModifierBits[j]) & 1); }
+      return index; };
+  };
+
+  typedef std::map<int, ModeTable> MapType;
+  MapType Tables;
+  bool NeedsBuild;
+
+  vtkToolCursorBindingTable() : NeedsBuild(true) {};
+
+  const ModeTable *GetModeTable(vtkIntArray *array, int mode) {
+    if (this->NeedsBuild) { this->Build(array); }
+    MapType::const_iterator iter = this->Tables.find(mode);
+    return (iter == this->Tables.end() ? 0 : &iter->second); };
+
+  void Build(vtkIntArray *array);
+};
+
+//----------------------------------------------------------------------------
+void vtkToolCursorBindingTable::Build(vtkIntArray *array)
+{
+  this->Tables.clear();
+  this->NeedsBuild = false;
+
+  int n = array->GetNumberOfTuples();
+  const int *bindings = array->GetPointer(0);
+
+  // Make a list of the bindings for each mode, in the order in which
+  // they are searched
+  typedef std::map<int, std::vector<int> > ListMap;
+  ListMap lists;
+  for (int i = 0; i < n; i++)
+    {
+    lists[bindings[4*i]].push_back(i);
+    }
+
+  for (ListMap::iterator liter = lists.begin();
+       liter != lists.end(); ++liter)
+    {
+    int mode = liter->first;
+    const std::vector<int> &list = liter->second;
+    int numBindings = static_cast<int>(list.size());
+
+    // Find the modifier bits that are used by this mode
+    int modifierUnion = 0;
+    for (int r = 0; r < numBindings; r++)
+      {
+      modifierUnion |= bindings[4*list[r] + 2];
+      }
+
+    ModeTable &table = this->Tables[mode];
+    for (int j = 0; j < 32; j++)
+      {
+      if ((modifierUnion >> j) & 1)
+        {
+        table.ModifierBits.push_back(j);
+        }
+      }
+
+    int m = static_cast<int>(table.ModifierBits.size());
+    int size = (64 << m);
+    table.First.assign(size, -1);
+    table.Bits.assign(size, 0);
+
+    // Check every binding against every state that can be told apart,
+    // going backwards so that the earliest matching binding is kept.
+    for (int k = 0; k < size; k++)
+      {
+      int pickFlags = (((k >> m) & 0x3C) << 6) | (((k >> m) & 0x03) << 12);
+      int propType = (pickFlags & VTK_TOOL_PROP3D);
+      int planeType = (pickFlags & VTK_TOOL_PLANE);
+      int modifier = 0;
+      for (int j = 0; j < m; j++)
+        {
+        modifier |= (((k >> (m - j - 1)) & 1) << table.ModifierBits[j]);
+        }
+
+      for (int r = numBindings - 1; r >= 0; r--)
+        {
+        const int *tuple = &bindings[4*list[r]];
+        if (vtkToolCursorBindingMatches(
+              tuple, mode, propType, planeType, modifier))
+          {
+          table.First[k] = list[r];
+          table.Bits[k] |= tuple[2];
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// The recent times for each of the timed stages, kept in ring buffers.
+class vtkToolCursorLatencyHistory
+{
+public:
+  static vtkToolCursorLatencyHistory *New() {
+    return new vtkToolCursorLatencyHistory; };
+
+  void Delete() {
+    delete this; };
+
+  void SetSize(int size);
+  int GetSize() { return this->Size; };
+  void Reset();
+
+  void Add(int stage, double t) {
+    this->Times[stage][this->Next[stage]] = t;
+    this->Next[stage] = (this->Next[stage] + 1) % this->Size;
+    if (this->Count[stage] < this->Size) { this->Count[stage]++; } };
+
+  int GetCount(int stage) { return this->Count[stage]; };
+  double GetPercentile(int stage, double percentile);
+
+private:
+  int Size;
+  int Count[VTK_TOOL_NUMBER_OF_STAGES];
+  int Next[VTK_TOOL_NUMBER_OF_STAGES];
+  std::vector<double> Times[VTK_TOOL_NUMBER_OF_STAGES];
+
+  vtkToolCursorLatencyHistory() { this->SetSize(256); };
 };
 
+//----------------------------------------------------------------------------
+void vtkToolCursorLatencyHistory::SetSize(int size)
+{
+  this->Size = size;
+  for (int i = 0; i < VTK_TOOL_NUMBER_OF_STAGES; i++)
+    {
+    this->Times[i].assign(size, 0.0);
+    }
+  this->Reset();
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursorLatencyHistory::Reset()
+{
+  for (int i = 0; i < VTK_TOOL_NUMBER_OF_STAGES; i++)
+    {
+    this->Count[i] = 0;
+    this->Next[i] = 0;
+    }
+}
+
+//----------------------------------------------------------------------------
+double vtkToolCursorLatencyHistory::GetPercentile(
+  int stage, double percentile)
+{
+  int n = this->Count[stage];
+  if (n == 0)
+    {
+    return 0.0;
+    }
+
+  // Use the nearest-rank method, the buffer itself is not reordered
+  std::vector<double> times(this->Times[stage].begin(),
+                            this->Times[stage].begin() + n);
+  int k = vtkMath::Ceil(percentile*0.01*n) - 1;
+  k = (k < 0 ? 0 : (k >= n ? n - 1 : k));
+  std::nth_element(times.begin(), times.begin() + k, times.end());
+
+  return times[k];
+}
+
 //----------------------------------------------------------------------------
 vtkToolCursor::vtkToolCursor()
 {
@@ -122,6 +1715,22 @@ vtkToolCursor::vtkToolCursor()
   this->ActionButton = 0;
   this->Scale = 1.0;
 
+  this->PropCaching = 1;
+  this->NumberOfUpdatedProps = 0;
+  this->PropCache = vtkToolCursorPropCache::New();
+
+  this->PickCacheSize = 4;
+  this->PickCacheHits = 0;
+  this->PickCacheMisses = 0;
+  this->PickCache = vtkToolCursorPickCache::New();
+  this->PickCachePickerMTime = 0;
+
+  this->AsynchronousPicking = 0;
+  this->PickWorker = 0;
+
+  this->LatencyTiming = 0;
+  this->LatencyHistory = vtkToolCursorLatencyHistory::New();
+
   this->Actor = vtkActor::New();
   this->Matrix = vtkMatrix4x4::New();
   this->Mapper = vtkDataSetMapper::New();
@@ -137,7 +1746,9 @@ vtkToolCursor::vtkToolCursor()
   this->ActionBindings = vtkIntArray::New();
   this->ActionBindings->SetName("ActionBindings");
   this->ActionBindings->SetNumberOfComponents(4);
-  this->Picker = vtkVolumePicker::New();
+  this->ShapeBindingTable = vtkToolCursorBindingTable::New();
+  this->ActionBindingTable = vtkToolCursorBindingTable::New();
+  this->Picker = vtkToolCursorPicker::New();
 
   this->LookupTable->SetRampToLinear();
   this->LookupTable->SetTableRange(0,255);
@@ -185,6 +1796,10 @@ vtkToolCursor::vtkToolCursor()
   this->ClipOutlineFilter->SetInputConnection(
     this->VolumeCroppingSource->GetOutputPort());
 
+  // The planes are reused so that the outline is only clipped again
+  // when a plane or the prop's matrix changes
+  this->ClipOutlinePlanes = vtkPlaneCollection::New();
+
   this->VolumeCroppingMapper = vtkDataSetMapper::New();
   this->VolumeCroppingMapper->SetInputConnection(
     this->ClipOutlineFilter->GetOutputPort());
@@ -195,14 +1810,22 @@ vtkToolCursor::vtkToolCursor()
   this->VolumeCroppingActor->SetVisibility(0);
   this->VolumeCroppingActor->GetProperty()->BackfaceCullingOn();
 
-  // Plane guide actor items
-  this->SliceOutlineSource = vtkVolumeOutlineSource::New();
-  this->SliceOutlineSource->GenerateFacesOn();
-  this->SliceOutlineSource->GenerateScalarsOn();
+  // Plane guide actor items, the box is only rebuilt when the bounds
+  // of the image or the active plane changes
+  this->SliceOutlineBox = vtkPolyData::New();
+  for (int i = 0; i < 6; i++)
+    {
+    this->SliceOutlineBounds[i] = 0.0;
+    }
+  this->SliceOutlineActivePlaneId = -1;
+
+  vtkFollowerPlane *slicePlane = vtkFollowerPlane::New();
+  slicePlane->InvertFollowMatrixOn();
 
   this->SliceOutlineCutter = vtkCutter::New();
-  this->SliceOutlineCutter->SetInputConnection(
-    this->SliceOutlineSource->GetOutputPort());
+  this->SliceOutlineCutter->SET_INPUT_DATA(this->SliceOutlineBox);
+  this->SliceOutlineCutter->SetCutFunction(slicePlane);
+  slicePlane->Delete();
 
   this->SliceOutlineTriangleFilter = vtkTriangleFilter::New();
   this->SliceOutlineTriangleFilter->PassVertsOff();
@@ -228,43 +1851,244 @@ vtkToolCursor::vtkToolCursor()
   this->SliceOutlineActor->GetProperty()->SetDiffuse(0.0);
   this->SliceOutlineActor->GetProperty()->SetColor(0,1,0);
 
-  // For debugging triangularization: show poly outlines
-  //this->ClipOutlineFilter->GenerateFacesOn();
-  //this->VolumeCroppingActor->GetProperty()->SetRepresentationToWireframe();
+  // For debugging triangularization: show poly outlines
+  //this->ClipOutlineFilter->GenerateFacesOn();
+  //this->VolumeCroppingActor->GetProperty()->SetRepresentationToWireframe();
+}
+
+//----------------------------------------------------------------------------
+vtkToolCursor::~vtkToolCursor()
+{
+  // Stop the pick thread before anything else is deleted
+  if (this->PickWorker) { this->PickWorker->Delete(); }
+
+  this->SetRenderer(0);
+
+  if (this->VolumeCroppingActor) { this->VolumeCroppingActor->Delete(); }
+  if (this->VolumeCroppingMapper) { this->VolumeCroppingMapper->Delete(); }
+  if (this->ClipOutlineFilter) { this->ClipOutlineFilter->Delete(); }
+  if (this->ClipOutlinePlanes) { this->ClipOutlinePlanes->Delete(); }
+  if (this->VolumeCroppingSource) { this->VolumeCroppingSource->Delete(); }
+
+  if (this->SliceOutlineActor) { this->SliceOutlineActor->Delete(); }
+  if (this->SliceOutlineMapper) { this->SliceOutlineMapper->Delete(); }
+  if (this->SliceOutlineTube) { this->SliceOutlineTube->Delete(); }
+  if (this->SliceOutlineCutter) { this->SliceOutlineCutter->Delete(); }
+  if (this->SliceOutlineBox) { this->SliceOutlineBox->Delete(); }
+
+  if (this->RenderCommand) { this->RenderCommand->Delete(); }
+  if (this->Matrix) { this->Matrix->Delete(); }
+  if (this->Shapes) { this->Shapes->Delete(); }
+  if (this->Actions) { this->Actions->Delete(); }
+  if (this->ShapeBindings) { this->ShapeBindings->Delete(); }
+  if (this->ActionBindings) { this->ActionBindings->Delete(); }
+  if (this->ShapeBindingTable) { this->ShapeBindingTable->Delete(); }
+  if (this->ActionBindingTable) { this->ActionBindingTable->Delete(); }
+  if (this->Mapper) { this->Mapper->Delete(); }
+  if (this->LookupTable) { this->LookupTable->Delete(); }
+  if (this->Actor) { this->Actor->Delete(); }
+  if (this->Picker) { this->Picker->Delete(); }
+  if (this->PropCache) { this->PropCache->Delete(); }
+  if (this->PickCache) { this->PickCache->Delete(); }
+  if (this->LatencyHistory) { this->LatencyHistory->Delete(); }
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursor::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "PropCaching: "
+     << (this->PropCaching ? "On\n" : "Off\n");
+  os << indent << "NumberOfUpdatedProps: "
+     << this->NumberOfUpdatedProps << "\n";
+  os << indent << "PickCacheSize: " << this->PickCacheSize << "\n";
+  os << indent << "PickCacheHits: " << this->PickCacheHits << "\n";
+  os << indent << "PickCacheMisses: " << this->PickCacheMisses << "\n";
+  os << indent << "AsynchronousPicking: "
+     << (this->AsynchronousPicking ? "On\n" : "Off\n");
+  os << indent << "LatencyTiming: "
+     << (this->LatencyTiming ? "On\n" : "Off\n");
+  os << indent << "LatencyHistorySize: "
+     << this->LatencyHistory->GetSize() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursor::SetLatencyTiming(int val)
+{
+  val = (val != 0);
+  if (this->LatencyTiming != val)
+    {
+    this->LatencyTiming = val;
+    this->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursor::SetLatencyHistorySize(int size)
+{
+  size = (size > 1 ? size : 1);
+  if (this->LatencyHistory->GetSize() != size)
+    {
+    this->LatencyHistory->SetSize(size);
+    this->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkToolCursor::GetLatencyHistorySize()
+{
+  return this->LatencyHistory->GetSize();
+}
+
+//----------------------------------------------------------------------------
+double vtkToolCursor::GetStageLatency(int stage, double percentile)
+{
+  if (stage < 0 || stage >= VTK_TOOL_NUMBER_OF_STAGES)
+    {
+    vtkErrorMacro("GetStageLatency: illegal stage " << stage);
+    return 0.0;
+    }
+
+  return this->LatencyHistory->GetPercentile(stage, percentile);
+}
+
+//----------------------------------------------------------------------------
+int vtkToolCursor::GetNumberOfStageLatencies(int stage)
+{
+  if (stage < 0 || stage >= VTK_TOOL_NUMBER_OF_STAGES)
+    {
+    vtkErrorMacro("GetNumberOfStageLatencies: illegal stage " << stage);
+    return 0;
+    }
+
+  return this->LatencyHistory->GetCount(stage);
+}
+
+//----------------------------------------------------------------------------
+const char *vtkToolCursor::GetStageName(int stage)
+{
+  static const char *names[VTK_TOOL_NUMBER_OF_STAGES] = {
+    "UpdatePropsForPick", "Pick", "ComputePickFlags",
+    "CheckGuideVisibility", "ConstrainCursor", "DoAction",
+    "Render", "Frame" };
+
+  if (stage < 0 || stage >= VTK_TOOL_NUMBER_OF_STAGES)
+    {
+    return 0;
+    }
+
+  return names[stage];
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursor::AddStageLatency(int stage, double seconds)
+{
+  if (this->LatencyTiming &&
+      stage >= 0 && stage < VTK_TOOL_NUMBER_OF_STAGES)
+    {
+    this->LatencyHistory->Add(stage, seconds);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursor::ResetLatencyStatistics()
+{
+  this->LatencyHistory->Reset();
+}
+
+//----------------------------------------------------------------------------
+double vtkToolCursor::StartStage()
+{
+  return (this->LatencyTiming ? vtkTimerLog::GetUniversalTime() : 0.0);
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursor::EndStage(int stage, double startTime)
+{
+  if (this->LatencyTiming)
+    {
+    this->LatencyHistory->Add(
+      stage, vtkTimerLog::GetUniversalTime() - startTime);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursor::SetPickCacheSize(int size)
+{
+  size = (size > 0 ? size : 0);
+  if (this->PickCacheSize != size)
+    {
+    this->PickCacheSize = size;
+    this->PickCache->Clear();
+    this->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursor::ClearPickCache()
+{
+  this->PickCache->Clear();
+  if (this->PickWorker)
+    {
+    this->PickWorker->Invalidate();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursor::ResetPickCacheCounters()
+{
+  this->PickCacheHits = 0;
+  this->PickCacheMisses = 0;
 }
 
 //----------------------------------------------------------------------------
-vtkToolCursor::~vtkToolCursor()
+void vtkToolCursor::SetAsynchronousPicking(int val)
 {
-  this->SetRenderer(0);
+  val = (val != 0);
+  if (this->AsynchronousPicking == val)
+    {
+    return;
+    }
 
-  if (this->VolumeCroppingActor) { this->VolumeCroppingActor->Delete(); }
-  if (this->VolumeCroppingMapper) { this->VolumeCroppingMapper->Delete(); }
-  if (this->ClipOutlineFilter) { this->ClipOutlineFilter->Delete(); }
-  if (this->VolumeCroppingSource) { this->VolumeCroppingSource->Delete(); }
+  this->AsynchronousPicking = val;
 
-  if (this->SliceOutlineActor) { this->SliceOutlineActor->Delete(); }
-  if (this->SliceOutlineMapper) { this->SliceOutlineMapper->Delete(); }
-  if (this->SliceOutlineTube) { this->SliceOutlineTube->Delete(); }
-  if (this->SliceOutlineCutter) { this->SliceOutlineCutter->Delete(); }
-  if (this->SliceOutlineSource) { this->SliceOutlineSource->Delete(); }
+  if (val)
+    {
+    this->PickWorker = vtkToolCursorPickWorker::New();
+    this->PickWorker->Start();
+    }
+  else if (this->PickWorker)
+    {
+    this->PickWorker->Delete();
+    this->PickWorker = 0;
+    }
 
-  if (this->RenderCommand) { this->RenderCommand->Delete(); }
-  if (this->Matrix) { this->Matrix->Delete(); }
-  if (this->Shapes) { this->Shapes->Delete(); }
-  if (this->Actions) { this->Actions->Delete(); }
-  if (this->ShapeBindings) { this->ShapeBindings->Delete(); }
-  if (this->ActionBindings) { this->ActionBindings->Delete(); }
-  if (this->Mapper) { this->Mapper->Delete(); }
-  if (this->LookupTable) { this->LookupTable->Delete(); }
-  if (this->Actor) { this->Actor->Delete(); }
-  if (this->Picker) { this->Picker->Delete(); }
+  this->Modified();
 }
 
 //----------------------------------------------------------------------------
-void vtkToolCursor::PrintSelf(ostream& os, vtkIndent indent)
+int vtkToolCursor::GetAsynchronousPickPending()
 {
-  this->Superclass::PrintSelf(os,indent);
+  return (this->PickWorker && this->PickWorker->IsPending());
+}
+
+//----------------------------------------------------------------------------
+int vtkToolCursor::GetAsynchronousPickCompleted()
+{
+  return (this->PickWorker && this->PickWorker->IsReady());
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursor::SetPropCaching(int val)
+{
+  val = (val != 0);
+  if (this->PropCaching != val)
+    {
+    this->PropCaching = val;
+    this->PropCache->Clear();
+    this->Modified();
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -391,6 +2215,7 @@ void vtkToolCursor::BindShape(int shape, int mode,
                                  int pickFlags, int modifier)
 {
   this->AddBinding(this->ShapeBindings, shape, mode, pickFlags, modifier);
+  this->ShapeBindingTable->Modified();
 }
 
 //----------------------------------------------------------------------------
@@ -398,42 +2223,65 @@ void vtkToolCursor::BindAction(int action, int mode,
                                   int pickFlags, int modifier)
 {
   this->AddBinding(this->ActionBindings, action, mode, pickFlags, modifier);
+  this->ActionBindingTable->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursor::BindShapes(vtkIntArray *bindings)
+{
+  if (bindings == 0 || bindings->GetNumberOfComponents() != 4)
+    {
+    vtkErrorMacro("BindShapes: bindings must have four components");
+    return;
+    }
+
+  this->AddBindings(this->ShapeBindings, bindings->GetPointer(0),
+                    bindings->GetNumberOfTuples());
+  this->ShapeBindingTable->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursor::BindActions(vtkIntArray *bindings)
+{
+  if (bindings == 0 || bindings->GetNumberOfComponents() != 4)
+    {
+    vtkErrorMacro("BindActions: bindings must have four components");
+    return;
+    }
+
+  this->AddBindings(this->ActionBindings, bindings->GetPointer(0),
+                    bindings->GetNumberOfTuples());
+  this->ActionBindingTable->Modified();
 }
 
 //----------------------------------------------------------------------------
 int vtkToolCursor::FindShape(int mode, int pickFlags, int modifier)
 {
-  // Search the shape bindings and return the first match
+  // Look up the first matching shape binding
 
-  int i = this->ResolveBinding(this->ShapeBindings, 0,
-                               mode, pickFlags, modifier);
+  int i = this->ShapeBindingTable->Resolve(this->ShapeBindings,
+                                           mode, pickFlags, modifier);
   if (i < 0)
     {
     return 0;
     }
 
-  int tuple[4];
-  this->ShapeBindings->GetTupleValue(i, tuple);
-
-  return tuple[3];
+  return this->ShapeBindings->GetValue(4*i + 3);
 }
 
 //----------------------------------------------------------------------------
 int vtkToolCursor::FindAction(int mode, int pickFlags, int modifier)
 {
-  // Search the action bindings and return the first match
+  // Look up the first matching action binding
 
-  int i = this->ResolveBinding(this->ActionBindings, 0,
-                               mode, pickFlags, modifier);
+  int i = this->ActionBindingTable->Resolve(this->ActionBindings,
+                                            mode, pickFlags, modifier);
   if (i < 0)
     {
     return 0;
     }
 
-  int tuple[4];
-  this->ActionBindings->GetTupleValue(i, tuple);
-
-  return tuple[3];
+  return this->ActionBindings->GetValue(4*i + 3);
 }
 
 //----------------------------------------------------------------------------
@@ -442,22 +2290,10 @@ int vtkToolCursor::FindActionButtons(int mode, int pickFlags, int modifier)
   // Find all matching actions and return a bitmask of the mouse buttons
   // for those actions.
 
-  int modifierMask = 0;
   modifier |= (VTK_TOOL_BUTTON_MASK | VTK_TOOL_WHEEL_MASK);
 
-  int tuple[4];
-  int j = 0;
-  for (;;)
-    {
-    int i = this->ResolveBinding(this->ActionBindings, j,
-                                 mode, pickFlags, modifier);
-    if (i < 0) { break; }
-
-    this->ActionBindings->GetTupleValue(i, tuple);
-    modifierMask |= tuple[2];
-
-    j = i + 1;
-    }
+  int modifierMask = this->ActionBindingTable->GetModifierBits(
+    this->ActionBindings, mode, pickFlags, modifier);
 
   return (modifierMask & (VTK_TOOL_BUTTON_MASK | VTK_TOOL_WHEEL_MASK));
 }
@@ -480,6 +2316,13 @@ void vtkToolCursor::SetRenderer(vtkRenderer *renderer)
     this->Renderer = 0;
     }
 
+  this->PropCache->Clear();
+  this->PickCache->Clear();
+  if (this->PickWorker)
+    {
+    this->PickWorker->Invalidate();
+    }
+
   if (renderer)
     {
     this->Renderer = renderer;
@@ -525,10 +2368,16 @@ void vtkToolCursor::GetColor(int i, double rgb[3])
 
 //----------------------------------------------------------------------------
 void vtkToolCursor::UpdatePropsForPick(vtkPicker *picker,
-                                          vtkRenderer *renderer)
+                                       vtkRenderer *renderer)
 {
   // Go through all Prop3Ds that might be picked and update their data.
   // This is necessary if any data has changed since the last render.
+  // Props whose pipelines haven't changed since they were last updated
+  // are skipped, unless PropCaching is off.
+
+  vtkToolCursorPropCache *cache = this->PropCache;
+  cache->NewGeneration();
+  this->NumberOfUpdatedProps = 0;
 
   vtkPropCollection *props;
   if ( picker->GetPickFromList() )
@@ -545,6 +2394,16 @@ void vtkToolCursor::UpdatePropsForPick(vtkPicker *picker,
   props->InitTraversal(pit);
   while ( (prop = props->GetNextProp(pit)) )
     {
+    // Skip the cursor's own actors, they change with every pick
+    if (prop == this->Actor || prop == this->VolumeCroppingActor ||
+        prop == this->SliceOutlineActor)
+      {
+      continue;
+      }
+
+    // Changes to visibility or pickability also change the scene
+    cache->AddToSceneMTime(prop->GetMTime());
+
     vtkAssemblyPath *path;
     prop->InitPathTraversal();
     while ( (path = prop->GetNextPath()) )
@@ -558,17 +2417,31 @@ void vtkToolCursor::UpdatePropsForPick(vtkPicker *picker,
       vtkActor *actor;
       vtkVolume *volume;
       vtkImageActor *imageActor;
+      vtkImageSlice *imageSlice;
+
+      cache->AddToSceneMTime(anyProp->GetMTime());
+
+      // The display extent is only used as a key for image actors
+      int noExtent[6] = { 0, -1, 0, -1, 0, -1 };
 
       if ( (actor = vtkActor::SafeDownCast(anyProp)) )
         {
         vtkDataSet *data = actor->GetMapper()->GetInput();
         if (data)
           {
+          vtkAlgorithm *alg = actor->GetMapper();
+          if (this->PropCaching &&
+              cache->IsCurrent(anyProp, alg, noExtent))
+            {
+            continue;
+            }
 #if VTK_MAJOR_VERSION >= 6
           actor->GetMapper()->Update();
 #else
           data->Update();
 #endif
+          cache->Store(anyProp, alg, noExtent);
+          this->NumberOfUpdatedProps++;
           }
         }
       else if ( (volume = vtkVolume::SafeDownCast(anyProp)) )
@@ -576,6 +2449,12 @@ void vtkToolCursor::UpdatePropsForPick(vtkPicker *picker,
         vtkDataSet *data = volume->GetMapper()->GetDataSetInput();
         if (data)
           {
+          vtkAlgorithm *alg = volume->GetMapper();
+          if (this->PropCaching &&
+              cache->IsCurrent(anyProp, alg, noExtent))
+            {
+            continue;
+            }
 #if VTK_MAJOR_VERSION >= 6
           volume->GetMapper()->UpdateInformation();
           volume->GetMapper()->SetUpdateExtentToWholeExtent();
@@ -585,6 +2464,8 @@ void vtkToolCursor::UpdatePropsForPick(vtkPicker *picker,
           data->SetUpdateExtentToWholeExtent();
           data->Update();
 #endif
+          cache->Store(anyProp, alg, noExtent);
+          this->NumberOfUpdatedProps++;
           }
         }
       else if ( (imageActor = vtkImageActor::SafeDownCast(anyProp)) )
@@ -592,7 +2473,21 @@ void vtkToolCursor::UpdatePropsForPick(vtkPicker *picker,
         vtkImageData *data = imageActor->GetInput();
         if (data)
           {
-          int extent[6], wextent[6], dextent[6];
+          int extent[6], wextent[6], dextent[6], dkey[6];
+          imageActor->GetDisplayExtent(dextent);
+          for (int i = 0; i < 6; i++) { dkey[i] = dextent[i]; }
+#if VTK_MAJOR_VERSION >= 6
+          vtkAlgorithm *alg = imageActor->GetMapper();
+#else
+          vtkAlgorithm *alg = data->GetProducerPort()->GetProducer();
+#endif
+          // The image data can be modified in place, without changing
+          // the MTime of its producer
+          if (this->PropCaching &&
+              cache->IsCurrent(anyProp, alg, dkey, data))
+            {
+            continue;
+            }
 #if VTK_MAJOR_VERSION >= 6
           imageActor->GetMapper()->UpdateInformation();
           data->GetExtent(extent);
@@ -610,7 +2505,6 @@ void vtkToolCursor::UpdatePropsForPick(vtkPicker *picker,
           data->GetExtent(extent);
           data->GetWholeExtent(wextent);
 #endif
-          imageActor->GetDisplayExtent(dextent);
           if (dextent[0] == -1)
             {
             for (int i = 0; i < 6; i++) { extent[i] = wextent[i]; }
@@ -642,10 +2536,21 @@ void vtkToolCursor::UpdatePropsForPick(vtkPicker *picker,
           data->PropagateUpdateExtent();
           data->UpdateData();
 #endif
+          cache->Store(anyProp, alg, dkey, data);
+          this->NumberOfUpdatedProps++;
           }
         }
+      else if ( (imageSlice = vtkImageSlice::SafeDownCast(anyProp)) )
+        {
+        // Image slices are not updated, but their slice planes can move
+        cache->AddToSceneMTime(
+          vtkToolCursorPropCache::GetPipelineMTime(imageSlice->GetMapper()));
+        }
       }
     }
+
+  // Forget about any props that are no longer pickable
+  cache->RemoveStaleEntries();
 }
 
 //----------------------------------------------------------------------------
@@ -786,8 +2691,136 @@ int vtkToolCursor::ComputePickFlags(vtkVolumePicker *picker)
   return pickFlags;
 }
 
+//----------------------------------------------------------------------------
+void vtkToolCursor::ComputePickCacheKey(unsigned long key[7])
+{
+  // This must be called after UpdatePropsForPick(), so that the scene
+  // MTime will include any changes to the data
+  vtkPropCollection *props = this->Renderer->GetViewProps();
+  if (this->Picker->GetPickFromList())
+    {
+    props = this->Picker->GetPickList();
+    }
+
+  int *size = this->Renderer->GetSize();
+  int *origin = this->Renderer->GetOrigin();
+
+  key[0] = this->Renderer->GetActiveCamera()->GetMTime();
+  key[1] = props->GetMTime();
+  key[2] = this->PropCache->GetSceneMTime();
+  key[3] = static_cast<unsigned long>(size[0]);
+  key[4] = static_cast<unsigned long>(size[1]);
+  key[5] = static_cast<unsigned long>(origin[0]);
+  key[6] = static_cast<unsigned long>(origin[1]);
+}
+
+//----------------------------------------------------------------------------
+int vtkToolCursor::AsynchronousPick(
+  int x, int y, const unsigned long key[7], vtkToolCursorPickResult *result)
+{
+  vtkToolCursorPickWorker *worker = this->PickWorker;
+  vtkToolCursorPickScene *scene = worker->GetScene();
+  vtkToolCursorPicker *picker =
+    static_cast<vtkToolCursorPicker *>(this->Picker);
+
+  // Take the newest pick that the worker has completed, it can only be
+  // used if the scene and the view have not changed since the request
+  vtkToolCursorPickResult newResult;
+  unsigned long newKey[VTK_TOOL_PICK_CACHE_KEY_SIZE];
+  vtkProp *prop = 0;
+  double seconds = 0.0;
+  if (worker->TakeResult(&newResult, &prop, newKey, &seconds))
+    {
+    this->AddStageLatency(VTK_TOOL_STAGE_PICK, seconds);
+    this->PickCacheMisses++;
+    if (vtkToolCursorPickKeysEqual(newKey, key))
+      {
+      // The worker is idle, so the scene can be used
+      scene->MapResult(&newResult, prop);
+      picker->RestoreResult(&newResult);
+      double startTime = this->StartStage();
+      newResult.PickFlags = this->ComputePickFlags(picker);
+      this->EndStage(VTK_TOOL_STAGE_PICK_FLAGS, startTime);
+      if (this->PickCacheSize > 0)
+        {
+        *this->PickCache->Insert(newResult.DisplayPosition[0],
+                                 newResult.DisplayPosition[1],
+                                 this->PickCacheSize) = newResult;
+        }
+      worker->LastResult = newResult;
+      worker->LastResultValid = true;
+      for (int i = 0; i < VTK_TOOL_PICK_CACHE_KEY_SIZE; i++)
+        {
+        worker->LastKey[i] = key[i];
+        }
+      }
+    }
+
+  if (worker->LastResultValid &&
+      !vtkToolCursorPickKeysEqual(worker->LastKey, key))
+    {
+    worker->LastResultValid = false;
+    }
+
+  // Start a pick at this position, unless the last result is for this
+  // position or the worker is already picking it
+  if (!(worker->LastResultValid &&
+        worker->LastResult.DisplayPosition[0] == x &&
+        worker->LastResult.DisplayPosition[1] == y) &&
+      !worker->IsRequested(x, y, key))
+    {
+    if (worker->IsBusy())
+      {
+      // Wait for the current pick, a render will start this one
+      worker->Deferred = true;
+      }
+    else
+      {
+      // The scene is only rebuilt if the props or their data changed,
+      // not when the camera moves
+      if (scene->Stale || scene->Key[0] != key[1] ||
+          scene->Key[1] != key[2])
+        {
+        vtkPropCollection *props = this->Renderer->GetViewProps();
+        if (this->Picker->GetPickFromList())
+          {
+          props = this->Picker->GetPickList();
+          }
+        vtkProp *skip[3] = {
+          this->Actor, this->VolumeCroppingActor, this->SliceOutlineActor };
+
+        scene->Build(props, this->Picker, skip);
+        scene->Key[0] = key[1];
+        scene->Key[1] = key[2];
+        }
+
+      if (!scene->Complete)
+        {
+        return -1;
+        }
+
+      scene->SetView(this->Renderer);
+      worker->Request(x, y, key);
+      }
+    }
+
+  if (!worker->LastResultValid)
+    {
+    return 0;
+    }
+
+  *result = worker->LastResult;
+  return 1;
+}
+
 //----------------------------------------------------------------------------
 void vtkToolCursor::ComputePosition()
+{
+  this->ComputePositionInternal(0);
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursor::ComputePositionInternal(int asynchronous)
 {
   if (!this->Renderer)
     {
@@ -799,11 +2832,81 @@ void vtkToolCursor::ComputePosition()
 
   // Update the props that might be picked.  This is necessary
   // if there hasn't been a Render since the last change.
+  double startTime = this->StartStage();
   this->UpdatePropsForPick(this->Picker, this->Renderer);
+  this->EndStage(VTK_TOOL_STAGE_UPDATE_PROPS, startTime);
+
+  // Do the pick, or reuse a previous pick at the same position
+  vtkToolCursorPicker *picker =
+    static_cast<vtkToolCursorPicker *>(this->Picker);
+  int pickFlags = 0;
+  int asyncStatus = -1;
+  vtkToolCursorPickResult *result = 0;
+  vtkToolCursorPickResult asyncResult;
+
+  // If the picker settings were changed, the results are invalid
+  if (picker->GetMTime() != this->PickCachePickerMTime)
+    {
+    this->PickCache->Clear();
+    if (this->PickWorker)
+      {
+      this->PickWorker->Invalidate();
+      }
+    this->PickCachePickerMTime = picker->GetMTime();
+    }
+
+  unsigned long key[VTK_TOOL_PICK_CACHE_KEY_SIZE];
+  this->ComputePickCacheKey(key);
+
+  if (this->PickCacheSize > 0)
+    {
+    this->PickCache->SetSceneKey(key);
+    result = this->PickCache->Find(x, y);
+    }
+
+  if (result)
+    {
+    picker->RestoreResult(result);
+    pickFlags = result->PickFlags;
+    this->PickCacheHits++;
+    }
+  else if (asynchronous && this->PickWorker &&
+           (asyncStatus = this->AsynchronousPick(x, y, key,
+                                                 &asyncResult)) >= 0)
+    {
+    if (asyncStatus == 0)
+      {
+      // Keep the previous position until a pick completes
+      return;
+      }
+    picker->RestoreResult(&asyncResult);
+    pickFlags = asyncResult.PickFlags;
+    }
+  else
+    {
+    // Results of earlier asynchronous picks are now out of date
+    if (this->PickWorker)
+      {
+      this->PickWorker->Supersede();
+      }
+    startTime = this->StartStage();
+    picker->Pick(x, y, 0, this->Renderer);
+    this->EndStage(VTK_TOOL_STAGE_PICK, startTime);
+    startTime = this->StartStage();
+    pickFlags = this->ComputePickFlags(picker);
+    this->EndStage(VTK_TOOL_STAGE_PICK_FLAGS, startTime);
+    this->PickCacheMisses++;
+    if (this->PickCacheSize > 0)
+      {
+      result = this->PickCache->Insert(x, y, this->PickCacheSize);
+      picker->SaveResult(result);
+      result->PickFlags = pickFlags;
+      }
+    }
+
+  // Picking modifies the picker, so record its MTime after the pick
+  this->PickCachePickerMTime = picker->GetMTime();
 
-  // Do the pick!
-  vtkVolumePicker *picker = this->Picker;
-  picker->Pick(x, y, 0, this->Renderer);
   picker->GetPickPosition(this->Position);
   picker->GetPickNormal(this->Normal);
 
@@ -816,7 +2919,9 @@ void vtkToolCursor::ComputePosition()
 
     if (actionObject)
       {
+      startTime = this->StartStage();
       actionObject->ConstrainCursor(this->Position, this->Normal);
+      this->EndStage(VTK_TOOL_STAGE_CONSTRAIN, startTime);
       }
     }
 
@@ -832,8 +2937,6 @@ void vtkToolCursor::ComputePosition()
     }
 
   // Check to see if the PickFlags have changed
-  int pickFlags = this->ComputePickFlags(this->Picker);
-
   if ((this->Modifier & (VTK_TOOL_BUTTON_MASK | VTK_TOOL_WHEEL_MASK)) == 0 &&
       !this->Action)
     {
@@ -849,7 +2952,9 @@ void vtkToolCursor::ComputePosition()
     this->PickFlags = pickFlags;
 
     // Check to see if guide visibility should be changed
+    startTime = this->StartStage();
     this->CheckGuideVisibility();
+    this->EndStage(VTK_TOOL_STAGE_GUIDES, startTime);
     }
 
   // Compute an "up" vector for the cursor.
@@ -879,7 +2984,7 @@ void vtkToolCursor::OnRender()
 {
   // Compute the position when the Renderer renders, since it needs to
   // update all of the props in the scene.
-  this->ComputePosition();
+  this->ComputePositionInternal(this->AsynchronousPicking);
   // Don't show cursor if nothing is underneath of it.
   int visibility = (this->IsInViewport != 0 && this->Shape != 0);
   this->Actor->SetVisibility(visibility);
@@ -926,16 +3031,29 @@ void vtkToolCursor::CheckGuideVisibility()
     vtkPlaneCollection *clippingPlanes = 0;
     if (mapperPlanes)
       {
-      clippingPlanes = vtkPlaneCollection::New();
+      // Reuse the follower planes, their Set methods do nothing if
+      // the plane and matrix are the same as before
+      clippingPlanes = this->ClipOutlinePlanes;
       int n = mapperPlanes->GetNumberOfItems();
-      for (int i = 0; i < n; i++)
+      int m = clippingPlanes->GetNumberOfItems();
+      while (m > n)
+        {
+        clippingPlanes->RemoveItem(--m);
+        }
+      while (m < n)
         {
         vtkFollowerPlane *plane = vtkFollowerPlane::New();
-        plane->SetFollowPlane(mapperPlanes->GetItem(i));
-        plane->SetFollowMatrix(prop->GetMatrix());
         plane->InvertFollowMatrixOn();
         clippingPlanes->AddItem(plane);
         plane->Delete();
+        m++;
+        }
+      for (int i = 0; i < n; i++)
+        {
+        vtkFollowerPlane *plane =
+          static_cast<vtkFollowerPlane *>(clippingPlanes->GetItem(i));
+        plane->SetFollowPlane(mapperPlanes->GetItem(i));
+        plane->SetFollowMatrix(prop->GetMatrix());
         }
       }
 
@@ -945,11 +3063,6 @@ void vtkToolCursor::CheckGuideVisibility()
     this->VolumeCroppingSource->SetActivePlaneId(croppingPlaneId);
     this->ClipOutlineFilter->SetClippingPlanes(clippingPlanes);
     this->ClipOutlineFilter->SetActivePlaneId(clippingPlaneId);
-
-    if (clippingPlanes)
-      {
-      clippingPlanes->Delete();
-      }
     }
   else
     {
@@ -959,6 +3072,7 @@ void vtkToolCursor::CheckGuideVisibility()
     this->VolumeCroppingSource->SetActivePlaneId(-1);
     this->ClipOutlineFilter->SetActivePlaneId(-1);
     this->ClipOutlineFilter->SetClippingPlanes(0);
+    this->ClipOutlinePlanes->RemoveAllItems();
     }
 
   vtkImageMapper3D *imageMapper =
@@ -978,17 +3092,10 @@ void vtkToolCursor::CheckGuideVisibility()
   if (imageMapper && this->PickFlags & VTK_TOOL_IMAGE_ACTOR)
     {
     vtkFollowerPlane *plane =
-      vtkFollowerPlane::SafeDownCast(
+      static_cast<vtkFollowerPlane *>(
         this->SliceOutlineCutter->GetCutFunction());
-    if (plane == NULL)
-      {
-      plane = vtkFollowerPlane::New();
-      this->SliceOutlineCutter->SetCutFunction(plane);
-      plane->Delete();
-      }
     plane->SetFollowPlane(imageMapper->GetSlicePlane());
     plane->SetFollowMatrix(prop->GetMatrix());
-    plane->InvertFollowMatrixOn();
 
     int imageEdgeId = -1;
     if (this->PickFlags & VTK_TOOL_PLANE_EDGE)
@@ -1012,28 +3119,122 @@ void vtkToolCursor::CheckGuideVisibility()
         }
       }
 
+    // Get the bounds of the whole image, as a volume outline would
+    double bounds[6];
+    vtkImageData *data = imageMapper->GetInput();
+    if (data)
+      {
+      int extent[6];
+      double origin[3], spacing[3];
+      data->GetOrigin(origin);
+      data->GetSpacing(spacing);
+#if VTK_MAJOR_VERSION >= 6
+      data->GetExtent(extent);
+      vtkInformation *info = imageMapper->GetInputInformation(0, 0);
+      if (info &&
+          info->Has(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT()))
+        {
+        info->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), extent);
+        }
+#else
+      data->GetWholeExtent(extent);
+#endif
+      for (int jj = 0; jj < 3; jj++)
+        {
+        double b0 = origin[jj] + spacing[jj]*extent[2*jj];
+        double b1 = origin[jj] + spacing[jj]*extent[2*jj+1];
+        bounds[2*jj] = (b0 < b1 ? b0 : b1);
+        bounds[2*jj+1] = (b0 < b1 ? b1 : b0);
+        }
+      }
+    else
+      {
+      imageMapper->GetBounds(bounds);
+      }
+
     this->SliceOutlineActor->SetUserMatrix(prop->GetMatrix());
     this->SliceOutlineActor->SetVisibility(this->GuideVisibility);
-    //this->SliceOutlineSource->SetBounds(imageMapper->GetBounds());
-    // a dummy volume mapper
-    vtkVolumeRayCastMapper *vmapper = vtkVolumeRayCastMapper::New();
-    vmapper->SET_INPUT_DATA(imageMapper->GetInput());
-    this->SliceOutlineSource->SetActivePlaneId(imageEdgeId);
-    this->SliceOutlineSource->SetVolumeMapper(vmapper);
-    vmapper->Delete();
+    this->UpdateSliceOutlineBox(bounds, imageEdgeId);
     }
   else
     {
+    // Release the slice plane and matrix of the previous image
+    vtkFollowerPlane *plane =
+      static_cast<vtkFollowerPlane *>(
+        this->SliceOutlineCutter->GetCutFunction());
+    plane->SetFollowPlane(0);
+    plane->SetFollowMatrix(0);
+
     this->SliceOutlineActor->SetUserMatrix(0);
     this->SliceOutlineActor->SetVisibility(0);
-    if (this->SliceOutlineSource->GetVolumeMapper())
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursor::UpdateSliceOutlineBox(
+  const double bounds[6], int activePlaneId)
+{
+  if (this->SliceOutlineActivePlaneId == activePlaneId &&
+      this->SliceOutlineBounds[0] == bounds[0] &&
+      this->SliceOutlineBounds[1] == bounds[1] &&
+      this->SliceOutlineBounds[2] == bounds[2] &&
+      this->SliceOutlineBounds[3] == bounds[3] &&
+      this->SliceOutlineBounds[4] == bounds[4] &&
+      this->SliceOutlineBounds[5] == bounds[5] &&
+      this->SliceOutlineBox->GetNumberOfCells() > 0)
+    {
+    return;
+    }
+
+  for (int i = 0; i < 6; i++)
+    {
+    this->SliceOutlineBounds[i] = bounds[i];
+    }
+  this->SliceOutlineActivePlaneId = activePlaneId;
+
+  // Make the six faces of the box, with the same colors that
+  // vtkVolumeOutlineSource uses: red, or yellow for the active plane
+  static const int faces[6][4] = {
+    { 0, 4, 6, 2 }, { 1, 3, 7, 5 }, { 0, 1, 5, 4 },
+    { 2, 6, 7, 3 }, { 0, 2, 3, 1 }, { 4, 5, 7, 6 } };
+
+  vtkPoints *points = vtkPoints::New();
+  points->SetDataTypeToDouble();
+  points->SetNumberOfPoints(8);
+  for (int j = 0; j < 8; j++)
+    {
+    points->SetPoint(j, bounds[j & 1], bounds[2 + ((j >> 1) & 1)],
+                     bounds[4 + ((j >> 2) & 1)]);
+    }
+
+  vtkCellArray *polys = vtkCellArray::New();
+  vtkUnsignedCharArray *scalars = vtkUnsignedCharArray::New();
+  scalars->SetName("Colors");
+  scalars->SetNumberOfComponents(3);
+  for (int k = 0; k < 6; k++)
+    {
+    vtkIdType ids[4];
+    ids[0] = faces[k][0];
+    ids[1] = faces[k][1];
+    ids[2] = faces[k][2];
+    ids[3] = faces[k][3];
+    polys->InsertNextCell(4, ids);
+    unsigned char color[3] = { 255, 0, 0 };
+    if (k == activePlaneId)
       {
-      this->SliceOutlineSource->GetVolumeMapper()->
-        SET_INPUT_DATA(static_cast<vtkImageData *>(0));
+      color[1] = 255;
       }
-    this->SliceOutlineSource->SetVolumeMapper(0);
-    this->SliceOutlineCutter->SetCutFunction(0);
+    scalars->InsertNextTupleValue(color);
     }
+
+  this->SliceOutlineBox->SetPoints(points);
+  this->SliceOutlineBox->SetPolys(polys);
+  this->SliceOutlineBox->GetCellData()->SetScalars(scalars);
+  this->SliceOutlineBox->Modified();
+
+  points->Delete();
+  polys->Delete();
+  scalars->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -1068,7 +3269,9 @@ void vtkToolCursor::MoveToDisplayPosition(double x, double y)
 
     if (actionObject)
       {
+      double startTime = this->StartStage();
       actionObject->DoAction();
+      this->EndStage(VTK_TOOL_STAGE_ACTION, startTime);
       }
    }
 }
@@ -1437,127 +3640,75 @@ static void PrintFlags(int flags);
 void vtkToolCursor::AddBinding(vtkIntArray *array, int item, int mode,
                                   int pickFlags, int modifier)
 {
-  // The bindings are sorted by mode and by the number of modifier bits.
-  // Exact matches replace the previous entry.
-
-  //cerr << "AddBinding " << array->GetName() << " ";
-  //PrintFlags(pickFlags);
-  //cerr << " ";
-  //PrintModifier(modifier);
-  //cerr << " " << item << "\n";
-
-  int i = vtkToolCursor::ResolveBinding(array, 0,
-                                           mode, pickFlags, modifier);
-  int n = array->GetNumberOfTuples();
-
-  int tuple[4];
-  tuple[0] = 0;
-  tuple[1] = 0;
-  tuple[2] = 0;
-  tuple[3] = 0;
+  int binding[4];
+  binding[0] = item;
+  binding[1] = mode;
+  binding[2] = pickFlags;
+  binding[3] = modifier;
 
-  if (i >= 0)
-    {
-    // If it's an exact match, then replace
-    array->GetTupleValue(i, tuple);
-    if (tuple[0] == mode && tuple[1] == pickFlags && tuple[2] == modifier)
-      {
-      tuple[3] = item;
-      array->SetTupleValue(i, tuple);
-      return;
-      }
-    }
-  else
-    {
-    // If it wasn't resolved, then we append to the end of the list
-    i = n;
-    }
-
-  //cerr << "inserting ";
-  //cerr << item << " (" << i << " of " << (n+1) << "): " << mode << " ";
-  //PrintFlags(pickFlags);
-  //cerr << " ";
-  //PrintModifier(modifier);
-  //cerr << "\n";
-
-  // Extend array by one value.  Actually, this is just a dummy tuple,
-  // it's just the easiest way of increasing the size of the array.
-  array->InsertNextTupleValue(tuple);
-
-  //cerr << "n = " << n << " i = " << i << "\n";
-  // Shuffle values up by one
-  for (int j = n; j > i; j--)
-    {
-    array->GetTupleValue(j-1, tuple);
-    array->SetTupleValue(j, tuple);
-    }
-
-  // Set the tuple at the desired index
-  tuple[0] = mode;
-  tuple[1] = pickFlags;
-  tuple[2] = modifier;
-  tuple[3] = item;
-
-  array->SetTupleValue(i, tuple);
+  vtkToolCursor::AddBindings(array, binding, 1);
 }
 
 //----------------------------------------------------------------------------
-int vtkToolCursor::ResolveBinding(vtkIntArray *array, int start,
-                                     int mode, int pickFlags, int modifier)
+void vtkToolCursor::AddBindings(vtkIntArray *array, const int *bindings,
+                                int numBindings)
 {
-  // The following rules are used to resolve a binding:
-  //
-  // 1) the mode must match the binding exactly
-  //
-  // 2) all bits of each of the PROP3D and PLANE sections of the pick
-  //    flags must have a matching bit in the binding, unless that section
-  //    of the binding is empty.
-  //
-  // 3) the modifier bits must include all bits in the binding.
-
-  //cerr << "ResolveBinding " << array->GetName() << " ";
-  //PrintFlags(pickFlags);
-  //cerr << " ";
-  //PrintModifier(modifier);
-  //cerr << "\n";
+  // The bindings (given as item, mode, pickFlags, modifier) are added in
+  // order.  Within a mode, each new binding goes just before the first
+  // binding that matches it, i.e. before the first one that is at least
+  // as general, or at the end of the mode if none match.  Exact matches
+  // replace the previous entry.  The modes are kept in increasing order.
+  // The array is only rewritten once, after all bindings are added.
 
-  int propType = (pickFlags & VTK_TOOL_PROP3D);
-  int planeType = (pickFlags & VTK_TOOL_PLANE);
-
-  int tuple[4];
   int n = array->GetNumberOfTuples();
-  for (int i = start; i < n; i++)
+  std::vector<vtkToolCursorBinding> list(n);
+  if (n > 0)
+    {
+    memcpy(&list[0], array->GetPointer(0), 4*n*sizeof(int));
+    }
+
+  for (int k = 0; k < numBindings; k++)
     {
-    array->GetTupleValue(i, tuple);
+    const int *binding = &bindings[4*k];
+    vtkToolCursorBinding b;
+    b.Tuple[0] = binding[1];
+    b.Tuple[1] = binding[2];
+    b.Tuple[2] = binding[3];
+    b.Tuple[3] = binding[0];
 
-    //cerr << "item " << i << " of " << n << ": " << tuple[0] << " ";
-    //PrintFlags(tuple[1]);
-    //cerr << " ";
-    //PrintModifier(tuple[2]);
-    //cerr << "\n";
+    int mode = b.Tuple[0];
+    int propType = (b.Tuple[1] & VTK_TOOL_PROP3D);
+    int planeType = (b.Tuple[1] & VTK_TOOL_PLANE);
+    int modifier = b.Tuple[2];
 
-    if (tuple[0] == mode)
+    std::vector<vtkToolCursorBinding>::iterator iter =
+      std::lower_bound(list.begin(), list.end(), b,
+                       vtkToolCursorBindingModeLess);
+    std::vector<vtkToolCursorBinding>::iterator last =
+      std::upper_bound(iter, list.end(), b, vtkToolCursorBindingModeLess);
+    while (iter != last && !vtkToolCursorBindingMatches(
+             iter->Tuple, mode, propType, planeType, modifier))
       {
-      if (((tuple[1] & VTK_TOOL_PROP3D) == 0 ||
-           (propType != 0 && (tuple[1] & propType) == propType)) &&
-          ((tuple[1] & VTK_TOOL_PLANE) == 0 ||
-           (planeType != 0 && (tuple[1] & planeType) == planeType)))
-        {
-        if ((tuple[2] & modifier) == tuple[2])
-          {
-          //cerr << "resolved " << tuple[3] << "\n";
-          return i;
-          }
-        }
+      ++iter;
       }
-    else if (tuple[0] > mode)
+
+    if (iter != last && iter->Tuple[1] == b.Tuple[1] &&
+        iter->Tuple[2] == b.Tuple[2])
       {
-      break;
+      iter->Tuple[3] = b.Tuple[3];
+      }
+    else
+      {
+      list.insert(iter, b);
       }
     }
 
-  //cerr << "not resolved\n";
-  return -1;
+  n = static_cast<int>(list.size());
+  array->SetNumberOfTuples(n);
+  if (n > 0)
+    {
+    memcpy(array->GetPointer(0), &list[0], 4*n*sizeof(int));
+    }
 }
 
 /*
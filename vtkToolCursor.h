@@ -45,6 +45,13 @@ class vtkOutlineSource;
 class vtkCutter;
 class vtkTriangleFilter;
 class vtkTubeFilter;
+class vtkPlaneCollection;
+class vtkToolCursorPropCache;
+class vtkToolCursorPickCache;
+class vtkToolCursorPickResult;
+class vtkToolCursorPickWorker;
+class vtkToolCursorBindingTable;
+class vtkToolCursorLatencyHistory;
 
 // Modifier keys and mouse buttons.
 #define VTK_TOOL_SHIFT        0x0001
@@ -70,6 +77,17 @@ class vtkTubeFilter;
 #define VTK_TOOL_CROP_PLANE   0x2000
 #define VTK_TOOL_PLANE_EDGE   0x4000
 
+// Stages of cursor processing that can be timed.
+#define VTK_TOOL_STAGE_UPDATE_PROPS  0
+#define VTK_TOOL_STAGE_PICK          1
+#define VTK_TOOL_STAGE_PICK_FLAGS    2
+#define VTK_TOOL_STAGE_GUIDES        3
+#define VTK_TOOL_STAGE_CONSTRAIN     4
+#define VTK_TOOL_STAGE_ACTION        5
+#define VTK_TOOL_STAGE_RENDER        6
+#define VTK_TOOL_STAGE_FRAME         7
+#define VTK_TOOL_NUMBER_OF_STAGES    8
+
 class VTK_EXPORT vtkToolCursor : public vtkObject
 {
 public:
@@ -125,6 +143,120 @@ public:
   // information is updated.
   vtkVolumePicker *GetPicker() { return this->Picker; };
 
+  // Description:
+  // Turn on or off the caching of prop updates.  Before every pick, all
+  // of the pickable props are updated in case their data has changed.
+  // When caching is on (the default), any prop whose mapper pipeline
+  // and display extent have not changed since the previous pick will
+  // not be updated again.
+  void SetPropCaching(int val);
+  void PropCachingOn() { this->SetPropCaching(1); };
+  void PropCachingOff() { this->SetPropCaching(0); };
+  int GetPropCaching() { return this->PropCaching; };
+
+  // Description:
+  // Get the number of props that were updated during the most recent
+  // pick.  Props that were skipped by the cache are not counted.
+  int GetNumberOfUpdatedProps() { return this->NumberOfUpdatedProps; };
+
+  // Description:
+  // Set the number of pick results to keep for reuse.  When the cursor
+  // is asked to pick at a display position that it has recently picked,
+  // and neither the camera nor the props have changed, then the saved
+  // results are copied back into the picker instead of doing a new pick.
+  // Only the information about the picked prop is restored, the picker's
+  // collections of all props along the ray are not.  Call
+  // ClearPickCache() if you change the picker in a way that it cannot
+  // detect.  The default size is 4, and a size of zero disables the cache.
+  void SetPickCacheSize(int size);
+  int GetPickCacheSize() { return this->PickCacheSize; };
+  void ClearPickCache();
+
+  // Description:
+  // Get the number of picks that were satisfied by the cache, and the
+  // number of picks that required the picker to be called.  When the
+  // PickCacheSize is zero, every pick is counted as a miss.
+  int GetPickCacheHits() { return this->PickCacheHits; };
+  int GetPickCacheMisses() { return this->PickCacheMisses; };
+  void ResetPickCacheCounters();
+
+  // Description:
+  // Turn on asynchronous picking.  When this is on, the picks that are
+  // done when the renderer renders are done by a worker thread, and the
+  // cursor uses the most recent pick that has completed.  The worker
+  // picks from its own deep copy of the pickable props and their data,
+  // which is rebuilt only when the props or the data change, and the
+  // camera and window size are copied for each pick.  Only one pick is
+  // done at a time, so positions that the mouse passes over while the
+  // worker is busy are never picked.  Results are dropped if the camera
+  // or the scene has changed since they were requested, or if a newer
+  // result or a synchronous pick has been used.  ComputePosition() always
+  // does a synchronous pick, so that button presses get a fresh result.
+  // Props that cannot be copied, e.g. vtkLODProp3D, cause synchronous
+  // picks to be used.  The default is Off.
+  void SetAsynchronousPicking(int val);
+  void AsynchronousPickingOn() { this->SetAsynchronousPicking(1); };
+  void AsynchronousPickingOff() { this->SetAsynchronousPicking(0); };
+  int GetAsynchronousPicking() { return this->AsynchronousPicking; };
+
+  // Description:
+  // Check whether an asynchronous pick has been requested but has not
+  // yet been used.  GetAsynchronousPickCompleted() checks whether the
+  // worker has finished, in which case a Render() will update the cursor
+  // or start the pick that is waiting.
+  int GetAsynchronousPickPending();
+  int GetAsynchronousPickCompleted();
+
+  // Description:
+  // Turn on timing of each stage of the cursor processing.  The stages
+  // are VTK_TOOL_STAGE_UPDATE_PROPS, VTK_TOOL_STAGE_PICK,
+  // VTK_TOOL_STAGE_PICK_FLAGS, VTK_TOOL_STAGE_GUIDES, and the
+  // ConstrainCursor() and DoAction() methods of the active tool,
+  // VTK_TOOL_STAGE_CONSTRAIN and VTK_TOOL_STAGE_ACTION.  The RENDER and
+  // FRAME stages are timed by vtkToolCursorInteractorObserver.  The most
+  // recent times for each stage are kept, up to LatencyHistorySize of
+  // them, and the default is Off.
+  void SetLatencyTiming(int val);
+  void LatencyTimingOn() { this->SetLatencyTiming(1); };
+  void LatencyTimingOff() { this->SetLatencyTiming(0); };
+  int GetLatencyTiming() { return this->LatencyTiming; };
+
+  // Description:
+  // Set the number of recent times to keep for each stage.  The
+  // default is 256.  Changing this discards all of the times.
+  void SetLatencyHistorySize(int size);
+  int GetLatencyHistorySize();
+
+  // Description:
+  // Get the time in seconds that the given percentage of the recent
+  // times for a stage did not exceed, e.g. use 50, 95, or 99 for the
+  // p50, p95, or p99 latency.  Zero is returned if no times are stored.
+  double GetStageLatency(int stage, double percentile);
+  double GetStageLatencyP50(int stage) {
+    return this->GetStageLatency(stage, 50.0); };
+  double GetStageLatencyP95(int stage) {
+    return this->GetStageLatency(stage, 95.0); };
+  double GetStageLatencyP99(int stage) {
+    return this->GetStageLatency(stage, 99.0); };
+
+  // Description:
+  // Get the number of times that are stored for a stage.
+  int GetNumberOfStageLatencies(int stage);
+
+  // Description:
+  // Get a printable name for a stage.
+  static const char *GetStageName(int stage);
+
+  // Description:
+  // Add a time, in seconds, for a stage.  This is used for the stages
+  // that are timed outside of the cursor.  It does nothing unless
+  // LatencyTiming is On.
+  void AddStageLatency(int stage, double seconds);
+
+  // Description:
+  // Discard all of the stored times.
+  void ResetLatencyStatistics();
+
   // Description:
   // Get the pick flags.  The flags provide information about what was
   // under the cursor the last time that a pick was done.  The flags are
@@ -225,6 +357,17 @@ public:
   // buttons that must be held down for the shape to be shown.
   void BindShape(int shape, int mode, int pickFlags, int modifier);
 
+  // Description:
+  // Add many bindings at once.  Each tuple of the four-component array
+  // is (action or shape, mode, pickFlags, modifier).  The result is the
+  // same as calling BindAction() or BindShape() for each tuple in order,
+  // but the bindings are merged in a single pass.  The bindings are
+  // compiled into a lookup table the next time that they are used, so
+  // that the cost of finding the action or shape for each mouse event
+  // does not depend on the number of bindings.
+  void BindActions(vtkIntArray *bindings);
+  void BindShapes(vtkIntArray *bindings);
+
   // Description:
   // Set whether the mouse is in the renderer's viewport.  This controls
   // cursor visibility.  It is automatically set by SetDisplayPosition()
@@ -298,14 +441,42 @@ protected:
   vtkRenderer *Renderer;
   vtkCommand *RenderCommand;
 
+  int PropCaching;
+  int NumberOfUpdatedProps;
+  vtkToolCursorPropCache *PropCache;
+
+  int PickCacheSize;
+  int PickCacheHits;
+  int PickCacheMisses;
+  unsigned long PickCachePickerMTime;
+  vtkToolCursorPickCache *PickCache;
+
+  int AsynchronousPicking;
+  vtkToolCursorPickWorker *PickWorker;
+
+  vtkToolCursorBindingTable *ShapeBindingTable;
+  vtkToolCursorBindingTable *ActionBindingTable;
+
+  int LatencyTiming;
+  vtkToolCursorLatencyHistory *LatencyHistory;
+
+  // Description:
+  // Get the start time for a stage, or zero if timing is off.  Then
+  // call EndStage() with the start time when the stage is finished.
+  double StartStage();
+  void EndStage(int stage, double startTime);
+
   vtkActor *VolumeCroppingActor;
   vtkDataSetMapper *VolumeCroppingMapper;
   vtkVolumeOutlineSource *VolumeCroppingSource;
   vtkClipClosedSurface *ClipOutlineFilter;
+  vtkPlaneCollection *ClipOutlinePlanes;
 
   vtkActor *SliceOutlineActor;
   vtkDataSetMapper *SliceOutlineMapper;
-  vtkVolumeOutlineSource *SliceOutlineSource;
+  vtkPolyData *SliceOutlineBox;
+  double SliceOutlineBounds[6];
+  int SliceOutlineActivePlaneId;
   vtkCutter *SliceOutlineCutter;
   vtkTriangleFilter *SliceOutlineTriangleFilter;
   vtkTubeFilter *SliceOutlineTube;
@@ -328,13 +499,14 @@ protected:
   int GetShape() { return this->Shape; };
 
   void CheckGuideVisibility();
+  void UpdateSliceOutlineBox(const double bounds[6], int activePlaneId);
   int FindShape(int mode, int pickFlags, int modifier);
   int FindAction(int mode, int pickFlags, int modifier);
   int FindActionButtons(int mode, int pickFlags, int modifier);
   static void AddBinding(vtkIntArray *array, int item, int mode,
                          int pickFlags, int modifier);
-  static int ResolveBinding(vtkIntArray *array, int start,
-                            int mode, int pickFlags, int modifier);
+  static void AddBindings(vtkIntArray *array, const int *bindings,
+                          int numBindings);
   static int ComputePickFlags(vtkVolumePicker *picker);
   static double ComputeScale(const double position[3], vtkRenderer *renderer);
   static void ComputeMatrix(const double position[3], const double normal[3],
@@ -343,7 +515,19 @@ protected:
                                       const double normal[3], double vector[3],
                                       vtkRenderer *renderer, int cursorFlags);
 
-  static void UpdatePropsForPick(vtkPicker *picker, vtkRenderer *renderer);
+  void UpdatePropsForPick(vtkPicker *picker, vtkRenderer *renderer);
+  void ComputePickCacheKey(unsigned long key[7]);
+
+  // Description:
+  // Use the worker thread to pick.  The return value is 1 if a result
+  // is available, 0 if no pick has completed yet, or -1 if the props
+  // cannot be copied and a synchronous pick must be done.
+  int AsynchronousPick(int x, int y, const unsigned long key[7],
+                       vtkToolCursorPickResult *result);
+
+  // Description:
+  // Compute the position, with an asynchronous pick if requested.
+  void ComputePositionInternal(int asynchronous);
 
 private:
   vtkToolCursor(const vtkToolCursor&);  //Not implemented
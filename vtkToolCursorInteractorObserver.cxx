@@ -21,6 +21,7 @@
 #include "vtkRenderWindow.h"
 #include "vtkRenderer.h"
 #include "vtkCallbackCommand.h"
+#include "vtkTimerLog.h"
 
 vtkStandardNewMacro(vtkToolCursorInteractorObserver);
 
@@ -32,6 +33,21 @@ vtkToolCursorInteractorObserver::vtkToolCursorInteractorObserver()
   // The surface cursor that this object handles the events for
   this->ToolCursor = 0;
 
+  // Mouse motion is coalesced so that renders stay within this budget
+  this->FrameBudget = 1.0/60.0;
+  this->RenderTimerId = -1;
+  this->PickTimerId = -1;
+  this->MovePending = 0;
+  this->PendingPosition[0] = 0;
+  this->PendingPosition[1] = 0;
+  this->PendingMoveTime = 0.0;
+  this->LastRenderTime = 0.0;
+  this->NumberOfCoalescedEvents = 0;
+  this->FrameRate = 0.0;
+  this->FrameCount = 0;
+  this->FrameRateStartTime = 0.0;
+  this->FrameStartTime = 0.0;
+
   // Set priority to be higher than the InteractorStyle
   this->Priority = 0.1;
 
@@ -64,6 +80,64 @@ void vtkToolCursorInteractorObserver::PrintSelf(ostream& os,
   this->Superclass::PrintSelf(os,indent);
 
   os << indent << "ToolCursor: " << this->ToolCursor << "\n";
+  os << indent << "FrameBudget: " << this->FrameBudget << "\n";
+  os << indent << "NumberOfCoalescedEvents: "
+     << this->NumberOfCoalescedEvents << "\n";
+  os << indent << "FrameRate: " << this->FrameRate << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursorInteractorObserver::ResetStatistics()
+{
+  this->NumberOfCoalescedEvents = 0;
+  this->FrameRate = 0.0;
+  this->FrameCount = 0;
+  this->FrameRateStartTime = 0.0;
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursorInteractorObserver::FlushPendingMove()
+{
+  if (this->MovePending && this->ToolCursor)
+    {
+    this->MovePending = 0;
+    this->ToolCursor->MoveToDisplayPosition(
+      this->PendingPosition[0], this->PendingPosition[1]);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkToolCursorInteractorObserver::RenderFrame()
+{
+  vtkToolCursor *cursor = this->ToolCursor;
+  if (!cursor || !cursor->GetLatencyTiming())
+    {
+    this->FrameStartTime = 0.0;
+    this->Interactor->Render();
+    return;
+    }
+
+  double startTime = vtkTimerLog::GetUniversalTime();
+  if (this->FrameStartTime == 0.0)
+    {
+    this->FrameStartTime = startTime;
+    }
+
+  this->Interactor->Render();
+
+  double endTime = vtkTimerLog::GetUniversalTime();
+  double frameTime = endTime - this->FrameStartTime;
+  this->FrameStartTime = 0.0;
+
+  cursor->AddStageLatency(VTK_TOOL_STAGE_RENDER, endTime - startTime);
+  cursor->AddStageLatency(VTK_TOOL_STAGE_FRAME, frameTime);
+
+  if (this->FrameBudget > 0 && frameTime > this->FrameBudget)
+    {
+    this->InvokeEvent(
+      vtkToolCursorInteractorObserver::FrameBudgetExceededEvent,
+      &frameTime);
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -116,6 +190,7 @@ void vtkToolCursorInteractorObserver::SetEnabled(int enable)
     iren->AddObserver(vtkCommand::MiddleButtonReleaseEvent, command, priority);
     iren->AddObserver(vtkCommand::MouseWheelForwardEvent, command, priority);
     iren->AddObserver(vtkCommand::MouseWheelBackwardEvent, command, priority);
+    iren->AddObserver(vtkCommand::TimerEvent, command, priority);
 
     command = this->PassiveEventCallbackCommand;
     renwin->AddObserver(vtkCommand::StartEvent, command);
@@ -140,6 +215,18 @@ void vtkToolCursorInteractorObserver::SetEnabled(int enable)
     {
     this->Enabled = 0;
 
+    if (this->RenderTimerId >= 0)
+      {
+      iren->DestroyTimer(this->RenderTimerId);
+      this->RenderTimerId = -1;
+      }
+    if (this->PickTimerId >= 0)
+      {
+      iren->DestroyTimer(this->PickTimerId);
+      this->PickTimerId = -1;
+      }
+    this->FlushPendingMove();
+
     iren->RemoveObserver(this->EventCallbackCommand);
     iren->RemoveObserver(this->PassiveEventCallbackCommand);
     renwin->RemoveObserver(this->PassiveEventCallbackCommand);
@@ -170,9 +257,26 @@ void vtkToolCursorInteractorObserver::ProcessPassiveEvents(
       int x, y;
       iren->GetEventPosition(x, y);
       cursor->SetDisplayPosition(x, y);
+
+      self->LastRenderTime = vtkTimerLog::GetUniversalTime();
       }
     else if (event == vtkCommand::EndEvent)
       {
+      // Measure the frame rate over intervals of about one second
+      double t = vtkTimerLog::GetUniversalTime();
+      if (self->FrameCount == 0)
+        {
+        self->FrameRateStartTime = t;
+        }
+      self->FrameCount++;
+      if (t - self->FrameRateStartTime >= 1.0)
+        {
+        self->FrameRate = (self->FrameCount - 1)/
+          (t - self->FrameRateStartTime);
+        self->FrameCount = 1;
+        self->FrameRateStartTime = t;
+        }
+
       // At end of RenderWindow render, check whether cursor is visible.
       // Hide system cursor if 3D cursor is visible.
       if (cursor->GetVisibility())
@@ -183,6 +287,13 @@ void vtkToolCursorInteractorObserver::ProcessPassiveEvents(
         {
         renwin->ShowCursor();
         }
+
+      // Poll for the result of an asynchronous pick, so that the cursor
+      // is updated even if the mouse stops moving
+      if (cursor->GetAsynchronousPickPending() && self->PickTimerId < 0)
+        {
+        self->PickTimerId = iren->CreateRepeatingTimer(10);
+        }
       }
    }
 
@@ -295,7 +406,7 @@ void vtkToolCursorInteractorObserver::ProcessPassiveEvents(
 void vtkToolCursorInteractorObserver::ProcessEvents(vtkObject *object,
                                                        unsigned long event,
                                                        void *clientdata,
-                                                       void *)
+                                                       void *calldata)
 {
   vtkToolCursorInteractorObserver* self =
     reinterpret_cast<vtkToolCursorInteractorObserver *>(clientdata);
@@ -307,6 +418,53 @@ void vtkToolCursorInteractorObserver::ProcessEvents(vtkObject *object,
     return;
     }
 
+  // The timer that holds back mouse motion until the next frame
+  if (event == vtkCommand::TimerEvent)
+    {
+    int timerId = (calldata ? *static_cast<int *>(calldata) : -1);
+    if (timerId >= 0 && timerId == self->RenderTimerId)
+      {
+      // The frame budget has elapsed, render the latest motion
+      self->RenderTimerId = -1;
+      if (self->MovePending)
+        {
+        self->FrameStartTime = self->PendingMoveTime;
+        self->FlushPendingMove();
+        self->RenderFrame();
+        }
+      }
+    else if (timerId >= 0 && timerId == self->PickTimerId)
+      {
+      // Render when the asynchronous pick has a result for the cursor
+      if (cursor->GetAsynchronousPickCompleted())
+        {
+        self->RenderFrame();
+        }
+      if (!cursor->GetAsynchronousPickPending() &&
+          self->PickTimerId >= 0)
+        {
+        iren->DestroyTimer(self->PickTimerId);
+        self->PickTimerId = -1;
+        }
+      }
+    return;
+    }
+
+  // The frame begins when the cursor starts to handle the event, or
+  // when the first of the motion events that are being held back arrived
+  self->FrameStartTime = vtkTimerLog::GetUniversalTime();
+  if (self->MovePending)
+    {
+    self->FrameStartTime = self->PendingMoveTime;
+    }
+
+  // Any motion that is waiting for a render must be delivered before
+  // a button, wheel, or key event
+  if (event != vtkCommand::MouseMoveEvent)
+    {
+    self->FlushPendingMove();
+    }
+
   // Is it safe to grab the focus for the cursor?  Check to see if the
   // InteractorStyle is currently doing an action.
   vtkInteractorStyle *istyle =
@@ -319,9 +477,37 @@ void vtkToolCursorInteractorObserver::ProcessEvents(vtkObject *object,
     {
     case vtkCommand::MouseMoveEvent:
       {
-      int x, y;
-      iren->GetEventPosition(x, y);
-      cursor->MoveToDisplayPosition(x, y);
+      // Only the most recent motion is delivered to the cursor
+      if (self->MovePending)
+        {
+        self->NumberOfCoalescedEvents++;
+        }
+      else
+        {
+        self->PendingMoveTime = self->FrameStartTime;
+        }
+      self->MovePending = 1;
+      iren->GetEventPosition(self->PendingPosition);
+
+      // If the last render was too recent, then wait before rendering
+      if (self->FrameBudget > 0)
+        {
+        double remaining = (self->LastRenderTime + self->FrameBudget -
+                            vtkTimerLog::GetUniversalTime());
+        if (remaining > 0)
+          {
+          if (self->RenderTimerId < 0)
+            {
+            unsigned long duration =
+              static_cast<unsigned long>(remaining*1000.0) + 1;
+            self->RenderTimerId = iren->CreateOneShotTimer(duration);
+            }
+          self->FrameStartTime = 0.0;
+          return;
+          }
+        }
+
+      self->FlushPendingMove();
       }
       break;
 
@@ -451,7 +637,7 @@ void vtkToolCursorInteractorObserver::ProcessEvents(vtkObject *object,
 
     }
 
-  iren->Render();
+  self->RenderFrame();
 }
 
 //----------------------------------------------------------------------------
@@ -21,6 +21,7 @@
 #define __vtkToolCursorInteractorObserver_h
 
 #include "vtkInteractorObserver.h"
+#include "vtkCommand.h"
 
 class vtkToolCursor;
 
@@ -47,6 +48,39 @@ public:
   void SetToolCursor(vtkToolCursor *cursor);
   vtkToolCursor *GetToolCursor() { return this->ToolCursor; };
 
+  // Description:
+  // Set the minimum time, in seconds, between renders that are caused
+  // by mouse motion.  Motion events that arrive sooner are merged, and
+  // only the most recent position is given to the cursor when the next
+  // render is done.  Button, wheel, and key events are never merged, and
+  // any pending motion is delivered before them.  The default is 1/60,
+  // and a value of zero causes a render after every event.
+  vtkSetMacro(FrameBudget, double);
+  vtkGetMacro(FrameBudget, double);
+
+  // Description:
+  // This event is invoked after a render if the time since the event
+  // that caused the render was longer than the FrameBudget.  If motion
+  // events were merged, the time is measured from the first of them.
+  // The call data is a pointer to the frame time, as a double, in
+  // seconds.  The frame and render times are only measured when the
+  // LatencyTiming of the vtkToolCursor is On, and are added to its
+  // latency statistics as VTK_TOOL_STAGE_FRAME and VTK_TOOL_STAGE_RENDER.
+  enum { FrameBudgetExceededEvent = vtkCommand::UserEvent + 100 };
+
+  // Description:
+  // Get the number of motion events that were merged with later events.
+  vtkGetMacro(NumberOfCoalescedEvents, int);
+
+  // Description:
+  // Get the number of frames per second that the render window has
+  // achieved, measured over the most recent interval of about a second.
+  vtkGetMacro(FrameRate, double);
+
+  // Description:
+  // Reset the coalesced event count and the frame rate.
+  void ResetStatistics();
+
   // Description:
   // Get vtkToolCursor "modifier" bits from a VTK keysym.
   static int ModifierFromKeySym(const char *keysym);
@@ -69,6 +103,29 @@ protected:
 
   vtkToolCursor *ToolCursor;
 
+  double FrameBudget;
+  int RenderTimerId;
+  int PickTimerId;
+  int MovePending;
+  int PendingPosition[2];
+  double PendingMoveTime;
+  double LastRenderTime;
+  int NumberOfCoalescedEvents;
+  double FrameRate;
+  int FrameCount;
+  double FrameRateStartTime;
+  double FrameStartTime;
+
+  // Description:
+  // Give the most recent mouse motion to the cursor, if it has not
+  // already been given.
+  void FlushPendingMove();
+
+  // Description:
+  // Render, and record the render time and the time since the frame
+  // began if the cursor is timing its stages.
+  void RenderFrame();
+
 private:
   vtkToolCursorInteractorObserver(const vtkToolCursorInteractorObserver&);  //Not implemented
   void operator=(const vtkToolCursorInteractorObserver&);  //Not implemented